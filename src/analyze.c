@@ -0,0 +1,355 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	analyze.c
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	Batch analysis of positions.  Reads a stream of positions, one
+//		per line in the format of position.h, and for each writes out
+//	one line giving the move the computer would make, the time it took to
+//	decide upon it, and the set of candidate moves that remained after
+//	each of its rules:
+//
+//		<move> <usecs> <RULE>=<square>,<square>,... <RULE>=- ...
+//
+//	Positions are evaluated in parallel, but results are always written in
+//	the same order as the positions were read.  A position that can't be
+//	evaluated gets a line starting with "ERR" instead.
+//
+//	The move chosen from among equally good candidates depends upon the
+//	seed (-s) and the line number, so that the output is repeatable.  Given
+//	a shard (-k, see tally.h), only every n'th line is evaluated, each just
+//	as it would have been without, and only those lines are written.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#define	_POSIX_C_SOURCE	200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include "gboard.h"
+#include "comboset.h"
+#include "strategy.h"
+#include "position.h"
+#include "latency.h"
+#include "rulepool.h"
+#include "tally.h"
+
+// Positions are read, evaluated, and written in batches of this many
+#define	AN_BATCH	1024
+// Room for any one line: a position, with room to spare for trailing spaces
+// or a carriage return
+#define	AN_MAXLINE	(POS_STRLEN + 64)
+// Room for the output of any one position: every rule, listing every square
+#define	AN_MAXOUT	(64 + MAX_RULES * (16 + 4 * NUM_SQUARES))
+
+typedef	struct	ANALYZE_S {
+	int		m_difficulty, m_nlines;
+	unsigned	m_seed;
+	// The number of our lines before this batch.  Our shard holds every
+	// m_nshards'th line of the input, from m_shard on.
+	unsigned long	m_lineno;
+	int		m_shard, m_nshards;
+	bool		m_rules;
+	// The next line of the batch to be evaluated, protected by m_lock
+	int		m_next;
+	pthread_mutex_t	m_lock;
+	char		(*m_in)[AN_MAXLINE];
+	char		**m_out;
+	// The time taken by every position, if asked for, protected by m_lock
+	LPLATTABLE	m_lat;
+	// The pool to spread each position's rules across, if any
+	LPRULEPOOL	m_pool;
+} ANALYZE, *LPANALYZE;
+
+// The watcher's state: where to write the candidate set following each rule
+typedef	struct	ANWATCH_S {
+	char	*m_ptr;
+} ANWATCH;
+
+static void
+watch_rules(void *arg, const RULE *rule, LPVSET result, LPVSET spots) {
+	ANWATCH	*w = (ANWATCH *)arg;
+	int	i;
+	bool	first = true;
+
+	w->m_ptr += sprintf(w->m_ptr, " %s=", rule->m_name);
+	for(i=0; i<NUM_SQUARES; i++) {
+		if (!vs_isable(spots, i))
+			continue;
+		w->m_ptr += sprintf(w->m_ptr, (first) ? "%d" : ",%d", i);
+		first = false;
+	} if (first)
+		*w->m_ptr++ = '-';
+	*w->m_ptr = '\0';
+}
+
+/*
+ * analyze
+ *
+ * Evaluate one position, writing our results into out.
+ */
+static void
+analyze(LPANALYZE a, LPSTRATEGY s, const char *line, unsigned long lineno,
+		char *out) {
+	GBOARD		brd;
+	COMBOSET	cs;
+	VSET		spots;
+	ANWATCH		w;
+	struct timespec	start, stop;
+	GB_PIECE	who;
+	int		mv;
+	double		usecs;
+
+	if (!pos_parse(line, &brd, &cs)) {
+		strcpy(out, "ERR invalid position");
+		return;
+	}
+
+	who = whoseturn(&brd);
+	if (who == GB_NOONE) {
+		strcpy(out, "ERR game over");
+		return;
+	}
+
+	// First, time the computer's decision by itself
+	set_watch(s, NULL, NULL);
+	set_seed(s, a->m_seed + (unsigned)lineno);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	choosemoves(s, &brd, &cs, who, &spots);
+	mv = vs_pickmember(&spots, &s->m_seed);
+	clock_gettime(CLOCK_MONOTONIC, &stop);
+
+	usecs = (stop.tv_sec - start.tv_sec) * 1e6
+		+ (stop.tv_nsec - start.tv_nsec) / 1e3;
+	if (a->m_lat) {
+		pthread_mutex_lock(&a->m_lock);
+		lat_trecord(a->m_lat, a->m_difficulty, brd.m_nfilled,
+			(uint64_t)(usecs * 1e3));
+		pthread_mutex_unlock(&a->m_lock);
+	}
+	w.m_ptr = out + sprintf(out, "%d %.1f", mv, usecs);
+
+	// Then, if requested, go back over it to see what each rule did
+	if (a->m_rules) {
+		set_watch(s, watch_rules, &w);
+		choosemoves(s, &brd, &cs, who, &spots);
+	}
+}
+
+static void *
+analyze_thread(void *arg) {
+	LPANALYZE	a = (LPANALYZE)arg;
+	STRATEGY	s;
+	int		k;
+
+	set_difficulty(&s, a->m_difficulty);
+	if (a->m_pool)
+		rp_attach(&s, a->m_pool);
+
+	for(;;) {
+		pthread_mutex_lock(&a->m_lock);
+		k = a->m_next++;
+		pthread_mutex_unlock(&a->m_lock);
+
+		if (k >= a->m_nlines)
+			break;
+		analyze(a, &s, a->m_in[k],
+			(a->m_lineno + k) * a->m_nshards + a->m_shard,
+			a->m_out[k]);
+	}
+
+	return NULL;
+}
+
+static void
+usage(void) {
+	fprintf(stderr,
+"USAGE: tttt-analyze [-d <level>] [-j <nthreads>] [-p <nthreads>] [-s <seed>]\n"
+"\t\t[-q] [-l] [-k <i>/<n>] [-o <tally-file>] [<file>]\n"
+"\n"
+"\tReads positions from <file>, or from stdin if no file is given\n"
+"\n"
+"\t-d <level>\tThe difficulty level to play at, defaults to 1000\n"
+"\t-j <nthreads>\tThe number of threads to use, defaults to the number\n"
+"\t\tof CPUs\n"
+"\t-p <nthreads>\tSpread the longer rules of each position across this\n"
+"\t\tmany more threads.  Best with -j1, to see how fast one position\n"
+"\t\tcan be answered\n"
+"\t-s <seed>\tThe seed used to pick between equal moves, defaults to 0\n"
+"\t-q\t\tQuiet: don't list the candidate moves following each rule\n"
+"\t-l\t\tOnce done, report percentiles of the time taken, by the\n"
+"\t\tnumber of squares filled\n"
+"\t-k <i>/<n>\tEvaluate only shard i of n, counting from zero: every n'th\n"
+"\t\tline, starting with line i.  Every shard must be given the same\n"
+"\t\tinput, and the same -d and -s\n"
+"\t-o <file>\tWrite our counts (and times, with -l) into <file>, for\n"
+"\t\ttttt-merge to add up\n");
+}
+
+int	main(int argc, char **argv) {
+	ANALYZE		a;
+	TALLY		t;
+	FILE		*fp = stdin;
+	pthread_t	*threads;
+	const char	*tallyfile = NULL;
+	unsigned long	nread = 0;
+	int		nthreads = 0, npool = 0, opt, i, k;
+	bool		eof = false;
+
+	memset(&a, 0, sizeof(a));
+	a.m_difficulty = 1000;
+	a.m_rules = true;
+	a.m_nshards = 1;
+	while((opt = getopt(argc, argv, "d:hj:k:lo:p:qs:")) != -1) {
+		switch(opt) {
+		case 'd': a.m_difficulty = atoi(optarg); break;
+		case 'j': nthreads = atoi(optarg); break;
+		case 'k':
+			if (!tl_parseshard(optarg, &a.m_shard, &a.m_nshards)) {
+				fprintf(stderr, "ERR: Invalid shard, %s\n",
+					optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'l':
+			a.m_lat = (LPLATTABLE)malloc(sizeof(LATTABLE));
+			if (!a.m_lat) {
+				fprintf(stderr, "ERR: Out of memory\n");
+				exit(EXIT_FAILURE);
+			}
+			lat_tclear(a.m_lat);
+			break;
+		case 'o': tallyfile = optarg; break;
+		case 'p': npool = atoi(optarg); break;
+		case 'q': a.m_rules = false; break;
+		case 's': a.m_seed = strtoul(optarg, NULL, 0); break;
+		default:
+			usage();
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (optind+1 == argc) {
+		fp = fopen(argv[optind], "r");
+		if (!fp) {
+			perror("O/S Err: Cannot open position file");
+			exit(EXIT_FAILURE);
+		}
+	} else if (optind != argc) {
+		usage();
+		exit(EXIT_FAILURE);
+	}
+
+	if (nthreads <= 0)
+		nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (nthreads <= 0)
+		nthreads = 1;
+
+	if (npool > 0) {
+		a.m_pool = rp_new(npool);
+		if (!a.m_pool) {
+			perror("O/S Err: Cannot start rule pool");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	a.m_in  = malloc(AN_BATCH * sizeof(*a.m_in));
+	a.m_out = (char **)malloc(AN_BATCH * sizeof(char *));
+	threads = (pthread_t *)malloc(nthreads * sizeof(pthread_t));
+	if ((!a.m_in)||(!a.m_out)||(!threads)) {
+		fprintf(stderr, "ERR: Out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+	for(k=0; k<AN_BATCH; k++) {
+		a.m_out[k] = (char *)malloc(AN_MAXOUT);
+		if (!a.m_out[k]) {
+			fprintf(stderr, "ERR: Out of memory\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	pthread_mutex_init(&a.m_lock, NULL);
+
+	tl_clear(&t, TL_ANALYZE, a.m_shard, a.m_nshards);
+	t.m_difficulty[0] = a.m_difficulty;
+	t.m_seed = a.m_seed;
+	t.m_lat  = a.m_lat;
+
+	while(!eof) {
+		for(a.m_nlines = 0; a.m_nlines < AN_BATCH; ) {
+			if (!fgets(a.m_in[a.m_nlines], AN_MAXLINE, fp)) {
+				eof = true;
+				break;
+			}
+			if (tl_inshard(nread++, a.m_shard, a.m_nshards))
+				a.m_nlines++;
+		}
+
+		if (a.m_nlines == 0)
+			break;
+
+		a.m_next = 0;
+		for(i=0; i<nthreads; i++)
+			pthread_create(&threads[i], NULL, analyze_thread, &a);
+		for(i=0; i<nthreads; i++)
+			pthread_join(threads[i], NULL);
+
+		for(k=0; k<a.m_nlines; k++) {
+			printf("%s\n", a.m_out[k]);
+			if (strncmp(a.m_out[k], "ERR", 3) == 0)
+				t.m_errors++;
+		}
+		t.m_count  += a.m_nlines;
+		a.m_lineno += a.m_nlines;
+	}
+
+	if (fp != stdin)
+		fclose(fp);
+	rp_free(a.m_pool);
+	t.m_total = nread;
+	if ((tallyfile)&&(!tl_write(tallyfile, &t))) {
+		perror("O/S Err: Cannot write tally file");
+		exit(EXIT_FAILURE);
+	}
+	if (a.m_lat) {
+		printf("\n");
+		lat_print(a.m_lat);
+		free(a.m_lat);
+	}
+	for(k=0; k<AN_BATCH; k++)
+		free(a.m_out[k]);
+	free(a.m_out);
+	free(a.m_in);
+	free(threads);
+	return EXIT_SUCCESS;
+}
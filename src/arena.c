@@ -0,0 +1,339 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	arena.c
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	The arena: plays the computer against itself, many times over,
+//		in order to measure how well one difficulty level (or rule set)
+//	fares against another.  Games are spread across a number of threads, and
+//	may be recorded (in the format of record.h) for later analysis.
+//
+//	Every game is started from its own seed, the arena seed plus the game
+//	number, so the same arena seed always produces the same set of games,
+//	no matter how many threads play them--or how many processes, each
+//	playing one shard of them (see tally.h).
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#define	_POSIX_C_SOURCE	200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include "gboard.h"
+#include "strategy.h"
+#include "record.h"
+#include "selfplay.h"
+#include "trace.h"
+#include "latency.h"
+#include "tally.h"
+
+// Games are played in batches of this many at a time, so that they may be
+// written to the record file in order
+#define	AR_BATCH	4096
+
+typedef	struct	ARENA_S {
+	int		m_difficulty[2];
+	unsigned	m_seed;
+	unsigned long	m_first, m_ngames;
+	// Which of the games are ours: every m_nshards'th, from m_shard on
+	int		m_shard, m_nshards;
+	// The game within the batch to be played next, protected by m_lock
+	unsigned long	m_next;
+	pthread_mutex_t	m_lock;
+	LPGAMEREC	m_games;
+	// Where to save the decision trace of every thread, if anywhere, and
+	// the number of traces saved so far, also protected by m_lock
+	FILE		*m_trace;
+	unsigned	m_ntraces;
+	bool		m_traceerr;
+	// The time taken by every move, by level and fill, if asked for, also
+	// protected by m_lock
+	LPLATTABLE	m_lat;
+} ARENA, *LPARENA;
+
+/*
+ * arena_game
+ *
+ * Play game number gameno of the arena.  Black and white each get their own
+ * random seed, both derived from the game's seed.
+ */
+static void
+arena_game(LPARENA a, unsigned long gameno, LPGAMEREC rec, LPLATTABLE lat) {
+	STRATEGY	black, white;
+	unsigned	seed = a->m_seed + (unsigned)gameno;
+
+	set_difficulty(&black, a->m_difficulty[0]);
+	set_difficulty(&white, a->m_difficulty[1]);
+	set_seed(&black, seed);
+	set_seed(&white, ~seed);
+
+	rec->m_seed = seed;
+	rec->m_difficulty[0] = a->m_difficulty[0];
+	rec->m_difficulty[1] = a->m_difficulty[1];
+	selfplay_timed(&black, &white, rec, lat);
+}
+
+/*
+ * arena_trace
+ *
+ * Save the decision trace of the calling thread into the trace file, as a
+ * block of its own.
+ */
+static void
+arena_trace(LPARENA a) {
+	LPTRACE_EVENT	events;
+	unsigned char	buf[TRACE_BLKHDRSIZE + TRACE_EVENTSIZE];
+	unsigned	k, n;
+
+	events = (LPTRACE_EVENT)malloc(TRACE_SIZE * sizeof(TRACE_EVENT));
+	if (!events) {
+		a->m_traceerr = true;
+		return;
+	}
+	n = trace_read(events, TRACE_SIZE);
+
+	pthread_mutex_lock(&a->m_lock);
+	trace_block(buf, a->m_ntraces++, n);
+	if (fwrite(buf, 1, TRACE_BLKHDRSIZE, a->m_trace) != TRACE_BLKHDRSIZE)
+		a->m_traceerr = true;
+	for(k=0; k<n; k++) {
+		trace_encode(&events[k], buf);
+		if (fwrite(buf, 1, TRACE_EVENTSIZE, a->m_trace)
+				!= TRACE_EVENTSIZE)
+			a->m_traceerr = true;
+	}
+	pthread_mutex_unlock(&a->m_lock);
+
+	free(events);
+}
+
+static void *
+arena_thread(void *arg) {
+	LPARENA		a = (LPARENA)arg;
+	LPLATTABLE	lat = NULL;
+	unsigned long	k;
+
+	// Each thread times its own moves, adding them to the arena's once
+	// it's done
+	if (a->m_lat) {
+		lat = (LPLATTABLE)malloc(sizeof(LATTABLE));
+		if (lat)
+			lat_tclear(lat);
+	}
+
+	for(;;) {
+		pthread_mutex_lock(&a->m_lock);
+		k = a->m_next++;
+		pthread_mutex_unlock(&a->m_lock);
+
+		if (k >= a->m_ngames)
+			break;
+		arena_game(a, (a->m_first + k) * a->m_nshards + a->m_shard,
+			&a->m_games[k], lat);
+	}
+
+	if (lat) {
+		pthread_mutex_lock(&a->m_lock);
+		lat_tmerge(a->m_lat, lat);
+		pthread_mutex_unlock(&a->m_lock);
+		free(lat);
+	}
+
+	if (a->m_trace)
+		arena_trace(a);
+	return NULL;
+}
+
+static void
+usage(void) {
+	fprintf(stderr,
+"USAGE: tttt-arena [-n <ngames>] [-b <level>] [-w <level>] [-s <seed>]\n"
+"\t\t[-j <nthreads>] [-r <record-file>] [-t <trace-file>] [-l]\n"
+"\t\t[-k <i>/<n>] [-o <tally-file>]\n"
+"\n"
+"\t-n <ngames>\tThe number of games to play, defaults to 1000\n"
+"\t-b <level>\tThe difficulty level black plays at, defaults to 1000\n"
+"\t-w <level>\tThe difficulty level white plays at, defaults to 1000\n"
+"\t-s <seed>\tThe seed of the first game.  Defaults to the time\n"
+"\t-j <nthreads>\tThe number of threads to play with, defaults to the\n"
+"\t\tnumber of CPUs\n"
+"\t-r <file>\tRecord every game into <file>\n"
+"\t-l\t\tReport percentiles of the time taken by each move, by level\n"
+"\t\tand by the number of squares filled\n"
+"\t-t <file>\tSave the decision trace of every thread into <file>, for\n"
+"\t\ttttt-tracedump.  This needs a build with tracing (make TRACE=1)\n"
+"\t-k <i>/<n>\tPlay only shard i of n, counting from zero: every n'th game,\n"
+"\t\tstarting with game i.  Every shard must be given the same -n and -s\n"
+"\t-o <file>\tWrite our results into <file>, for tttt-merge to add up\n");
+}
+
+int	main(int argc, char **argv) {
+	ARENA		a;
+	TALLY		t;
+	unsigned long	ngames = 1000, nours, gameno, k;
+	int		nthreads = 0, opt, i;
+	bool		latency = false;
+	const char	*recfile = NULL, *tracefile = NULL, *tallyfile = NULL;
+	LPRECWRITER	rw = NULL;
+	pthread_t	*threads;
+
+	a.m_difficulty[0] = a.m_difficulty[1] = 1000;
+	a.m_seed = (unsigned)time(NULL);
+	a.m_shard = 0;
+	a.m_nshards = 1;
+	while((opt = getopt(argc, argv, "b:hj:k:ln:o:r:s:t:w:")) != -1) {
+		switch(opt) {
+		case 'b': a.m_difficulty[0] = atoi(optarg); break;
+		case 'j': nthreads = atoi(optarg); break;
+		case 'k':
+			if (!tl_parseshard(optarg, &a.m_shard, &a.m_nshards)) {
+				fprintf(stderr, "ERR: Invalid shard, %s\n",
+					optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'l': latency = true; break;
+		case 'n': ngames = strtoul(optarg, NULL, 0); break;
+		case 'o': tallyfile = optarg; break;
+		case 'r': recfile = optarg; break;
+		case 's': a.m_seed = strtoul(optarg, NULL, 0); break;
+		case 't': tracefile = optarg; break;
+		case 'w': a.m_difficulty[1] = atoi(optarg); break;
+		default:
+			usage();
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (nthreads <= 0)
+		nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (nthreads <= 0)
+		nthreads = 1;
+
+	if (recfile) {
+		rw = rec_open(recfile);
+		if (!rw) {
+			perror("O/S Err: Cannot create record file");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	a.m_trace = NULL;
+	a.m_ntraces = 0;
+	a.m_traceerr = false;
+	if (tracefile) {
+		unsigned char	hdr[TRACE_HEADERSIZE];
+
+		if (!TRACE_ENABLED) {
+			fprintf(stderr,
+				"ERR: Built without tracing--make TRACE=1\n");
+			exit(EXIT_FAILURE);
+		}
+		a.m_trace = fopen(tracefile, "wb");
+		if (!a.m_trace) {
+			perror("O/S Err: Cannot create trace file");
+			exit(EXIT_FAILURE);
+		}
+		trace_header(hdr);
+		if (fwrite(hdr, 1, TRACE_HEADERSIZE, a.m_trace)
+				!= TRACE_HEADERSIZE)
+			a.m_traceerr = true;
+	}
+
+	a.m_games = (LPGAMEREC)malloc(AR_BATCH * sizeof(GAMEREC));
+	threads = (pthread_t *)malloc(nthreads * sizeof(pthread_t));
+	a.m_lat = (latency) ? (LPLATTABLE)malloc(sizeof(LATTABLE)) : NULL;
+	if ((!a.m_games)||(!threads)||((latency)&&(!a.m_lat))) {
+		fprintf(stderr, "ERR: Out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+	pthread_mutex_init(&a.m_lock, NULL);
+	if (a.m_lat)
+		lat_tclear(a.m_lat);
+
+	tl_clear(&t, TL_ARENA, a.m_shard, a.m_nshards);
+	t.m_difficulty[0] = a.m_difficulty[0];
+	t.m_difficulty[1] = a.m_difficulty[1];
+	t.m_seed  = a.m_seed;
+	t.m_total = ngames;
+	t.m_lat   = a.m_lat;
+
+	// The number of games in our shard.  gameno counts only those.
+	nours = (ngames > (unsigned long)a.m_shard)
+		? (ngames - a.m_shard + a.m_nshards - 1) / a.m_nshards : 0;
+	for(gameno = 0; gameno < nours; gameno += a.m_ngames) {
+		a.m_first  = gameno;
+		a.m_ngames = nours - gameno;
+		if (a.m_ngames > AR_BATCH)
+			a.m_ngames = AR_BATCH;
+		a.m_next   = 0;
+
+		for(i=0; i<nthreads; i++)
+			pthread_create(&threads[i], NULL, arena_thread, &a);
+		for(i=0; i<nthreads; i++)
+			pthread_join(threads[i], NULL);
+
+		for(k=0; k<a.m_ngames; k++) {
+			t.m_count++;
+			t.m_wins[a.m_games[k].m_result]++;
+			t.m_nmoves += a.m_games[k].m_nmoves;
+			if ((rw)&&(!rec_write(rw, &a.m_games[k]))) {
+				perror("O/S Err: Cannot write record file");
+				exit(EXIT_FAILURE);
+			}
+		}
+	}
+
+	if ((rw)&&(!rec_close(rw))) {
+		perror("O/S Err: Cannot write record file");
+		exit(EXIT_FAILURE);
+	}
+
+	if ((a.m_trace)&&((fclose(a.m_trace) != 0)||(a.m_traceerr))) {
+		perror("O/S Err: Cannot write trace file");
+		exit(EXIT_FAILURE);
+	}
+
+	if ((tallyfile)&&(!tl_write(tallyfile, &t))) {
+		perror("O/S Err: Cannot write tally file");
+		exit(EXIT_FAILURE);
+	}
+
+	tl_print(&t);
+
+	free(a.m_lat);
+
+	free(threads);
+	free(a.m_games);
+	return EXIT_SUCCESS;
+}
@@ -43,7 +43,6 @@
 ////////////////////////////////////////////////////////////////////////////////
 //
 //
-#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "comborow.h"
@@ -67,8 +66,8 @@ void	cr_refresh(LPCOMBOROW cr) {
 
 	// Resort the spots, smaller number first.
 	// While this isn't the fastest sort, we're only looking at a cost
-	// of about six compares--in spite of what this looks like, so it's
-	// not that bad.
+	// of about six compares on the classic board--in spite of what this
+	// looks like, so it's not that bad.
 	for(i=0; i<NUM_ON_SIDE-1; i++) {
 		for(j=i+1; j<NUM_ON_SIDE; j++) {
 			if (cr->m_spots[i] > cr->m_spots[j]) {
@@ -83,13 +82,13 @@ void	cr_refresh(LPCOMBOROW cr) {
 /*
  * cr_init
  *
- * Initialize a combo-row to have the four positions given.
+ * Initialize a combo-row to have the positions given.
  */
-void	cr_init(LPCOMBOROW cr, int one, int two, int three, int four) {
-	cr->m_spots[0] = one;
-	cr->m_spots[1] = two;
-	cr->m_spots[2] = three;
-	cr->m_spots[3] = four;
+void	cr_init(LPCOMBOROW cr, const int *spots) {
+	int	i;
+
+	for(i=0; i<NUM_ON_SIDE; i++)
+		cr->m_spots[i] = spots[i];
 	cr_refresh(cr);
 }
 
@@ -102,7 +101,7 @@ bool	cr_register(LPCOMBOROW cr, GB_PIECE who, int where) {
 	if (!cr->m_interesting)
 		return false;
 
-	int	nc = 4-cr->m_nfilled, i;
+	int	nc = NUM_ON_SIDE-cr->m_nfilled, i;
 
 	// Look through al of our spots to ask whether or not where is relevant
 	// to us.
@@ -117,12 +116,12 @@ bool	cr_register(LPCOMBOROW cr, GB_PIECE who, int where) {
 			// it has now been filled.  Other things working with
 			// this position will then no longer search through
 			// positions that have been filled.
-			if (i != 4-cr->m_nfilled) {
+			if (i != NUM_ON_SIDE-cr->m_nfilled) {
 				// We don't need to do a proper 3-part copy,
 				// since cr->m_spots[i] is already equal to
 				// where
-				cr->m_spots[i] = cr->m_spots[4-cr->m_nfilled];
-				cr->m_spots[4-cr->m_nfilled] = where;
+				cr->m_spots[i] = cr->m_spots[NUM_ON_SIDE-cr->m_nfilled];
+				cr->m_spots[NUM_ON_SIDE-cr->m_nfilled] = where;
 			}
 
 			// If we are already owned by this player,
@@ -188,8 +187,8 @@ bool	cr_isects(LPCOMBOROW cr, LPCOMBOROW br) {
 
 	if ((!cr->m_interesting)||(!br->m_interesting))
 		return false;
-	for(i=0; i<4-cr->m_nfilled; i++) {
-		for(j=0; j<4-br->m_nfilled; j++)
+	for(i=0; i<NUM_ON_SIDE-cr->m_nfilled; i++) {
+		for(j=0; j<NUM_ON_SIDE-br->m_nfilled; j++)
 			if (cr->m_spots[i]==br->m_spots[j])
 				return true;
 	} return false;
@@ -206,26 +205,3 @@ bool	cr_isownedby(LPCOMBOROW cr, GB_PIECE who) {
 		return true;
 	return false;
 }
-
-/*
- * cr_debug
- *
- * DUMP the relavent parts of the comborow structure to the screen.  Other
- * constraints applied, and we are restricted to one line here.
- */
-void	cr_debug(LPCOMBOROW cr) {
-	int	i, unfilled = NUM_ON_SIDE - cr->m_nfilled;
-
-	for(i=0; i< unfilled; i++)
-		printf(" %2d  ", cr->m_spots[i]);
-	for(i= unfilled; i<NUM_ON_SIDE; i++)
-		printf("(%2d) ", cr->m_spots[i]);
-	if (!cr->m_interesting)
-		printf("  Not interesting\r\n");
-	else if (cr->m_owner == GB_WHITE)
-		printf("  Owned by O\r\n");
-	else if (cr->m_owner == GB_BLACK)
-		printf("  Owned by X\r\n");
-	else	printf("\r\n");
-}
-
@@ -43,28 +43,45 @@
 
 #include "gboard.h"
 
+// Line numbers need more than eight bits on the larger boards
+#if	NUM_COMBOROWS > 256
+typedef	unsigned short	CR_ID;
+#else
+typedef	unsigned char	CR_ID;
+#endif
+
+#ifdef	TTTT_SMALL
+typedef	unsigned char	CR_FLAG;
+#else
+typedef	bool		CR_FLAG;
+#endif
+
 typedef	struct COMBOROW_S {
 	// The "owner" of a COMBOROW is the one individual who has chips
 	// in part of the row.  If Black has some in the row, it will be owned
 	// by black.  The exception is if both black and white have pieces in
 	// the row.  Then it is owned by NOONE and no longer interesting.
-	GB_PIECE	m_owner;
+	GB_BYTE		m_owner;
 	// The number of filled spots within the row
-	int		m_nfilled;
+	GB_BYTE		m_nfilled;
 	// A row is interesting if a win may still be made within it.  Otherwise
-	// it is uninteresting.
-	bool		m_interesting;
+	// it is uninteresting.  (This is a bool, save in the small build.)
+	CR_FLAG		m_interesting;
+	// Which line this is, as numbered within the generated tables of
+	// comboset.h.  Unlike a row's place within its COMBOSET, this never
+	// changes.
+	CR_ID		m_id;
 	// The m_spots array contains a list of the locations of the four parts
 	// of the row.  As items are filled, unfilled items are brought to the
-	// front of the array, so the first 4-m_nfilled entries are always
-	// unfilled.
-	int		m_spots[NUM_ON_SIDE];	// The 4 values in the row
+	// front of the array, so the first NUM_ON_SIDE-m_nfilled entries are
+	// always unfilled.
+	GB_BYTE		m_spots[NUM_ON_SIDE];	// The values in the row
 } COMBOROW, *LPCOMBOROW;
 
 // Operations on comborows:
 //
-// Initialize a row
-void	cr_init(LPCOMBOROW cr, int one, int two, int three, int four);
+// Initialize a row, from the NUM_ON_SIDE squares given
+void	cr_init(LPCOMBOROW cr, const int *spots);
 // Refreshing a row--sorting its m_spots, clearing the owner and the number
 // filled, and setting the interesting flag back to true.
 void	cr_refresh(LPCOMBOROW cr);
@@ -78,7 +95,8 @@ bool	cr_isects(LPCOMBOROW cr, LPCOMBOROW br);
 // Does "who" "own" this row?  That is, does he have pieces in the row, and
 // is it such that his opponent does not?
 bool	cr_isownedby(LPCOMBOROW cr, GB_PIECE who);
-// Dump the contents to stdout for the purpose of debugging them
+// Dump the contents to stdout for the purpose of debugging them.  This is
+// found in display.c, since the core engine doesn't use stdio.
 void	cr_debug(LPCOMBOROW cr);
 
 
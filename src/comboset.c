@@ -37,9 +37,7 @@
 ////////////////////////////////////////////////////////////////////////////////
 //
 //
-#include <stdio.h>
 #include <string.h>
-#include <assert.h>
 
 #include "comboset.h"
 
@@ -47,8 +45,9 @@
  * cs_init
  *
  * Initialize the comboset.  This means setting all of the various combo-rows
- * to reference all of the possible way to win within a 4x4x4 tic-tac-toe game.
- * These aren't necessarily intuitive, so ... we do the best we can.
+ * to reference all of the possible ways to win on the board.
+ * Those ways are worked out at build time, by mkwins, into cs_initial, so all
+ * that's left for us to do is to copy it.
  *
  * In a C++ context, this would be the constructor function.  However, in this
  * context, we allow for cs_init() to be called multiple times, where each time
@@ -56,126 +55,350 @@
  * malloc() ...).
  */
 void	cs_init(LPCOMBOSET cs) {
-	cs->m_ninplay   = NUM_COMBOROWS;
-	cs->m_winningid = -1;
-
-	int	idx, i;
-
-	idx = 0;
-
-	// Our three types of sixteen
-	for(i=0; i<16; i++)
-		cr_init(&cs->m_data[idx++], i*4, i*4+1, i*4+2, i*4+3);
-	for(i=0; i<16; i++)
-		cr_init(&cs->m_data[idx++],
-			(i&3)+(i&12)*4,
-			(i&3)+(i&12)*4+4,
-			(i&3)+(i&12)*4+8,
-			(i&3)+(i&12)*4+12);
-	for(i=0; i<16; i++)
-		cr_init(&cs->m_data[idx++], i, i+16, i+32, i+48);
-
-	// Our six types of four
-	for(i=0; i<4; i++)
-		cr_init(&cs->m_data[idx++], i*16, i*16+5, i*16+10, i*16+15);
-	for(i=0; i<4; i++)
-		cr_init(&cs->m_data[idx++], i*16+3, i*16+6, i*16+9, i*16+12);
-	for(i=0; i<4; i++)
-		cr_init(&cs->m_data[idx++], i, i+20, i+40, i+60);
-	for(i=0; i<4; i++)
-		cr_init(&cs->m_data[idx++], i+12, i+24, i+36, i+48);
-	for(i=0; i<4; i++)
-		cr_init(&cs->m_data[idx++], i*4, i*4+16+1, i*4+32+2, i*4+48+3);
-	for(i=0; i<4; i++)
-		cr_init(&cs->m_data[idx++], i*4+3, i*4+16+2, i*4+32+1, i*4+48);
-
-	// The last of the fours: the four diagonal, diagonals.
-	cr_init(&cs->m_data[idx++],  0,    16+4+1,    32+8+2,     48+12+3);
-	cr_init(&cs->m_data[idx++],  3,  3+16+4-1,  3+32+8-2,  3+ 48+12-3);
-	cr_init(&cs->m_data[idx++], 12, 12+16-4+1, 12+32-8+2, 12+ 48-12+3);
-	cr_init(&cs->m_data[idx++], 15, 15+16-4-1, 15+32-8-2, 15+ 48-12-3);
-
-	// At this point, our index should exactly equal the number of combo-
-	// rows we have allocated.  Any difference here is an error.  The
-	// assert is commented out, since we've already verified this is so.
-	//
-	// assert(idx == NUM_COMBOROWS);
+	memcpy(cs, &cs_initial, sizeof(COMBOSET));
 }
 
 /*
- * cs_swap
+ * cs_isopen
  *
- * Swaps the data between two combo-rows.  Note that we use memcpy to do this.
+ * Only the first NUM_ON_SIDE-m_nfilled squares of a line are open.
  */
+bool	cs_isopen(LPCOMBOSET cs, int id, int where) {
+	int	i;
+
+	for(i=0; i<NUM_ON_SIDE-cs->m_nfilled[id]; i++)
+		if (cs->m_spots[id][i] == where)
+			return true;
+	return false;
+}
+
+/*
+ * cs_isects
+ *
+ * A line crosses itself everywhere, so it intersects itself as long as any
+ * of it is open.
+ */
+bool	cs_isects(LPCOMBOSET cs, int a, int b) {
+	int	sq;
+
+	if ((!cs_inplay(cs, a))||(!cs_inplay(cs, b)))
+		return false;
+	if (a == b)
+		return (cs->m_nfilled[a] < NUM_ON_SIDE);
+
+	sq = cs_crossing[a][b];
+	if (sq < 0)
+		return false;
+
+	// Since both lines see every move, the square is either open in both,
+	// or filled in both.  We need only check one.
+	return cs_isopen(cs, a, sq);
+}
+
+/*
+ * cs_retire
+ *
+ * Swap the line with the last one still in play, and then count one less in
+ * play.  Only the ids move--never the lines themselves.
+ */
+void	cs_retire(LPCOMBOSET cs, int id) {
+	int	slot = cs->m_slot[id], last = cs->m_ninplay-1,
+		other = cs->m_inplay[last];
+
+	if (slot > last)
+		return;
+	cs->m_inplay[slot] = other;
+	cs->m_slot[other]  = slot;
+	cs->m_inplay[last] = id;
+	cs->m_slot[id]     = last;
+	cs->m_ninplay--;
+}
+
+/*
+ * cs_restore
+ *
+ * Swap the line with the first one out of play, and then count one more in
+ * play.
+ */
+void	cs_restore(LPCOMBOSET cs, int id) {
+	int	slot = cs->m_slot[id], first = cs->m_ninplay,
+		other = cs->m_inplay[first];
+
+	if (slot < first)
+		return;
+	cs->m_inplay[slot]  = other;
+	cs->m_slot[other]   = slot;
+	cs->m_inplay[first] = id;
+	cs->m_slot[id]      = first;
+	cs->m_ninplay++;
+}
+
+/*
+ * cs_planeadd, cs_planesub
+ *
+ * Add one to, or take one from, the count held in the bit planes for every
+ * square in set.  This is done as a ripple carry (or borrow) adder, all of the
+ * squares of a word at once.  Counts never go below zero, nor above
+ * CS_MAXINCIDENT, so nothing is ever carried out of the top plane.
+ */
+static void
+cs_planeadd(SQSET *planes, LPSQSET set)
+{
+	unsigned	carry, c;
+	int		w, p;
+
+	for(w=0; w<SS_WORDS; w++) {
+		carry = set->m_bits[w];
+		for(p=0; (p<CS_NPLANES)&&(carry); p++) {
+			c = planes[p].m_bits[w] & carry;
+			planes[p].m_bits[w] ^= carry;
+			carry = c;
+		}
+	}
+}
+
 static void
-cs_swap(LPCOMBOROW a, LPCOMBOROW b)
+cs_planesub(SQSET *planes, LPSQSET set)
 {
-	COMBOROW	tmp;
+	unsigned	borrow, b;
+	int		w, p;
 
-	memcpy(&tmp, a, sizeof(COMBOROW));
-	memcpy(a, b, sizeof(COMBOROW));
-	memcpy(b, &tmp, sizeof(COMBOROW));
+	for(w=0; w<SS_WORDS; w++) {
+		borrow = set->m_bits[w];
+		for(p=0; (p<CS_NPLANES)&&(borrow); p++) {
+			b = (~planes[p].m_bits[w]) & borrow;
+			planes[p].m_bits[w] ^= borrow;
+			borrow = b;
+		}
+	}
 }
 
+/*
+ * cs_findlive
+ *
+ * Work out the live squares again, from the bit planes: a square is live if
+ * any of its counts, for any owner and number filled, isn't zero.
+ */
+static void
+cs_findlive(LPCOMBOSET cs)
+{
+	SQSET	*planes = &cs->m_planes[0][0][0];
+	int	w, k;
+
+	for(w=0; w<SS_WORDS; w++) {
+		unsigned	live = 0;
+
+		for(k=0; k<(GB_BLACK+1)*NUM_ON_SIDE*CS_NPLANES; k++)
+			live |= planes[k].m_bits[w];
+		cs->m_live.m_bits[w] = live;
+	}
+}
 
 /*
  * cs_place
  *
  * Place a piece onto the board--and specifically note that fact in our 
- * set of combinations.  Each row may need to adjust itself as a result of this
- * piece getting placed.  For those rows that are no longer relevant, we remove
- * them from the set, swapping it for the last valid one in the set.  In this
- * fashion, we guarantee that the first m_ninplay elements are always "in play".
- * That is, all of them can always be used to generate a valid "win" for
- * somebody.
+ * set of combinations.  Only the lines through where, still in play, can
+ * change.  Those that are no longer relevant, we retire, swapping them with
+ * the last valid one in the set.  In this fashion, we guarantee that the
+ * first m_ninplay of m_inplay are always "in play".  That is, all of them can
+ * always be used to generate a valid "win" for somebody.
+ *
+ * The lines are taken in the order they're found within m_inplay, just as
+ * though we had walked through all of it, so that the lines in play end up in
+ * the same order either way.
+ *
+ * The square moved into is no longer live.  Only when a line is retired might
+ * any other square have lost its last line, so only then are the live
+ * squares worked out again.
  */
 bool
 cs_place(LPCOMBOSET cs, GB_PIECE who, int where)
 {
-	int	i;
+	CR_ID	lines[CS_MAXINCIDENT];
+	int	nlines = 0, i, k;
+	bool	retired = false;
 
 	// If someone has already one, this move is illegal--do nothing.
 	if (cs->m_winningid >= 0)
 		return true;
+	if ((where < 0)||(where >= NUM_SQUARES))
+		return false;
 
-	// Walk through all the comborows in our set
-	for(i=0; i < cs->m_ninplay; i++) {
-		// Register each of them
-		if (cr_register(&cs->m_data[i], who, where)) {
-			// If cr_register comes back true then someone has
-			// either won, or the combination is no longer relevant.
-			if ((cs->m_data[i].m_nfilled == NUM_ON_SIDE)
-					&&(cs->m_data[i].m_owner == who)) {
-				// If someone has won, record the winning
-				// combination.
-				cs->m_winningid = i;
-			} else if (!cs->m_data[i].m_interesting) {
-				// Otherwise, the row is no longer interesting.
-				// Let's swap it with the last combo ... as
-				// long as this isn't the last combo.
-				if (i != cs->m_ninplay-1) {
-					cs_swap(&cs->m_data[i],
-						&cs->m_data[cs->m_ninplay-1]);
-					i--;
-				}
-
-				// At this point, there's one less possible
-				// combination in play.
-				cs->m_ninplay--;
-			}
+	for(i=0; i<cs_nincident[where]; i++)
+		if (cs_inplay(cs, cs_incident[where][i]))
+			lines[nlines++] = cs_incident[where][i];
+
+	while(nlines > 0) {
+		int		id, owner, nfilled, nopen;
+		GB_BYTE		*spots;
+		SQSET		open;
+
+		// The next line, by its place in m_inplay
+		for(i=1, k=0; i<nlines; i++)
+			if (cs->m_slot[lines[i]] < cs->m_slot[lines[k]])
+				k = i;
+		id = lines[k];
+		lines[k] = lines[--nlines];
+
+		owner   = cs->m_owner[id];
+		nfilled = cs->m_nfilled[id];
+		spots   = cs->m_spots[id];
+		nopen   = NUM_ON_SIDE - nfilled;
+
+		// Find where among the unfilled squares, and move it to the
+		// back, among the filled ones
+		for(k=0; k<nopen; k++)
+			if (spots[k] == where)
+				break;
+		if (k >= nopen)
+			continue;
+		spots[k] = spots[nopen-1];
+		spots[nopen-1] = where;
+		cs->m_nfilled[id] = ++nfilled;
+
+		// Keep our counts of lines by owner up to date, both in
+		// total and square by square.  Before this move, the line's
+		// open squares were the ones open now, together with where.
+		ss_clear(&open);
+		for(k=0; k<nopen-1; k++)
+			ss_add(&open, spots[k]);
+		cs->m_nlines[owner][nfilled-1]--;
+		ss_add(&open, where);
+		cs_planesub(cs->m_planes[owner][nfilled-1], &open);
+
+		if ((owner != GB_NOONE)&&(owner != who)) {
+			// This line was owned by our opponent.  A potential
+			// win has been blocked, and it is no longer possible
+			// to win in this fashion.
+			cs->m_owner[id] = GB_NOONE;
+			cs_retire(cs, id);
+			retired = true;
+			continue;
 		}
+
+		cs->m_owner[id] = who;
+		cs->m_nlines[who][nfilled]++;
+		if (nfilled < NUM_ON_SIDE) {
+			open.m_bits[where>>5] &= ~(1u << (where & 31));
+			cs_planeadd(cs->m_planes[who][nfilled], &open);
+		} else
+			// Record the winning combination
+			cs->m_winningid = id;
 	}
 
+	if (retired)
+		cs_findlive(cs);
+	else
+		cs->m_live.m_bits[where>>5] &= ~(1u << (where & 31));
+
 	// Return true if someone has won, false otherwise.
 	return (cs->m_winningid >= 0) ? true : false;
 }
 
+/*
+ * cs_nlines
+ *
+ * Put together the count for where from each of the bit planes.
+ */
+int
+cs_nlines(LPCOMBOSET cs, GB_PIECE who, int nfilled, int where)
+{
+	int	n = 0, p;
+
+	if ((nfilled < 0)||(nfilled >= NUM_ON_SIDE)
+			||(where < 0)||(where >= NUM_SQUARES))
+		return 0;
+	for(p=0; p<CS_NPLANES; p++)
+		if (ss_ismember(&cs->m_planes[who][nfilled][p], where))
+			n |= (1<<p);
+	return n;
+}
+
+/*
+ * cs_atleast
+ *
+ * Compare every square's count against n, a word of squares at a time,
+ * working down from the top bit.  gt holds those squares known to be above
+ * n, eq those that match it so far.
+ */
 void
-cs_debug(LPCOMBOSET cs) {
-	printf("COMBOSET DUMP: %2d combos in play, winning ID = %d\n",
-		cs->m_ninplay, cs->m_winningid);
-	for(int i=0; i<cs->m_ninplay; i++) {
-		printf("ROW[%2d] ", i);
-		cr_debug(&cs->m_data[i]);
+cs_atleast(LPCOMBOSET cs, GB_PIECE who, int nfilled, int n, LPSQSET set)
+{
+	unsigned	gt, eq, bits;
+	int		w, p;
+
+	ss_clear(set);
+	if ((nfilled < 0)||(nfilled >= NUM_ON_SIDE)||(n >= (1<<CS_NPLANES)))
+		return;
+	for(w=0; w<SS_WORDS; w++) {
+		gt = 0;
+		eq = ~0u;
+		for(p=CS_NPLANES-1; p>=0; p--) {
+			bits = cs->m_planes[who][nfilled][p].m_bits[w];
+			if ((n >> p)&1)
+				eq &= bits;
+			else {
+				gt |= eq & bits;
+				eq &= ~bits;
+			}
+		} set->m_bits[w] = gt | eq;
+	}
+}
+
+/*
+ * cs_score
+ *
+ * Since m_nlines is kept up to date by cs_place(), scoring a position is no
+ * more than a weighted sum across it.
+ */
+int
+cs_score(LPCOMBOSET cs, GB_PIECE who, const int *weight)
+{
+	int	opp = opponent(who), score = 0, k;
+
+	if (!weight)
+		weight = cs_weight;
+	for(k=1; k<=NUM_ON_SIDE; k++)
+		score += weight[k]
+			* (cs->m_nlines[who][k] - cs->m_nlines[opp][k]);
+	return score;
+}
+
+/*
+ * cs_movegain
+ *
+ * Each line through where that's still in play either becomes worth more to
+ * who, if he owns it (or nobody does), or stops counting for his opponent.
+ */
+int
+cs_movegain(LPCOMBOSET cs, GB_PIECE who, int where, const int *weight)
+{
+	int	i, gain = 0;
+
+	if ((where < 0)||(where >= NUM_SQUARES)||(cs->m_winningid >= 0))
+		return 0;
+	if (!weight)
+		weight = cs_weight;
+
+	for(i=0; i<cs_nincident[where]; i++) {
+		int	id = cs_incident[where][i];
+
+		if (!cs_inplay(cs, id))
+			continue;
+
+		// If where has already been taken, there's nothing to gain
+		if (!cs_isopen(cs, id, where))
+			return 0;
+
+		if (cs->m_owner[id] == GB_NOONE)
+			gain += weight[1];
+		else if (cs->m_owner[id] == who)
+			gain += weight[cs->m_nfilled[id]+1]
+				- weight[cs->m_nfilled[id]];
+		else
+			gain += weight[cs->m_nfilled[id]];
 	}
+
+	return gain;
 }
@@ -43,22 +43,107 @@
 #include "bool.h"
 #include "gboard.h"
 #include "comborow.h"
+#include "vset.h"
 
-// The number of possible ways to win in 4x4x4 tic-tac-toe
-#define	NUM_COMBOROWS	(16*3+4*7)
+// The most lines that pass through any one square.  On boards with an odd
+// number of squares on a side, that's the center square, through which
+// passes a line in every direction.  Otherwise it's a corner, or any other
+// square on one of the long diagonals: (2^NUM_DIMS)-1 lines.
+#if	(NUM_ON_SIDE & 1)
+#define	CS_MAXINCIDENT	((GB_POW(3)-1)/2)
+#else
+#define	CS_MAXINCIDENT	(GB_POW(2)-1)
+#endif
+
+// The bits it takes to count the lines through any one square
+#if	CS_MAXINCIDENT < 8
+#define	CS_NPLANES	3
+#elif	CS_MAXINCIDENT < 16
+#define	CS_NPLANES	4
+#elif	CS_MAXINCIDENT < 32
+#define	CS_NPLANES	5
+#else
+#define	CS_NPLANES	6
+#endif
+
+// The number of symmetries of the board: NUM_DIMS! ways of ordering the
+// axes, times 2^NUM_DIMS ways of flipping them
+#define	CS_NSYMS	((NUM_DIMS == 2) ? 8 : (NUM_DIMS == 3) ? 48 : 384)
+
+// A square number, or -1 for none
+#if	NUM_SQUARES > 128
+typedef	short		CS_SQUARE;
+#else
+typedef	signed char	CS_SQUARE;
+#endif
 
 typedef	struct	COMBOSET_S {
 		// A combination row is in play as long as no more than one
 		// player has moved within it.
 	int	m_ninplay,
 		// If one of our combinations has resulted in a win, let's
-		// record the index of that combination.
+		// record the id of that combination.
 		m_winningid;
 
-	// These are the set of the possible winning combinations
-	COMBOROW	m_data[NUM_COMBOROWS];
+	// The lines still in play, by id, are the first m_ninplay of
+	// m_inplay--in no particular order.  The rest have been retired.
+	// m_slot gives where, within m_inplay, each line may be found.
+	CR_ID		m_inplay[NUM_COMBOROWS];
+	CR_ID		m_slot[NUM_COMBOROWS];
+
+	// Each line's state, kept as one array per field rather than as an
+	// array of COMBOROWs, so that a scan reads only the fields it needs.
+	// Every array is indexed by line id, which never changes.  As with a
+	// COMBOROW, the first NUM_ON_SIDE-m_nfilled[id] of m_spots[id] are
+	// the line's unfilled squares.  A line out of play is owned by
+	// GB_NOONE.
+	GB_BYTE		m_owner[NUM_COMBOROWS];
+	GB_BYTE		m_nfilled[NUM_COMBOROWS];
+	GB_BYTE		m_spots[NUM_COMBOROWS][NUM_ON_SIDE];
+
+	// The number of lines still in play, by owner and number filled.
+	// Lines nobody owns are all in m_nlines[GB_NOONE][0]--once both
+	// players have moved in a line, it's out of play and no longer
+	// counted.
+	short		m_nlines[GB_BLACK+1][NUM_ON_SIDE+1];
+
+	// The same lines again, counted square by square.  Bit p of the
+	// number of lines through each open square, owned by who and with
+	// nfilled filled, is kept in the set m_planes[who][nfilled][p].  As
+	// with m_nlines, a line that's been won, or is out of play, counts
+	// nowhere.  These bit planes let every square's count be updated, or
+	// compared, a word of squares at a time.
+	SQSET		m_planes[GB_BLACK+1][NUM_ON_SIDE][CS_NPLANES];
+
+	// The live squares: those open squares with at least one line still
+	// in play through them, whether owned by either player or by nobody.
+	// A move anywhere else can neither win nor block anything.
+	SQSET		m_live;
 } COMBOSET, *LPCOMBOSET;
 
+/*
+ * The generated tables (see mkwins.c)
+ *
+ * cs_initial	The COMBOSET every game starts from
+ * cs_lines	The squares making up each line
+ * cs_nincident, cs_incident
+ *		The number of lines through each square, and which they are
+ * cs_crossing	The square where two lines cross, or -1 if they don't
+ * cs_weight	What a line still in play is worth to its owner, by the number
+ *		of his pieces within it
+ * cs_symmetry	Where each symmetry of the board takes each square.  The first
+ *		is the identity.
+ * cs_orbit	The lowest numbered square any symmetry takes each square to
+ */
+extern	const COMBOSET		cs_initial;
+extern	const unsigned char	cs_lines[NUM_COMBOROWS][NUM_ON_SIDE];
+extern	const unsigned char	cs_nincident[NUM_SQUARES];
+extern	const CR_ID		cs_incident[NUM_SQUARES][CS_MAXINCIDENT];
+extern	const CS_SQUARE		cs_crossing[NUM_COMBOROWS][NUM_COMBOROWS];
+extern	const int		cs_weight[NUM_ON_SIDE+1];
+extern	const unsigned char	cs_symmetry[CS_NSYMS][NUM_SQUARES];
+extern	const unsigned char	cs_orbit[NUM_SQUARES];
+
 /*
  * cs_init
  *
@@ -74,10 +159,78 @@ extern void	cs_init(LPCOMBOSET cs);
  */
 extern bool	cs_place(LPCOMBOSET cs, GB_PIECE who, int where);
 
+/*
+ * cs_retire, cs_restore
+ *
+ * Take the line id out of play, or put it back, by moving it across the end
+ * of the in-play part of m_inplay.  Neither touches the line's own state.
+ */
+extern void	cs_retire(LPCOMBOSET cs, int id);
+extern void	cs_restore(LPCOMBOSET cs, int id);
+
+/*
+ * cs_inplay
+ *
+ * Is the line id still in play?
+ */
+#define	cs_inplay(CS, ID)	((CS)->m_slot[ID] < (CS)->m_ninplay)
+
+/*
+ * cs_isopen
+ *
+ * Is where one of the unfilled squares of line id?
+ */
+extern bool	cs_isopen(LPCOMBOSET cs, int id, int where);
+
+/*
+ * cs_isects
+ *
+ * Two lines, by id, intersect if both are still in play and the square where
+ * they cross is still open.  This is cr_isects(), using the table of
+ * crossings rather than comparing the two lines square by square.
+ */
+extern bool	cs_isects(LPCOMBOSET cs, int a, int b);
+
+/*
+ * cs_nlines
+ *
+ * The number of lines through the open square where, still in play, owned
+ * by who with nfilled of their squares filled.  Read from m_planes.
+ */
+extern int	cs_nlines(LPCOMBOSET cs, GB_PIECE who, int nfilled, int where);
+
+/*
+ * cs_atleast
+ *
+ * Place into set every open square lying on at least n of the lines still in
+ * play owned by who with nfilled filled.  n must be at least one.
+ */
+extern void	cs_atleast(LPCOMBOSET cs, GB_PIECE who, int nfilled, int n,
+			LPSQSET set);
+
+/*
+ * cs_score
+ *
+ * How good the position looks for "who": the worth (by weight, or cs_weight
+ * if weight is NULL) of every line he owns, less that of every line his
+ * opponent owns.  This comes straight from m_nlines, without looking at any
+ * of the lines themselves.
+ */
+extern int	cs_score(LPCOMBOSET cs, GB_PIECE who, const int *weight);
+
+/*
+ * cs_movegain
+ *
+ * How much cs_score() would change for "who", were he to move "where".  Only
+ * the lines through where are examined.
+ */
+extern int	cs_movegain(LPCOMBOSET cs, GB_PIECE who, int where,
+			const int *weight);
+
 /*
  * cs_debug
  *
- * Dump a comboset to the screen for debugging evaluation
+ * Dump a comboset to the screen for debugging evaluation.  (See display.c)
  */
 extern	void	cs_debug(LPCOMBOSET cs);
 
@@ -0,0 +1,228 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	display.c
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	All of the routines that dump the game's data structures to
+//		stdout live here, rather than alongside the data structures
+//	themselves.  This keeps stdio out of the core engine (libtttt), so
+//	that it may be embedded within other programs.  The interactive
+//	program, and any debugging tools, link this file in on their own.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#include <stdio.h>
+#include "gboard.h"
+#include "comborow.h"
+#include "comboset.h"
+#include "vset.h"
+#include "latency.h"
+#include "tally.h"
+
+// Boards are drawn one row of x per line, y counting down the screen.  A
+// third axis is drawn as boards side by side, and a fourth as groups of
+// those stacked one above another.
+#define	NUM_BOARDS	((NUM_DIMS > 2) ? NUM_ON_SIDE : 1)
+#define	NUM_GROUPS	((NUM_DIMS > 3) ? NUM_ON_SIDE : 1)
+
+static int
+drawnsquare(int x, int y, int z, int w) {
+	int	c[4] = { x, y, z, w };
+
+	return gb_square(c);
+}
+
+void gb_print(LPGBOARD brd) {
+	int	x, y, z, w, loc;
+
+	if (brd->m_nfilled == 0)
+		printf("Current Board: (Empty)\n");
+	else if (brd->m_winner == GB_NOONE)
+		printf("Current Board:\n");
+	else if (brd->m_winner == GB_BLACK)
+		printf("Current Board: (X wins)\n");
+	else if (brd->m_winner == GB_WHITE)
+		printf("Current Board: (O wins)\n");
+		
+	for(w=0; w<NUM_GROUPS; w++) {
+		for(y=0; y<NUM_ON_SIDE; y++) {
+			for(z=0; z<NUM_BOARDS; z++) {
+				for(x=0; x<NUM_ON_SIDE; x++) {
+					loc = drawnsquare(x, y, z, w);
+					GB_PIECE who = brd->m_spots[loc];
+					if (who == GB_BLACK)
+						printf("x");
+					else if (who == GB_WHITE)
+						printf("o");
+					else
+						printf("-");
+				}
+
+				printf("  ");
+			}
+			printf("\n");
+		} printf("\n");
+	}
+}
+
+/*
+ * cr_debug
+ *
+ * DUMP the relavent parts of the comborow structure to the screen.  Other
+ * constraints applied, and we are restricted to one line here.
+ */
+void	cr_debug(LPCOMBOROW cr) {
+	int	i, unfilled = NUM_ON_SIDE - cr->m_nfilled;
+
+	for(i=0; i< unfilled; i++)
+		printf(" %2d  ", cr->m_spots[i]);
+	for(i= unfilled; i<NUM_ON_SIDE; i++)
+		printf("(%2d) ", cr->m_spots[i]);
+	if (!cr->m_interesting)
+		printf("  Not interesting\r\n");
+	else if (cr->m_owner == GB_WHITE)
+		printf("  Owned by O\r\n");
+	else if (cr->m_owner == GB_BLACK)
+		printf("  Owned by X\r\n");
+	else	printf("\r\n");
+}
+
+void
+cs_debug(LPCOMBOSET cs) {
+	printf("COMBOSET DUMP: %2d combos in play, winning ID = %d\n",
+		cs->m_ninplay, cs->m_winningid);
+	for(int i=0; i<cs->m_ninplay; i++) {
+		int	id = cs->m_inplay[i], j,
+			unfilled = NUM_ON_SIDE - cs->m_nfilled[id];
+
+		printf("ROW[%2d] ", id);
+		for(j=0; j< unfilled; j++)
+			printf(" %2d  ", cs->m_spots[id][j]);
+		for(j= unfilled; j<NUM_ON_SIDE; j++)
+			printf("(%2d) ", cs->m_spots[id][j]);
+		if (cs->m_owner[id] == GB_WHITE)
+			printf("  Owned by O\r\n");
+		else if (cs->m_owner[id] == GB_BLACK)
+			printf("  Owned by X\r\n");
+		else	printf("\r\n");
+	}
+}
+
+void	vs_debug(LPVSET vs) {
+	int	x, y, z, w, loc;
+
+	printf("VSET: NUMBER ACTIVE = %d\n", vs->m_active);
+
+	for(w=0; w<NUM_GROUPS; w++) {
+		for(y=0; y<NUM_ON_SIDE; y++) {
+			for(z=0; z<NUM_BOARDS; z++) {
+				for(x=0; x<NUM_ON_SIDE; x++) {
+					int	data;
+					loc = drawnsquare(x, y, z, w);
+					data = vs->m_data[loc];
+
+					if (data <= 0)
+						printf("-");
+					else if (data <= 9)
+						printf("%d", data);
+					else
+						printf("*");
+				}
+
+				printf("  ");
+			}
+			printf("\n");
+		} printf("\n");
+	}
+}
+
+static void
+lat_row(int level, const char *fills, const LATHIST *h) {
+	printf("%6d  %-7s %10lu %9.1f %9.1f %9.1f %9.1f\n", level, fills,
+		h->m_count, lat_percentile(h, 50) / 1e3,
+		lat_percentile(h, 90) / 1e3, lat_percentile(h, 99) / 1e3,
+		h->m_max / 1e3);
+}
+
+void	lat_print(const LATTABLE *t) {
+	LATHIST	all;
+	char	fills[16];
+	int	k, f;
+
+	printf("%6s  %-7s %10s %9s %9s %9s %9s\n", "Level", "Filled",
+		"Moves", "p50(us)", "p90(us)", "p99(us)", "Max(us)");
+	for(k=0; k<t->m_nlevels; k++) {
+		lat_clear(&all);
+		for(f=0; f<LAT_NFILLS; f++)
+			lat_merge(&all, &t->m_hist[k][f]);
+		lat_row(t->m_levels[k], "all", &all);
+		for(f=0; f<LAT_NFILLS; f++) {
+			if (t->m_hist[k][f].m_count == 0)
+				continue;
+			sprintf(fills, "%d-%d", f * LAT_FILLSTEP,
+				(f+1) * LAT_FILLSTEP - 1);
+			lat_row(t->m_levels[k], fills, &t->m_hist[k][f]);
+		}
+	}
+	if (t->m_dropped)
+		printf("(%lu moves at other levels were not counted)\n",
+			t->m_dropped);
+}
+
+void	tl_print(const TALLY *t) {
+	double	n = (double)t->m_count;
+
+	if (t->m_kind == TL_ANALYZE) {
+		printf("Positions:    %8llu\n", (unsigned long long)t->m_count);
+		printf("Errors:       %8llu\n", (unsigned long long)t->m_errors);
+	} else {
+		printf("Games:        %8llu\n", (unsigned long long)t->m_count);
+		if (t->m_count > 0) {
+			printf("Black (%4d): %8llu wins (%5.1f%%)\n",
+				t->m_difficulty[0],
+				(unsigned long long)t->m_wins[GB_BLACK],
+				100.0 * t->m_wins[GB_BLACK] / n);
+			printf("White (%4d): %8llu wins (%5.1f%%)\n",
+				t->m_difficulty[1],
+				(unsigned long long)t->m_wins[GB_WHITE],
+				100.0 * t->m_wins[GB_WHITE] / n);
+			printf("Ties:         %8llu      (%5.1f%%)\n",
+				(unsigned long long)t->m_wins[GB_TIE],
+				100.0 * t->m_wins[GB_TIE] / n);
+			printf("Average game: %8.1f moves\n", t->m_nmoves / n);
+		}
+	}
+
+	if (t->m_lat) {
+		printf("\n");
+		lat_print(t->m_lat);
+	}
+}
@@ -46,7 +46,6 @@ int main(int argc, char **argv) {
 	int	i, j;
 	GBOARD	brd;
 	COMBOSET	cs;
-	LPCOMBOROW	cr;
 
 	cs_init(&cs);
 
@@ -58,9 +57,8 @@ int main(int argc, char **argv) {
 		//
 		// Specifically, we place a piece into all the squares
 		// associated with a particular four-in-a-row possibility.
-		cr = &cs.m_data[i];
 		for(j=0; j < NUM_ON_SIDE; j++)
-			brd.m_spots[cr->m_spots[j]] = GB_BLACK;
+			brd.m_spots[cs.m_spots[i][j]] = GB_BLACK;
 
 		// And print it out.
 		gb_print(&brd);
@@ -36,7 +36,6 @@
 ////////////////////////////////////////////////////////////////////////////////
 //
 //
-#include <stdio.h>
 #include <stdlib.h>
 #include "gboard.h"
 
@@ -44,7 +43,8 @@ LPGBOARD	gb_new(void) {
 	LPGBOARD	brd;
 
 	brd = (LPGBOARD)malloc(sizeof(GBOARD));
-	gb_reset(brd);
+	if (brd)
+		gb_reset(brd);
 	return brd;
 }
 
@@ -57,6 +57,38 @@ void	gb_reset(LPGBOARD brd) {
 	brd->m_nfilled  = 0;
 }
 
+/*
+ * gb_square
+ *
+ * Convert a set of NUM_DIMS coordinates, x first, into a square number.
+ * Returns -1 if any coordinate is off of the board.
+ */
+int	gb_square(const int *coords) {
+	int	i, spt = 0;
+
+	for(i=NUM_DIMS-1; i>=0; i--) {
+		if ((coords[i] >= NUM_ON_SIDE)||(coords[i] < 0))
+			return -1;
+		spt = spt * NUM_ON_SIDE + coords[i];
+	}
+
+	return spt;
+}
+
+/*
+ * gb_coord
+ *
+ * Return one coordinate of a square: x for axis 0, y for axis 1, and so on.
+ */
+int	gb_coord(int spt, int axis) {
+	if ((spt >= NUM_SQUARES)||(spt < 0)||(axis < 0)||(axis >= NUM_DIMS))
+		return -1;
+	while(axis-- > 0)
+		spt /= NUM_ON_SIDE;
+	return spt % NUM_ON_SIDE;
+}
+
+#if	NUM_DIMS == 3
 int	coordtoint(int x, int y, int z) {
 	if ((x >= NUM_ON_SIDE)||(x < 0))
 		return -1;
@@ -67,6 +99,7 @@ int	coordtoint(int x, int y, int z) {
 
 	return (z * NUM_ON_SIDE + y) * NUM_ON_SIDE + x;
 }
+#endif
 
 int	opponent(int who) {
 	if (who == GB_WHITE)
@@ -77,6 +110,7 @@ int	opponent(int who) {
 		return GB_NOONE;
 }
 
+#if	NUM_DIMS == 3
 int	xcoord(int spt) {
 	if ((spt >= NUM_SQUARES)||(spt < 0))
 		return -1;
@@ -94,6 +128,7 @@ int	zcoord(int spt) {
 		return -1;
 	return (spt / (NUM_ON_SIDE*NUM_ON_SIDE));
 }
+#endif
 
 bool	legal(LPGBOARD brd, GB_PIECE who, int where) {
 	if (brd->m_winner != GB_NOONE)
@@ -111,17 +146,21 @@ bool	legal(LPGBOARD brd, GB_PIECE who, int where) {
 	return true;
 }
 	
-void	gb_place(LPGBOARD brd, GB_PIECE who, int where) {
-	if (!legal(brd, who, where)) {
-		printf("ILLEGAL-MOVE ATTEMPTED: %s tried to move to %d",
-			(who == GB_BLACK)?"black"
-			:(who == GB_WHITE)?"white"
-			: "? someone ?", where);
-	}
+/*
+ * gb_place
+ *
+ * Place who's piece at where, returning true on success.  An illegal move
+ * leaves the board untouched and returns false--it is up to the caller to
+ * decide whether or not to complain about it.
+ */
+bool	gb_place(LPGBOARD brd, GB_PIECE who, int where) {
+	if (!legal(brd, who, where))
+		return false;
 
 	brd->m_spots[where] = who;
 	brd->m_lastturn = who;
 	brd->m_nfilled++;
+	return true;
 }
 
 bool	inuse(LPGBOARD brd, int where) {
@@ -137,12 +176,7 @@ GB_PIECE whoseturn(LPGBOARD brd) {
 		return GB_BLACK;
 	else if (brd->m_lastturn == GB_BLACK)
 		return GB_WHITE;
-	else
-		printf("Cannot tell whose turn it is from %d (%s)\n", 
-			brd->m_lastturn,
-			(brd->m_lastturn == GB_BLACK)?"black"
-			:(brd->m_lastturn == GB_WHITE)?"white"
-			: "? someone ?");
+	// Otherwise the board is corrupt, and we cannot tell whose turn it is
 	return GB_NOONE;
 }
 
@@ -159,35 +193,3 @@ GB_PIECE pieceat(LPGBOARD brd, int where) {
 		return	GB_NOONE;
 	return	brd->m_spots[where];
 }
-
-void gb_print(LPGBOARD brd) {
-	int	x, y, z, loc;
-
-	if (brd->m_nfilled == 0)
-		printf("Current Board: (Empty)\n");
-	else if (brd->m_winner == GB_NOONE)
-		printf("Current Board:\n");
-	else if (brd->m_winner == GB_BLACK)
-		printf("Current Board: (X wins)\n");
-	else if (brd->m_winner == GB_WHITE)
-		printf("Current Board: (O wins)\n");
-		
-	for(y=0; y<NUM_ON_SIDE; y++) {
-		for(z=0; z<NUM_ON_SIDE; z++) {
-			for(x=0; x<NUM_ON_SIDE; x++) {
-				loc = coordtoint(x, y, z);
-				GB_PIECE who = brd->m_spots[loc];
-				if (who == GB_BLACK)
-					printf("x");
-				else if (who == GB_WHITE)
-					printf("o");
-				else
-					printf("-");
-			}
-
-			printf("  ");
-		}
-		printf("\n");
-	} printf("\n");
-}
-
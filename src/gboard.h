@@ -41,32 +41,78 @@
 
 #include "bool.h"
 
+// The size and shape of the board are fixed at build time, so that every
+// loop over a row, or over the board, has a constant trip count.  The
+// classic game is four on a side, in three dimensions.  (See the Makefile's
+// SIDE and DIMS.)
+#ifndef	NUM_ON_SIDE
 #define	NUM_ON_SIDE	4
-#define	NUM_SQUARES	(NUM_ON_SIDE * NUM_ON_SIDE * NUM_ON_SIDE)
+#endif
+#ifndef	NUM_DIMS
+#define	NUM_DIMS	3
+#endif
+
+#if	(NUM_DIMS < 2)||(NUM_DIMS > 4)
+#error	"Only boards of two to four dimensions are supported"
+#endif
+#if	(NUM_ON_SIDE < 3)||(NUM_ON_SIDE > 9)
+#error	"Boards must have from three to nine squares on a side"
+#endif
+
+// GB_POW(n) is n raised to the NUM_DIMS power
+#define	GB_POW(n)	((NUM_DIMS == 2) ? (n)*(n)		\
+			:(NUM_DIMS == 3) ? (n)*(n)*(n)		\
+			: (n)*(n)*(n)*(n))
+#define	NUM_SQUARES	GB_POW(NUM_ON_SIDE)
+
+// Squares are kept in eight bits in a few places, such as game records
+#if	NUM_SQUARES > 256
+#error	"Boards may have no more than 256 squares"
+#endif
+
+// The number of ways to win.  Picture the board with a border one square
+// wide all around it.  Every line, extended, starts in one border square and
+// ends in another, and every border square is the start or end of exactly
+// one line.
+#define	NUM_COMBOROWS	((GB_POW(NUM_ON_SIDE+2) - GB_POW(NUM_ON_SIDE))/2)
 
 typedef	enum	GB_PIECE_E {
 	GB_NOONE=0, GB_WHITE, GB_BLACK, GB_TIE
 } GB_PIECE;
 
+// The small build (TTTT_SMALL, the default for the ZipCPU) packs anything
+// that fits into a byte--pieces, counts, and square numbers--into one.  The
+// rest of the time we use ints, the natural size of the machine.
+#ifdef	TTTT_SMALL
+typedef	unsigned char	GB_BYTE;
+#else
+typedef	int		GB_BYTE;
+#endif
+
 typedef	struct GBOARD_S {
 	int	m_lastturn, m_winner, m_nfilled;
-	int	m_spots[NUM_SQUARES];
+	GB_BYTE	m_spots[NUM_SQUARES];
 } GBOARD, *LPGBOARD;
 
 LPGBOARD gb_new(void);
 void	gb_reset(LPGBOARD brd);
+int	gb_square(const int *coords);
+int	gb_coord(int spt, int axis);
+#if	NUM_DIMS == 3
 int	coordtoint(int x, int y, int z);
-int	opponent(int who);
 int	xcoord(int spt);
 int	ycoord(int spt);
 int	zcoord(int spt);
+#endif
+int	opponent(int who);
 bool	legal(LPGBOARD brd, GB_PIECE who, int where);
-void	gb_place(LPGBOARD brd, GB_PIECE who, int where);
+bool	gb_place(LPGBOARD brd, GB_PIECE who, int where);
 bool	inuse(LPGBOARD brd, int where);
 GB_PIECE whoseturn(LPGBOARD brd);
 bool	gb_gameover(LPGBOARD brd);
 GB_PIECE gb_winner(LPGBOARD brd);
 GB_PIECE pieceat(LPGBOARD brd, int where);
+// Print the board to stdout.  (This lives in display.c, not libtttt)
 void	gb_print(LPGBOARD brd);
 
 
@@ -0,0 +1,384 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	golden.c
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	Checks the engine against a corpus of golden positions: openings,
+//		middlegame tactics, and nearly full boards.  Each line of the
+//	corpus is a position (see position.h), followed by one entry for each
+//	difficulty level it is checked at:
+//
+//		<level>:<square>[,<square>...]:<usec>
+//
+//	The squares are the moves accepted at that level, and usec the time
+//	makemove() took there when the corpus was last written.  Blank lines,
+//	and lines starting with '#', are ignored.
+//
+//	Every move the engine might make at a level (any of its equally good
+//	moves) must be one of those accepted, and its time to make it--the
+//	fastest of a number of tries--must be no more than the tolerance times
+//	the time given, plus some slack.  Every check writes one line of
+//	key=value pairs, ending with a summary, and the program exits with a
+//	failure if any check failed.  The times are only good for the machine,
+//	and the build, they were measured with.  -w writes the corpus out
+//	again, as the engine now plays it.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#define	_POSIX_C_SOURCE	200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "gboard.h"
+#include "comboset.h"
+#include "strategy.h"
+#include "position.h"
+
+#define	GD_MAXLINE	4096
+#define	GD_MAXLEVELS	16
+// Each position is timed for at least this many tries, and this long
+#define	GD_MINTRIES	5
+#define	GD_MINNSEC	2000000
+
+// One difficulty level of one position
+typedef	struct	GDLEVEL_S {
+	int	m_level;
+	SQSET	m_accepted;
+	double	m_usec;
+} GDLEVEL, *LPGDLEVEL;
+
+typedef	struct	GOLDEN_S {
+	double		m_tolerance, m_slack;
+	bool		m_timed, m_write;
+	// The levels to check positions without any, when writing
+	int		m_nlevels, m_levels[GD_MAXLEVELS];
+	unsigned long	m_npositions, m_nchecks, m_nfailed;
+	double		m_total, m_baseline;
+} GOLDEN, *LPGOLDEN;
+
+static double
+nanoseconds(void) {
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+ * choose
+ *
+ * Find every move the engine might make at a given level, returning how many
+ * there are.  If asked to, also time makemove(), returning the fastest of
+ * several tries in *usec.
+ */
+static int
+choose(LPGBOARD brd, LPCOMBOSET cs, int level, LPSQSET moves, double *usec) {
+	STRATEGY	s;
+	VSET		spots;
+	GB_PIECE	who = whoseturn(brd);
+	double		start, first, elapsed;
+	int		tries, n;
+
+	set_difficulty(&s, level);
+	set_seed(&s, 0);
+	choosemoves(&s, brd, cs, who, &spots);
+	n = vs_best(&spots, moves);
+
+	if (usec) {
+		*usec = 0;
+		first = nanoseconds();
+		for(tries=0; (tries < GD_MINTRIES)
+				||(nanoseconds() - first < GD_MINNSEC); tries++) {
+			start = nanoseconds();
+			makemove(&s, brd, cs, who);
+			elapsed = (nanoseconds() - start) / 1e3;
+			if ((tries == 0)||(elapsed < *usec))
+				*usec = elapsed;
+		}
+	} return n;
+}
+
+static void
+listmoves(LPSQSET moves, char *buf) {
+	int	i;
+	bool	first = true;
+
+	*buf = '\0';
+	for(i=0; i<NUM_SQUARES; i++) {
+		if (!ss_ismember(moves, i))
+			continue;
+		buf += sprintf(buf, (first) ? "%d" : ",%d", i);
+		first = false;
+	} if (first)
+		strcpy(buf, "-");
+}
+
+/*
+ * parselevels
+ *
+ * Read the levels following the position on a line of the corpus, returning
+ * how many there are, or -1 if any is malformed.
+ */
+static int
+parselevels(const char *str, LPGDLEVEL levels) {
+	char	*end;
+	int	n = 0;
+	long	sq;
+
+	// Skip past the position, and the side to move
+	str += strspn(str, " \t");
+	str += strcspn(str, " \t");
+	str += strspn(str, " \t");
+	str += strcspn(str, " \t\r\n");
+
+	for(;;) {
+		str += strspn(str, " \t\r\n");
+		if ((*str == '\0')||(*str == '#'))
+			return n;
+		if (n >= GD_MAXLEVELS)
+			return -1;
+		levels[n].m_level = strtol(str, &end, 10);
+		if ((end == str)||(*end != ':'))
+			return -1;
+		str = end+1;
+		ss_clear(&levels[n].m_accepted);
+		if (*str == '-')
+			str++;
+		else for(;;) {
+			sq = strtol(str, &end, 10);
+			if ((end == str)||(sq < 0)||(sq >= NUM_SQUARES))
+				return -1;
+			ss_add(&levels[n].m_accepted, sq);
+			str = end;
+			if (*str != ',')
+				break;
+			str++;
+		}
+		if (*str != ':')
+			return -1;
+		str++;
+		levels[n].m_usec = strtod(str, &end);
+		if (end == str)
+			return -1;
+		str = end;
+		n++;
+	}
+}
+
+/*
+ * check
+ *
+ * Check one position of the corpus, at each of its levels
+ */
+static void
+check(LPGOLDEN g, unsigned long lineno, LPGBOARD brd, LPCOMBOSET cs,
+		LPGDLEVEL levels, int nlevels) {
+	char	moves[4*NUM_SQUARES+1], accepted[4*NUM_SQUARES+1];
+	SQSET	chosen;
+	double	usec, limit;
+	bool	ok;
+	int	k, i;
+
+	g->m_npositions++;
+	for(k=0; k<nlevels; k++) {
+		choose(brd, cs, levels[k].m_level, &chosen,
+			(g->m_timed) ? &usec : NULL);
+
+		ok = true;
+		for(i=0; i<NUM_SQUARES; i++)
+			if ((ss_ismember(&chosen, i))
+					&&(!ss_ismember(&levels[k].m_accepted, i)))
+				ok = false;
+		listmoves(&chosen, moves);
+		g->m_nchecks++;
+		if (ok)
+			printf("line=%lu level=%d check=moves result=pass "
+				"moves=%s\n", lineno, levels[k].m_level, moves);
+		else {
+			listmoves(&levels[k].m_accepted, accepted);
+			printf("line=%lu level=%d check=moves result=FAIL "
+				"moves=%s accepted=%s\n", lineno,
+				levels[k].m_level, moves, accepted);
+			g->m_nfailed++;
+		}
+
+		if (!g->m_timed)
+			continue;
+		limit = levels[k].m_usec * g->m_tolerance + g->m_slack;
+		ok = (usec <= limit);
+		g->m_nchecks++;
+		g->m_total    += usec;
+		g->m_baseline += levels[k].m_usec;
+		printf("line=%lu level=%d check=time result=%s usec=%.2f "
+			"baseline=%.2f limit=%.2f\n", lineno,
+			levels[k].m_level, (ok) ? "pass" : "FAIL", usec,
+			levels[k].m_usec, limit);
+		if (!ok)
+			g->m_nfailed++;
+	}
+}
+
+/*
+ * rewrite
+ *
+ * Write one position of the corpus back out, as the engine now plays it
+ */
+static void
+rewrite(LPGOLDEN g, const char *line, LPGBOARD brd, LPCOMBOSET cs,
+		LPGDLEVEL levels, int nlevels) {
+	char	moves[4*NUM_SQUARES+1];
+	SQSET	chosen;
+	double	usec;
+	int	k;
+
+	if (nlevels == 0) {
+		for(k=0; k<g->m_nlevels; k++)
+			levels[k].m_level = g->m_levels[k];
+		nlevels = g->m_nlevels;
+	}
+
+	g->m_npositions++;
+	line += strspn(line, " \t");
+	printf("%.*s", NUM_SQUARES+2, line);
+	for(k=0; k<nlevels; k++) {
+		choose(brd, cs, levels[k].m_level, &chosen, &usec);
+		listmoves(&chosen, moves);
+		printf(" %d:%s:%.2f", levels[k].m_level, moves, usec);
+	} printf("\n");
+}
+
+static void
+usage(void) {
+	fprintf(stderr,
+"USAGE: tttt-golden [-t <tolerance>] [-a <usec>] [-n] [<file>]\n"
+"       tttt-golden -w [-l <level>[,<level>...]] [<file>]\n"
+"\n"
+"\tChecks every position of the corpus in <file>, or stdin if no file\n"
+"\tis given, exiting with a failure if any check fails\n"
+"\n"
+"\t-t <tolerance>\tA position may take this many times as long as its\n"
+"\t\tbaseline, defaults to 2\n"
+"\t-a <usec>\tAnd this many microseconds more, defaults to 2\n"
+"\t-n\t\tDon't check the time taken, only the moves\n"
+"\t-w\t\tRather than checking the corpus, write it out again with the\n"
+"\t\tmoves and times of this engine\n"
+"\t-l <levels>\tWhen writing, the levels to give positions with none,\n"
+"\t\tdefaults to 1000,7,5,3,1\n");
+}
+
+int	main(int argc, char **argv) {
+	GOLDEN		g;
+	GBOARD		brd;
+	COMBOSET	cs;
+	GDLEVEL		levels[GD_MAXLEVELS];
+	FILE		*fp = stdin;
+	char		line[GD_MAXLINE], *ptr;
+	unsigned long	lineno = 0;
+	int		opt, nlevels;
+
+	memset(&g, 0, sizeof(g));
+	g.m_tolerance = 2.0;
+	g.m_slack = 2.0;
+	g.m_timed = true;
+	g.m_nlevels = 5;
+	g.m_levels[0] = 1000;
+	g.m_levels[1] = 7;
+	g.m_levels[2] = 5;
+	g.m_levels[3] = 3;
+	g.m_levels[4] = 1;
+	while((opt = getopt(argc, argv, "a:hl:nt:w")) != -1) {
+		switch(opt) {
+		case 'a': g.m_slack = atof(optarg); break;
+		case 'l':
+			g.m_nlevels = 0;
+			for(ptr = strtok(optarg, ","); (ptr)
+					&&(g.m_nlevels < GD_MAXLEVELS);
+					ptr = strtok(NULL, ","))
+				g.m_levels[g.m_nlevels++] = atoi(ptr);
+			break;
+		case 'n': g.m_timed = false; break;
+		case 't': g.m_tolerance = atof(optarg); break;
+		case 'w': g.m_write = true; break;
+		default:
+			usage();
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (optind+1 == argc) {
+		fp = fopen(argv[optind], "r");
+		if (!fp) {
+			perror("O/S Err: Cannot open corpus");
+			exit(EXIT_FAILURE);
+		}
+	} else if (optind != argc) {
+		usage();
+		exit(EXIT_FAILURE);
+	}
+
+	while(fgets(line, sizeof(line), fp)) {
+		lineno++;
+		ptr = line + strspn(line, " \t\r\n");
+		if ((*ptr == '\0')||(*ptr == '#')) {
+			if (g.m_write)
+				fputs(line, stdout);
+			continue;
+		}
+
+		nlevels = parselevels(line, levels);
+		if ((nlevels < 0)||(!pos_parse(line, &brd, &cs))
+				||(whoseturn(&brd) == GB_NOONE)) {
+			fprintf(stderr, "ERR: Line %lu is not a golden position\n",
+				lineno);
+			exit(EXIT_FAILURE);
+		}
+
+		if (g.m_write)
+			rewrite(&g, line, &brd, &cs, levels, nlevels);
+		else
+			check(&g, lineno, &brd, &cs, levels, nlevels);
+	}
+
+	if (fp != stdin)
+		fclose(fp);
+
+	if (g.m_write)
+		return EXIT_SUCCESS;
+
+	printf("summary positions=%lu checks=%lu failed=%lu", g.m_npositions,
+		g.m_nchecks, g.m_nfailed);
+	if (g.m_timed)
+		printf(" usec=%.2f baseline=%.2f", g.m_total, g.m_baseline);
+	printf(" result=%s\n", (g.m_nfailed) ? "FAIL" : "pass");
+	return (g.m_nfailed) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,419 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	jobs.c
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	Asynchronous move computation, on a fixed pool of worker
+//		threads.  See jobs.h for the interface.
+//
+//	Every job works on its own copy of its game, so nothing here needs to
+//	hold a game's lock--there isn't one.  The engine's lock protects the
+//	queue, and every job's state.  Cancellation is the one exception: the
+//	workers check for it so often that it's kept in a flag of its own,
+//	read without taking the lock.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#define	_POSIX_C_SOURCE	200809L
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "jobs.h"
+
+struct	TTTT_ENGINE_S {
+	pthread_mutex_t	m_lock;
+	// m_work is signalled when a job is queued, m_finished whenever a job
+	// is done or cancelled
+	pthread_cond_t	m_work, m_finished;
+	// The queue of jobs waiting for a worker
+	LPTTTT_JOB	m_head, m_tail;
+	int		m_nthreads;
+	pthread_t	*m_threads;
+	// m_quit tells the workers to stop.  Once the engine has been freed
+	// (m_freed), its memory lingers until the last job (of m_njobs) is.
+	int		m_quit;
+	bool		m_freed;
+	int		m_njobs;
+};
+
+struct	TTTT_JOB_S {
+	LPTTTT_ENGINE	m_engine;
+	LPTTTT		m_game;
+	unsigned	m_budget;
+	struct timespec	m_deadline;
+	TTTT_JOBSTATE	m_state;
+	// m_cancel is read by the worker without the lock
+	int		m_cancel;
+	// m_notifying is set while the done function is being called, and
+	// m_detached once the job has been freed by its owner
+	bool		m_notifying, m_detached;
+	int		m_move;
+	TTTT_RESULT	m_result;
+	TTTT_JOBFN	m_done;
+	void		*m_arg;
+	LPTTTT_JOB	m_prev, m_next;
+};
+
+/*
+ * engine_release
+ *
+ * Free what's left of an engine.  Call with the lock released, and only once
+ * both the engine and all of its jobs have been freed.
+ */
+static void
+engine_release(LPTTTT_ENGINE e) {
+	pthread_mutex_destroy(&e->m_lock);
+	pthread_cond_destroy(&e->m_work);
+	pthread_cond_destroy(&e->m_finished);
+	free(e->m_threads);
+	free(e);
+}
+
+/*
+ * job_release
+ *
+ * Free a job, and its engine too if this was the last thing keeping the
+ * engine around.  Call with the lock held.  Returns true if the engine
+ * needs to be released (once the lock is).
+ */
+static bool
+job_release(LPTTTT_JOB job) {
+	LPTTTT_ENGINE	e = job->m_engine;
+
+	tttt_free(job->m_game);
+	free(job);
+	e->m_njobs--;
+	return (e->m_freed)&&(e->m_njobs == 0);
+}
+
+/*
+ * dequeue
+ *
+ * Remove a job from the queue.  Call with the lock held.
+ */
+static void
+dequeue(LPTTTT_ENGINE e, LPTTTT_JOB job) {
+	if (job->m_prev)
+		job->m_prev->m_next = job->m_next;
+	else
+		e->m_head = job->m_next;
+	if (job->m_next)
+		job->m_next->m_prev = job->m_prev;
+	else
+		e->m_tail = job->m_prev;
+	job->m_prev = job->m_next = NULL;
+}
+
+/*
+ * finish
+ *
+ * Move a job into its final state, and tell its owner.  Call with the lock
+ * held.  The lock is released while the done function is called.  Returns
+ * true if the engine needs to be released.
+ */
+static bool
+finish(LPTTTT_ENGINE e, LPTTTT_JOB job, TTTT_JOBSTATE state) {
+	job->m_state = state;
+	pthread_cond_broadcast(&e->m_finished);
+
+	if (job->m_detached)
+		return job_release(job);
+	if (!job->m_done)
+		return false;
+
+	job->m_notifying = true;
+	pthread_mutex_unlock(&e->m_lock);
+	job->m_done(job->m_arg, job);
+	pthread_mutex_lock(&e->m_lock);
+	job->m_notifying = false;
+
+	if (job->m_detached)
+		return job_release(job);
+	return false;
+}
+
+/*
+ * job_stop
+ *
+ * The stop function handed to the engine.  We stop if the job's been
+ * cancelled, if the engine is shutting down, or if the job is out of time.
+ */
+static bool
+job_stop(void *arg) {
+	LPTTTT_JOB	job = (LPTTTT_JOB)arg;
+	struct timespec	now;
+
+	if ((__atomic_load_n(&job->m_cancel, __ATOMIC_RELAXED))
+		||(__atomic_load_n(&job->m_engine->m_quit, __ATOMIC_RELAXED)))
+		return true;
+	if (job->m_budget == 0)
+		return false;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec > job->m_deadline.tv_sec)
+		||((now.tv_sec == job->m_deadline.tv_sec)
+			&&(now.tv_nsec >= job->m_deadline.tv_nsec));
+}
+
+/*
+ * worker
+ *
+ * Each worker pulls jobs off of the queue, and works them out until the
+ * engine is told to quit.
+ */
+static void *
+worker(void *arg) {
+	LPTTTT_ENGINE	e = (LPTTTT_ENGINE)arg;
+	LPTTTT_JOB	job;
+	bool		cancelled;
+
+	pthread_mutex_lock(&e->m_lock);
+	for(;;) {
+		while((!e->m_head)&&(!e->m_quit))
+			pthread_cond_wait(&e->m_work, &e->m_lock);
+		if (!e->m_head)
+			break;
+
+		job = e->m_head;
+		dequeue(e, job);
+		job->m_state = TTTT_JOB_RUNNING;
+		pthread_mutex_unlock(&e->m_lock);
+
+		if (job->m_budget) {
+			clock_gettime(CLOCK_MONOTONIC, &job->m_deadline);
+			job->m_deadline.tv_sec  += job->m_budget / 1000000;
+			job->m_deadline.tv_nsec += (job->m_budget % 1000000)
+							* 1000;
+			if (job->m_deadline.tv_nsec >= 1000000000) {
+				job->m_deadline.tv_sec++;
+				job->m_deadline.tv_nsec -= 1000000000;
+			}
+		}
+
+		job->m_move = -1;
+		job->m_result = tttt_askmove_until(job->m_game, &job->m_move,
+				job_stop, job);
+		cancelled = (__atomic_load_n(&job->m_cancel, __ATOMIC_RELAXED))
+			||(__atomic_load_n(&e->m_quit, __ATOMIC_RELAXED));
+
+		pthread_mutex_lock(&e->m_lock);
+		// The engine can't be released here: tttt_engine_free() is
+		// still waiting on us
+		finish(e, job, (cancelled) ? TTTT_JOB_CANCELLED
+				: TTTT_JOB_DONE);
+	}
+	pthread_mutex_unlock(&e->m_lock);
+
+	return NULL;
+}
+
+LPTTTT_ENGINE	tttt_engine_new(int nthreads) {
+	LPTTTT_ENGINE	e;
+
+	if (nthreads <= 0)
+		return NULL;
+
+	e = (LPTTTT_ENGINE)calloc(1, sizeof(TTTT_ENGINE));
+	if (!e)
+		return NULL;
+	e->m_threads = (pthread_t *)calloc(nthreads, sizeof(pthread_t));
+	if (!e->m_threads) {
+		free(e);
+		return NULL;
+	}
+
+	pthread_mutex_init(&e->m_lock, NULL);
+	pthread_cond_init(&e->m_work, NULL);
+	pthread_cond_init(&e->m_finished, NULL);
+
+	for(e->m_nthreads=0; e->m_nthreads<nthreads; e->m_nthreads++) {
+		if (pthread_create(&e->m_threads[e->m_nthreads], NULL,
+				worker, e) != 0) {
+			tttt_engine_free(e);
+			return NULL;
+		}
+	}
+
+	return e;
+}
+
+void	tttt_engine_free(LPTTTT_ENGINE e) {
+	LPTTTT_JOB	job;
+	bool		release;
+	int		i;
+
+	if (!e)
+		return;
+
+	pthread_mutex_lock(&e->m_lock);
+	__atomic_store_n(&e->m_quit, 1, __ATOMIC_RELAXED);
+	while(NULL != (job = e->m_head)) {
+		dequeue(e, job);
+		finish(e, job, TTTT_JOB_CANCELLED);
+	}
+	pthread_cond_broadcast(&e->m_work);
+	pthread_mutex_unlock(&e->m_lock);
+
+	for(i=0; i<e->m_nthreads; i++)
+		pthread_join(e->m_threads[i], NULL);
+
+	pthread_mutex_lock(&e->m_lock);
+	e->m_freed = true;
+	release = (e->m_njobs == 0);
+	pthread_mutex_unlock(&e->m_lock);
+
+	if (release)
+		engine_release(e);
+}
+
+LPTTTT_JOB	tttt_job_submit(LPTTTT_ENGINE e, LPTTTT g, unsigned budget,
+			TTTT_JOBFN done, void *arg) {
+	LPTTTT_JOB	job;
+
+	if ((!e)||(!g))
+		return NULL;
+
+	job = (LPTTTT_JOB)calloc(1, sizeof(TTTT_JOB));
+	if (!job)
+		return NULL;
+	job->m_game = tttt_clone(g);
+	if (!job->m_game) {
+		free(job);
+		return NULL;
+	}
+
+	job->m_engine = e;
+	job->m_budget = budget;
+	job->m_state  = TTTT_JOB_PENDING;
+	job->m_move   = -1;
+	job->m_result = TTTT_STOPPED;
+	job->m_done   = done;
+	job->m_arg    = arg;
+
+	pthread_mutex_lock(&e->m_lock);
+	e->m_njobs++;
+	if (e->m_quit) {
+		// Too late.  The workers are gone
+		finish(e, job, TTTT_JOB_CANCELLED);
+	} else {
+		job->m_prev = e->m_tail;
+		if (e->m_tail)
+			e->m_tail->m_next = job;
+		else
+			e->m_head = job;
+		e->m_tail = job;
+		pthread_cond_signal(&e->m_work);
+	}
+	pthread_mutex_unlock(&e->m_lock);
+
+	return job;
+}
+
+TTTT_JOBSTATE	tttt_job_poll(LPTTTT_JOB job) {
+	TTTT_JOBSTATE	state;
+
+	pthread_mutex_lock(&job->m_engine->m_lock);
+	state = job->m_state;
+	pthread_mutex_unlock(&job->m_engine->m_lock);
+
+	return state;
+}
+
+TTTT_JOBSTATE	tttt_job_wait(LPTTTT_JOB job) {
+	LPTTTT_ENGINE	e = job->m_engine;
+	TTTT_JOBSTATE	state;
+
+	pthread_mutex_lock(&e->m_lock);
+	while((job->m_state == TTTT_JOB_PENDING)
+			||(job->m_state == TTTT_JOB_RUNNING))
+		pthread_cond_wait(&e->m_finished, &e->m_lock);
+	state = job->m_state;
+	pthread_mutex_unlock(&e->m_lock);
+
+	return state;
+}
+
+void	tttt_job_cancel(LPTTTT_JOB job) {
+	LPTTTT_ENGINE	e = job->m_engine;
+	bool		release = false;
+
+	pthread_mutex_lock(&e->m_lock);
+	if (job->m_state == TTTT_JOB_PENDING) {
+		dequeue(e, job);
+		release = finish(e, job, TTTT_JOB_CANCELLED);
+	} else if (job->m_state == TTTT_JOB_RUNNING)
+		__atomic_store_n(&job->m_cancel, 1, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&e->m_lock);
+
+	if (release)
+		engine_release(e);
+}
+
+TTTT_RESULT	tttt_job_result(LPTTTT_JOB job, int *where) {
+	TTTT_RESULT	r = TTTT_STOPPED;
+
+	if ((!job)||(!where))
+		return TTTT_BADARG;
+
+	pthread_mutex_lock(&job->m_engine->m_lock);
+	if (job->m_state == TTTT_JOB_DONE) {
+		r = job->m_result;
+		if (r == TTTT_OK)
+			*where = job->m_move;
+	}
+	pthread_mutex_unlock(&job->m_engine->m_lock);
+
+	return r;
+}
+
+void	tttt_job_free(LPTTTT_JOB job) {
+	LPTTTT_ENGINE	e;
+	bool		release = false;
+
+	if (!job)
+		return;
+
+	e = job->m_engine;
+	pthread_mutex_lock(&e->m_lock);
+	if (job->m_state == TTTT_JOB_PENDING) {
+		dequeue(e, job);
+		release = job_release(job);
+	} else if ((job->m_state == TTTT_JOB_RUNNING)||(job->m_notifying)) {
+		// The worker will free it once it's through
+		__atomic_store_n(&job->m_cancel, 1, __ATOMIC_RELAXED);
+		job->m_detached = true;
+	} else
+		release = job_release(job);
+	pthread_mutex_unlock(&e->m_lock);
+
+	if (release)
+		engine_release(e);
+}
@@ -0,0 +1,130 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	jobs.h
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	Asynchronous move computation.  Rather than calling tttt_askmove()
+//		and waiting for its answer, a program may submit the question
+//	to a fixed pool of worker threads (an engine), and then poll for, wait
+//	on, or cancel the answer while it does other things.
+//
+//	This uses POSIX threads, and so only builds on the (Linux) host.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#ifndef	JOBS_H
+#define	JOBS_H
+
+#include "tttt.h"
+
+typedef	struct	TTTT_ENGINE_S	TTTT_ENGINE, *LPTTTT_ENGINE;
+typedef	struct	TTTT_JOB_S	TTTT_JOB, *LPTTTT_JOB;
+
+typedef	enum	TTTT_JOBSTATE_E {
+	TTTT_JOB_PENDING = 0,	// Waiting for a worker
+	TTTT_JOB_RUNNING,	// A worker is thinking about it
+	TTTT_JOB_DONE,		// Finished.  The answer is ready
+	TTTT_JOB_CANCELLED	// Cancelled before it finished.  No answer
+} TTTT_JOBSTATE;
+
+// Called, if given, once a job is either done or cancelled.  This is called
+// from the worker that finished the job or, for a job cancelled before any
+// worker picked it up, from the thread that cancelled it.  It must not free
+// the job.
+typedef	void	(*TTTT_JOBFN)(void *arg, LPTTTT_JOB job);
+
+/*
+ * tttt_engine_new
+ *
+ * Start an engine with nthreads worker threads.  Returns NULL if the threads
+ * (or the memory for them) can't be had.
+ */
+extern	LPTTTT_ENGINE	tttt_engine_new(int nthreads);
+
+/*
+ * tttt_engine_free
+ *
+ * Cancel every job not yet done, wait for the workers to quit, and release
+ * the engine.  Jobs not yet freed remain valid, and must still be freed--the
+ * last of the engine's memory is released with the last of its jobs.
+ */
+extern	void	tttt_engine_free(LPTTTT_ENGINE e);
+
+/*
+ * tttt_job_submit
+ *
+ * Ask the engine where it would move in game g.  The job works on its own
+ * copy of the game (see tttt_clone()), so g may be played on, or even freed,
+ * while the job runs.  If budget is non-zero, the job is given at most that
+ * many microseconds to think before answering with its best move so far.
+ * done(arg, job) is called once the job finishes.  Returns NULL if no memory
+ * is available.
+ */
+extern	LPTTTT_JOB	tttt_job_submit(LPTTTT_ENGINE e, LPTTTT g,
+				unsigned budget, TTTT_JOBFN done, void *arg);
+
+/*
+ * tttt_job_poll, tttt_job_wait
+ *
+ * Return the state the job is in, either immediately or once the job is done
+ * or cancelled.
+ */
+extern	TTTT_JOBSTATE	tttt_job_poll(LPTTTT_JOB job);
+extern	TTTT_JOBSTATE	tttt_job_wait(LPTTTT_JOB job);
+
+/*
+ * tttt_job_cancel
+ *
+ * Abandon a job.  A job still waiting is cancelled at once, one that is
+ * running is cancelled at the next point where the engine checks, normally
+ * within a few microseconds.  Cancelling a job that is already done does
+ * nothing.
+ */
+extern	void	tttt_job_cancel(LPTTTT_JOB job);
+
+/*
+ * tttt_job_result
+ *
+ * Get the answer to a job.  Returns the result of tttt_askmove_until(),
+ * with the move in *where when TTTT_OK, or TTTT_STOPPED if the job was
+ * cancelled or isn't yet done.
+ */
+extern	TTTT_RESULT	tttt_job_result(LPTTTT_JOB job, int *where);
+
+/*
+ * tttt_job_free
+ *
+ * Release a job.  A job still pending or running is cancelled, without its
+ * done function being called, and then freed once its worker lets go of it.
+ */
+extern	void	tttt_job_free(LPTTTT_JOB job);
+
+#endif
@@ -0,0 +1,217 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	latency.c
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	Log bucketed histograms of move times.  See latency.h.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#define	_POSIX_C_SOURCE	200809L
+#include <time.h>
+#include "latency.h"
+
+uint64_t
+lat_now(void)
+{
+#ifdef	CLOCK_MONOTONIC
+	struct timespec	ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+		return ts.tv_sec * (uint64_t)1000000000 + ts.tv_nsec;
+#endif
+	return 0;
+}
+
+/*
+ * bucket
+ *
+ * The bucket a time falls into.  Times below 2*LAT_SUBBUCKETS are their own
+ * bucket.  Otherwise, the top LAT_SUBBITS+1 bits of the time, along with the
+ * position of the topmost, pick it.
+ */
+static int
+bucket(uint64_t nsecs)
+{
+	int	shift;
+
+	if (nsecs >> LAT_MAXBITS)
+		return LAT_NBUCKETS-1;
+	if (nsecs < 2*LAT_SUBBUCKETS)
+		return (int)nsecs;
+	shift = 63 - __builtin_clzll(nsecs) - LAT_SUBBITS;
+	return (shift << LAT_SUBBITS) + (int)(nsecs >> shift);
+}
+
+/*
+ * bucketmax
+ *
+ * The longest time falling into a given bucket
+ */
+static uint64_t
+bucketmax(int idx)
+{
+	int	shift;
+
+	if (idx < 2*LAT_SUBBUCKETS)
+		return idx;
+	shift = (idx >> LAT_SUBBITS) - 1;
+	return ((uint64_t)(LAT_SUBBUCKETS + (idx & (LAT_SUBBUCKETS-1)) + 1)
+			<< shift) - 1;
+}
+
+void
+lat_clear(LPLATHIST h)
+{
+	int	k;
+
+	h->m_count = 0;
+	h->m_total = 0;
+	h->m_max   = 0;
+	for(k=0; k<LAT_NBUCKETS; k++)
+		h->m_buckets[k] = 0;
+}
+
+void
+lat_record(LPLATHIST h, uint64_t nsecs)
+{
+	h->m_count++;
+	h->m_total += nsecs;
+	if (nsecs > h->m_max)
+		h->m_max = nsecs;
+	h->m_buckets[bucket(nsecs)]++;
+}
+
+void
+lat_merge(LPLATHIST dst, const LATHIST *src)
+{
+	int	k;
+
+	dst->m_count += src->m_count;
+	dst->m_total += src->m_total;
+	if (src->m_max > dst->m_max)
+		dst->m_max = src->m_max;
+	for(k=0; k<LAT_NBUCKETS; k++)
+		dst->m_buckets[k] += src->m_buckets[k];
+}
+
+uint64_t
+lat_percentile(const LATHIST *h, double pct)
+{
+	unsigned long	rank, seen = 0;
+	uint64_t	v;
+	int		k;
+
+	if (h->m_count == 0)
+		return 0;
+	if (pct >= 100)
+		return h->m_max;
+
+	// The rank, counting from one, of the time we're after
+	rank = (unsigned long)(pct * h->m_count / 100.0 + 0.999999);
+	if (rank < 1)
+		rank = 1;
+	for(k=0; k<LAT_NBUCKETS; k++) {
+		seen += h->m_buckets[k];
+		if (seen >= rank)
+			break;
+	}
+
+	v = bucketmax(k);
+	return (v > h->m_max) ? h->m_max : v;
+}
+
+void
+lat_tclear(LPLATTABLE t)
+{
+	int	k, f;
+
+	t->m_nlevels = 0;
+	t->m_dropped = 0;
+	for(k=0; k<LAT_MAXLEVELS; k++)
+		for(f=0; f<LAT_NFILLS; f++)
+			lat_clear(&t->m_hist[k][f]);
+}
+
+/*
+ * findlevel
+ *
+ * Find the row of the table for a difficulty level, adding one if need be.
+ * Returns -1 if the table is full.
+ */
+static int
+findlevel(LPLATTABLE t, int level)
+{
+	int	k;
+
+	for(k=0; k<t->m_nlevels; k++)
+		if (t->m_levels[k] == level)
+			return k;
+	if (t->m_nlevels >= LAT_MAXLEVELS)
+		return -1;
+	t->m_levels[t->m_nlevels] = level;
+	return t->m_nlevels++;
+}
+
+void
+lat_trecord(LPLATTABLE t, int level, int nfilled, uint64_t nsecs)
+{
+	int	k, f;
+
+	k = findlevel(t, level);
+	if (k < 0) {
+		t->m_dropped++;
+		return;
+	}
+
+	f = nfilled / LAT_FILLSTEP;
+	if (f >= LAT_NFILLS)
+		f = LAT_NFILLS-1;
+	lat_record(&t->m_hist[k][f], nsecs);
+}
+
+void
+lat_tmerge(LPLATTABLE dst, const LATTABLE *src)
+{
+	int	k, d, f;
+
+	dst->m_dropped += src->m_dropped;
+	for(k=0; k<src->m_nlevels; k++) {
+		d = findlevel(dst, src->m_levels[k]);
+		for(f=0; f<LAT_NFILLS; f++) {
+			if (d >= 0)
+				lat_merge(&dst->m_hist[d][f],
+					&src->m_hist[k][f]);
+			else
+				dst->m_dropped += src->m_hist[k][f].m_count;
+		}
+	}
+}
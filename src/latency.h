@@ -0,0 +1,130 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	latency.h
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	Histograms of how long the computer takes to choose its moves,
+//		kept by difficulty level and by how full the board is.  An
+//	average hides the few positions that take far longer than the rest,
+//	so these keep enough to report percentiles instead.
+//
+//	Like HdrHistogram, each histogram is log bucketed: times (in
+//	nanoseconds) below 2*LAT_SUBBUCKETS get a bucket apiece, and above
+//	that every power of two is split into LAT_SUBBUCKETS buckets.  Any
+//	percentile is thus found to within 1/LAT_SUBBUCKETS (about 6%) of the
+//	time recorded, while a histogram reaching to over four seconds takes
+//	under two kilobytes.  Longer times are counted in the last bucket.
+//	The longest time of all is kept exactly.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#ifndef	LATENCY_H
+#define	LATENCY_H
+
+#include <stdint.h>
+#include "gboard.h"
+
+#define	LAT_SUBBITS	4
+#define	LAT_SUBBUCKETS	(1<<LAT_SUBBITS)
+// Times up to 2^LAT_MAXBITS nanoseconds
+#define	LAT_MAXBITS	32
+#define	LAT_NBUCKETS	((LAT_MAXBITS-LAT_SUBBITS+1)*LAT_SUBBUCKETS)
+
+// The number of difficulty levels a table may keep apart
+#define	LAT_MAXLEVELS	16
+// Boards are grouped by their number of filled squares into LAT_NFILLS
+// groups, of LAT_FILLSTEP squares apiece
+#define	LAT_NFILLS	8
+#define	LAT_FILLSTEP	((NUM_SQUARES+LAT_NFILLS-1)/LAT_NFILLS)
+
+typedef	struct	LATHIST_S {
+	unsigned long	m_count;
+	uint64_t	m_total, m_max;
+	uint32_t	m_buckets[LAT_NBUCKETS];
+} LATHIST, *LPLATHIST;
+
+typedef	struct	LATTABLE_S {
+	int	m_nlevels, m_levels[LAT_MAXLEVELS];
+	// Moves at any level past the first LAT_MAXLEVELS, counted but not
+	// timed
+	unsigned long	m_dropped;
+	LATHIST	m_hist[LAT_MAXLEVELS][LAT_NFILLS];
+} LATTABLE, *LPLATTABLE;
+
+/*
+ * lat_now
+ *
+ * The time, from some arbitrary start, in nanoseconds--or zero, if there's no
+ * clock to be had.
+ */
+extern	uint64_t	lat_now(void);
+
+/*
+ * lat_clear, lat_record, lat_merge
+ *
+ * Empty a histogram, add one time to it (in nanoseconds), or add every time
+ * from another histogram into it.
+ */
+extern	void	lat_clear(LPLATHIST h);
+extern	void	lat_record(LPLATHIST h, uint64_t nsecs);
+extern	void	lat_merge(LPLATHIST dst, const LATHIST *src);
+
+/*
+ * lat_percentile
+ *
+ * The time (in nanoseconds) that pct percent of those recorded took no more
+ * than, give or take the width of a bucket.  lat_percentile(h, 100) is the
+ * longest time recorded, exactly.
+ */
+extern	uint64_t	lat_percentile(const LATHIST *h, double pct);
+
+/*
+ * lat_tclear, lat_trecord, lat_tmerge
+ *
+ * The same, for a table of histograms: a time is recorded by the difficulty
+ * level the move was chosen at, and the number of squares filled before it.
+ */
+extern	void	lat_tclear(LPLATTABLE t);
+extern	void	lat_trecord(LPLATTABLE t, int level, int nfilled,
+			uint64_t nsecs);
+extern	void	lat_tmerge(LPLATTABLE dst, const LATTABLE *src);
+
+/*
+ * lat_print
+ *
+ * Write out, to stdout, the count, the 50th, 90th, and 99th percentiles, and
+ * the longest time (in microseconds) for every level, and for every group of
+ * fill counts within every level.  This is found in display.c, with the rest
+ * of the routines that print.
+ */
+extern	void	lat_print(const LATTABLE *t);
+
+#endif
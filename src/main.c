@@ -47,40 +47,171 @@
 #include "gboard.h"
 #include "comboset.h"
 #include "strategy.h"
+#include "record.h"
+#include "ponder.h"
+
+#ifdef	__ZIPCPU__
+#include "board.h"
+#else
+#include <pthread.h>
+#endif
+
+/*
+ * PONDERJOB
+ *
+ * While the user thinks about their move, the computer thinks about its reply.
+ * On the host this happens in a second thread, which we stop as soon as the
+ * user's move arrives.  The ZipCPU has no threads, so there we ponder one
+ * step at a time while polling the UART for the user's first keystroke.
+ */
+typedef	struct	PONDERJOB_S {
+	PONDER		m_ponder;
+#ifndef	__ZIPCPU__
+	pthread_t	m_thread;
+	pthread_mutex_t	m_lock;
+	bool		m_stop, m_running;
+#endif
+} PONDERJOB, *LPPONDERJOB;
+
+#ifdef	__ZIPCPU__
+/*
+ * inputready
+ *
+ * Returns true if the UART has received a character we've not yet read.
+ */
+static	bool	inputready(void) {
+	return (_uart->u_fifo & 1) ? true : false;
+}
+
+static	void	ponder_begin(LPPONDERJOB pj, LPSTRATEGY s, LPGBOARD brd,
+			LPCOMBOSET cs) {
+	ponder_start(&pj->m_ponder, s, brd, cs, GB_WHITE);
+}
+
+static	void	ponder_wait(LPPONDERJOB pj) {
+	while((!inputready())&&(ponder_step(&pj->m_ponder)))
+		;
+}
+
+static	void	ponder_end(LPPONDERJOB pj) {
+}
+#else
+static	void	*ponder_thread(void *arg) {
+	LPPONDERJOB	pj = (LPPONDERJOB)arg;
+	bool		stop;
+
+	do {
+		pthread_mutex_lock(&pj->m_lock);
+		stop = pj->m_stop;
+		pthread_mutex_unlock(&pj->m_lock);
+	} while((!stop)&&(ponder_step(&pj->m_ponder)));
+
+	return NULL;
+}
+
+static	void	ponder_begin(LPPONDERJOB pj, LPSTRATEGY s, LPGBOARD brd,
+			LPCOMBOSET cs) {
+	ponder_start(&pj->m_ponder, s, brd, cs, GB_WHITE);
+	pj->m_stop = false;
+	pthread_mutex_init(&pj->m_lock, NULL);
+	pj->m_running = (0 == pthread_create(&pj->m_thread, NULL,
+				ponder_thread, pj));
+	if (!pj->m_running)
+		pthread_mutex_destroy(&pj->m_lock);
+}
+
+static	void	ponder_wait(LPPONDERJOB pj) {
+	// The thread is already doing our pondering for us
+}
+
+static	void	ponder_end(LPPONDERJOB pj) {
+	if (!pj->m_running)
+		return;
+	pthread_mutex_lock(&pj->m_lock);
+	pj->m_stop = true;
+	pthread_mutex_unlock(&pj->m_lock);
+	pthread_join(pj->m_thread, NULL);
+	pthread_mutex_destroy(&pj->m_lock);
+	pj->m_running = false;
+}
+#endif
+
+static	const char	*numbers[] = { "zero", "one", "two", "three", "four",
+		"five", "six", "seven", "eight", "nine" };
 
 void	print_instructions(void) {
+	char	name[2*NUM_DIMS];
+	int	i;
+
+	for(i=0; i<NUM_DIMS; i++) {
+		name[2*i] = '0' + NUM_ON_SIDE;
+		name[2*i+1] = (i+1 < NUM_DIMS) ? 'x' : '\0';
+	}
+
 	printf(
-"\n\n\n\nWelcome to 4x4x4 Tic-Tac-Toe\n"
+"\n\n\n\nWelcome to %s Tic-Tac-Toe\n"
 "\n"
-"The goal of this game is to get 4 pieces in a row.  The board is three\n"
+"The goal of this game is to get %d pieces in a row.  ", name, NUM_ON_SIDE);
+
+	if (NUM_DIMS == 2)
+		printf(
+"Rows, columns, and both\n"
+"diagonals all count.\n");
+	else
+		printf(
+"The board is three\n"
 "dimensional, even though it will be displayed on a terminal screen.  Imagine\n"
-"instead of seeing four 4x4 boards side by side, that these boards are\n"
-"actually standing on top of each other.  A winning four in a row can exist\n"
-"on any of the 4x4 levels.  A winning four in a row can also cross through\n"
-"all levels.  Diagonals are valid, as are diagonal diagonals.\n"
+"instead of seeing %s %dx%d boards side by side, that these boards are\n"
+"actually standing on top of each other.  A winning %s in a row can exist\n"
+"on any of the %dx%d levels.  A winning %s in a row can also cross through\n"
+"all levels.  Diagonals are valid, as are diagonal diagonals.\n",
+		numbers[NUM_ON_SIDE], NUM_ON_SIDE, NUM_ON_SIDE,
+		numbers[NUM_ON_SIDE], NUM_ON_SIDE, NUM_ON_SIDE,
+		numbers[NUM_ON_SIDE]);
+	if (NUM_DIMS > 3)
+		printf(
+"\n"
+"This board has a fourth dimension as well.  It is drawn as %s groups of\n"
+"boards, one group above the next, and a winning row may cross through all\n"
+"of the groups just as it may cross through all of the levels.\n",
+		numbers[NUM_ON_SIDE]);
+
+	printf(
 "\n"
-"To specify your move, type in a string of three numbers each in the range of\n"
-"1-4.  The first two numbers describe where you wish to move within one 4x4\n"
+"To specify your move, type in a string of %s numbers each in the range of\n"
+"1-%d.  The first two numbers describe where you wish to move within one %dx%d\n"
 "board, where the first number is the position counting left to right and the\n"
-"second number is the position counting from top down.  The last number is\n"
-"which 4x4 board you wish to move to, counting from the 4x4 on the left to\n"
-"the right\n\n");
+"second number is the position counting from top down.",
+		numbers[NUM_DIMS], NUM_ON_SIDE, NUM_ON_SIDE, NUM_ON_SIDE);
+	if (NUM_DIMS > 2)
+		printf(
+"  The third number is\n"
+"which %dx%d board you wish to move to, counting from the %dx%d on the left to\n"
+"the right", NUM_ON_SIDE, NUM_ON_SIDE, NUM_ON_SIDE, NUM_ON_SIDE);
+	if (NUM_DIMS > 3)
+		printf(
+", and the last is which group of boards, counting from the top down");
+	printf("\n\n");
 }
 
 /*
  * getmove
  *
  * Invoke fgets to get a line of input data from the user.  We'll take the
- * first three digits the user gives us and try to map them into a position.
+ * first NUM_DIMS digits the user gives us and try to map them into a
+ * position.
  * We'll return -1 on an invalid move, or -2 on any other reason (such as one
  * where we need to shut down (EOF)).
+ *
+ * Until the user starts typing, the computer ponders its reply.
  */
-int	getmove(void) {
+int	getmove(LPPONDERJOB pj) {
 	char	line[40], *ptr = line;
-	int	x=0, y=0, z=0;
+	int	c[NUM_DIMS], axis;
 
 	// Request the user give us a move
 	printf("Your move : "); fflush(stdout);
+	ponder_wait(pj);
 
 	if (NULL == fgets(line, sizeof(line), stdin)) {
 		printf("EOF!\n");
@@ -96,24 +227,15 @@ int	getmove(void) {
 		return -1;
 	}
 
-	while((*ptr)&&(!isdigit(*ptr)))
-		ptr++;
-	if (!*ptr) return -1;	// If no digits are given, its an invalid move
-	x = *ptr++ - '0' - 1;
-	
-	while((*ptr)&&(!isdigit(*ptr)))
-		ptr++;
-	if (!*ptr)	// If only one digit is given, its also invalid
-		return -1;
-	y = *ptr++ - '0' - 1;
-	
-	while((*ptr)&&(!isdigit(*ptr)))
-		ptr++;
-	if (!*ptr)	// If only two digits are given, its also invalid
-		return -1;
-	z = *ptr++ - '0' - 1;
+	for(axis=0; axis<NUM_DIMS; axis++) {
+		while((*ptr)&&(!isdigit(*ptr)))
+			ptr++;
+		if (!*ptr)	// If too few digits are given, its invalid
+			return -1;
+		c[axis] = *ptr++ - '0' - 1;
+	}
 
-	return coordtoint(x, y, z);
+	return gb_square(c);
 }
 
 /*
@@ -124,41 +246,85 @@ int	getmove(void) {
  * the computer.  It also includes requesting the user input, and causing the
  * game board to be printed after ever move of the computers.
  *
+ * The random number state is passed in, and handed back on return, so that
+ * subsequent games (on the ZipCPU) don't repeat the same choices.  If a
+ * record writer is given, the game is written to it once over.
  */
-void	play_game(void) {
+void	play_game(unsigned *seed, LPRECWRITER rw) {
 	GBOARD		brd;
 	COMBOSET	cs;
 	STRATEGY	s;
+	GAMEREC		rec;
+	static	PONDERJOB	pj;
 
 	gb_reset(&brd);
 	set_difficulty(&s, 1000);
+	set_seed(&s, *seed);
 	cs_init(&cs);
 
+	rec.m_seed = *seed;
+	rec.m_difficulty[0] = REC_HUMAN;
+	rec.m_difficulty[1] = s.m_difficulty_level;
+	rec.m_nmoves = 0;
+
 	while(!gb_gameover(&brd)) {
-		int	mv;
+		int	mv, axis;
 
 		gb_print(&brd);
+		ponder_begin(&pj, &s, &brd, &cs);
 		do {
-			mv = getmove();
-			if (mv < -1)
+			mv = getmove(&pj);
+			if (mv < -1) {
+				ponder_end(&pj);
+				*seed = s.m_seed;
+				if (rw) {
+					rec.m_result = GB_NOONE;
+					rec_write(rw, &rec);
+				}
 				return;
+			}
 		} while(!legal(&brd, GB_BLACK, mv));
+		ponder_end(&pj);
 
 		gb_place(&brd, GB_BLACK, mv);
+		rec.m_moves[rec.m_nmoves++] = mv;
 		if (!cs_place(&cs,  GB_BLACK, mv)) {
-			mv = makemove(&s, &brd, &cs, GB_WHITE);
+			VSET	reply;
+
+			// If we've already thought about this move, we don't
+			// need to think about it again
+			if (ponder_reply(&pj.m_ponder, mv, &reply))
+				mv = vs_pickmember(&reply, &s.m_seed);
+			else
+				mv = makemove(&s, &brd, &cs, GB_WHITE);
+			if (mv < 0) {
+				// No moves are left, the board is full
+				brd.m_winner = GB_TIE;
+				break;
+			}
 
-			printf("The Computer moves (%d, %d, %d)\n\n",
-				xcoord(mv)+1, ycoord(mv)+1,
-				zcoord(mv)+1);
+			printf("The Computer moves (");
+			for(axis=0; axis<NUM_DIMS; axis++)
+				printf("%s%d", (axis) ? ", " : "",
+					gb_coord(mv, axis)+1);
+			printf(")\n\n");
 
 			gb_place(&brd, GB_WHITE, mv);
+			rec.m_moves[rec.m_nmoves++] = mv;
 			if (cs_place(&cs,  GB_WHITE, mv))
 				brd.m_winner = GB_WHITE;
+			else if (brd.m_nfilled >= NUM_SQUARES)
+				brd.m_winner = GB_TIE;
 		} else
 			brd.m_winner = GB_BLACK;
 	}
 
+	*seed = s.m_seed;
+	if (rw) {
+		rec.m_result = gb_winner(&brd);
+		rec_write(rw, &rec);
+	}
+
 	// Print the final (winning) copy of the board
 	gb_print(&brd);
 
@@ -166,6 +332,8 @@ void	play_game(void) {
 		printf("The computer wins\n");
 	else if (gb_winner(&brd) == GB_BLACK)
 		printf("CONGRATULATIONS, YOU WIN!!!!\n");
+	else if (gb_winner(&brd) == GB_TIE)
+		printf("The board is full.  It's a tie!\n");
 	else
 		printf("The game is over ... somehow.\n");
 }
@@ -173,14 +341,27 @@ void	play_game(void) {
 /*
  * main
  *
- * The classic entry point for any C program.
+ * The classic entry point for any C program.  The only argument we accept is
+ * "-r <file>", to record the game(s) played into <file>.
  */
 int	main(int argc, char **argv) {
-	time_t now;
+	unsigned	seed;
+	LPRECWRITER	rw = NULL;
+
+	if ((argc == 3)&&(argv[1][0] == '-')&&(argv[1][1] == 'r')) {
+		rw = rec_open(argv[2]);
+		if (!rw) {
+			perror("O/S Err: Cannot create record file");
+			exit(EXIT_FAILURE);
+		}
+	} else if (argc != 1) {
+		fprintf(stderr, "USAGE: tttt [-r <record-file>]\n");
+		exit(EXIT_FAILURE);
+	}
+
 	// Randomize the random number generator, so that we can truly pick
 	// our computer moves from a random set of equally valid moves.
-	now = time(NULL);
-	srand(now);
+	seed = (unsigned)time(NULL);
 
 	// Start by printing the instructions, before actually playing the game.
 	print_instructions();
@@ -193,5 +374,12 @@ int	main(int argc, char **argv) {
 #ifdef	__ZIPCPU__
 	while(1)
 #endif
-	play_game();
+	play_game(&seed, rw);
+
+	if ((rw)&&(!rec_close(rw))) {
+		perror("O/S Err: Cannot write record file");
+		exit(EXIT_FAILURE);
+	}
+
+	return 0;
 }
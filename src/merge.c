@@ -0,0 +1,191 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	merge.c
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	Adds up the tallies (see tally.h) written by every shard of an
+//		arena or analysis run, reporting what a single process playing
+//	the whole run would have.  Every shard of the run must be given, once
+//	each, and all must agree upon the run: the kind, the number of shards,
+//	the difficulty, the seed, and the number of games or positions.
+//
+//	The tallies are added in order of shard, not of the files given, so
+//	the report depends only upon the shards' results.  The counts are
+//	those of the unsharded run, however many shards it was split into;
+//	the times are, of course, only as repeatable as the machines taking
+//	them.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#define	_POSIX_C_SOURCE	200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "gboard.h"
+#include "latency.h"
+#include "tally.h"
+
+/*
+ * agree
+ *
+ * True if two shards' tallies are of the same run
+ */
+static bool
+agree(const TALLY *a, const TALLY *b) {
+	return (a->m_kind == b->m_kind)&&(a->m_nshards == b->m_nshards)
+		&&(a->m_difficulty[0] == b->m_difficulty[0])
+		&&(a->m_difficulty[1] == b->m_difficulty[1])
+		&&(a->m_seed == b->m_seed)&&(a->m_total == b->m_total)
+		&&((!a->m_lat) == (!b->m_lat));
+}
+
+static void
+usage(void) {
+	fprintf(stderr,
+"USAGE: tttt-merge [-o <tally-file>] <tally-file> ...\n"
+"\n"
+"\tAdds up the tallies written (with -o) by every shard (-k) of one\n"
+"\ttttt-arena or tttt-analyze run, and reports the results of the whole\n"
+"\n"
+"\t-o <file>\tAlso write the sum into <file>, as a run of one shard\n");
+}
+
+int	main(int argc, char **argv) {
+	TALLY		sum, *shards;
+	const char	*outfile = NULL, **fnames;
+	int		nfiles, opt, k, s;
+	uint64_t	nplayed = 0;
+
+	while((opt = getopt(argc, argv, "ho:")) != -1) {
+		switch(opt) {
+		case 'o': outfile = optarg; break;
+		default:
+			usage();
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	nfiles = argc - optind;
+	if (nfiles < 1) {
+		usage();
+		exit(EXIT_FAILURE);
+	}
+
+	// Read the first to learn how many shards there are, then place each
+	// file (the first included) by its shard
+	if (!tl_read(argv[optind], &sum)) {
+		fprintf(stderr, "ERR: Cannot read %s as a tally\n",
+			argv[optind]);
+		exit(EXIT_FAILURE);
+	}
+	if (nfiles != sum.m_nshards) {
+		fprintf(stderr, "ERR: The run has %d shards, but %d tallies"
+			" were given\n", sum.m_nshards, nfiles);
+		exit(EXIT_FAILURE);
+	}
+	tl_free(&sum);
+
+	shards = (LPTALLY)calloc(nfiles, sizeof(TALLY));
+	fnames = (const char **)calloc(nfiles, sizeof(const char *));
+	if ((!shards)||(!fnames)) {
+		fprintf(stderr, "ERR: Out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+
+	for(k=0; k<nfiles; k++) {
+		TALLY		t;
+		const char	*fname = argv[optind+k];
+
+		if (!tl_read(fname, &t)) {
+			fprintf(stderr, "ERR: Cannot read %s as a tally\n",
+				fname);
+			exit(EXIT_FAILURE);
+		}
+		s = t.m_shard;
+		if ((t.m_nshards != nfiles)||(fnames[s])) {
+			fprintf(stderr, "ERR: %s is shard %d/%d, which %s\n",
+				fname, s, t.m_nshards, (fnames[s])
+				? "was already given" : "isn't of this run");
+			exit(EXIT_FAILURE);
+		}
+		shards[s] = t;
+		fnames[s] = fname;
+	}
+
+	// Every shard is here, once.  Check they're all of the same run, and
+	// add them up.
+	sum = shards[0];
+	sum.m_shard = 0;
+	sum.m_nshards = 1;
+	sum.m_count = sum.m_errors = sum.m_nmoves = 0;
+	for(k=0; k<=GB_TIE; k++)
+		sum.m_wins[k] = 0;
+	if (shards[0].m_lat) {
+		sum.m_lat = (LPLATTABLE)malloc(sizeof(LATTABLE));
+		if (!sum.m_lat) {
+			fprintf(stderr, "ERR: Out of memory\n");
+			exit(EXIT_FAILURE);
+		}
+		lat_tclear(sum.m_lat);
+	}
+
+	for(s=0; s<nfiles; s++) {
+		if (!agree(&shards[0], &shards[s])) {
+			fprintf(stderr, "ERR: %s and %s are of different runs\n",
+				fnames[0], fnames[s]);
+			exit(EXIT_FAILURE);
+		}
+		tl_merge(&sum, &shards[s]);
+		nplayed += shards[s].m_count;
+	}
+
+	if (nplayed != sum.m_total) {
+		fprintf(stderr, "ERR: The shards hold %llu of the run's %llu %s\n",
+			(unsigned long long)nplayed,
+			(unsigned long long)sum.m_total,
+			(sum.m_kind == TL_ARENA) ? "games" : "positions");
+		exit(EXIT_FAILURE);
+	}
+
+	if ((outfile)&&(!tl_write(outfile, &sum))) {
+		perror("O/S Err: Cannot write tally file");
+		exit(EXIT_FAILURE);
+	}
+
+	tl_print(&sum);
+
+	for(s=0; s<nfiles; s++)
+		tl_free(&shards[s]);
+	tl_free(&sum);
+	free(shards);
+	free(fnames);
+	return EXIT_SUCCESS;
+}
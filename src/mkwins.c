@@ -0,0 +1,328 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	mkwins.c
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	Generate the tables describing every way to win, as C source.
+//		This is run on the host at build time, and its output
+//	compiled into the engine, so that the tables are const--able to live
+//	in flash (ROM) on the ZipCPU--and so that starting a new game is no
+//	more than a memcpy() of the initial COMBOSET.
+//
+//	Four tables are written: the initial COMBOSET itself, the squares of
+//	each line, the lines through each square, and the square (if any)
+//	where each pair of lines cross.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include "gboard.h"
+#include "comboset.h"
+
+/*
+ * mklines
+ *
+ * Set all of the various combo-rows to reference all of the possible ways to
+ * win on the board.  A line runs in some direction, where each coordinate
+ * either stays put, counts up, or counts down.  Since running a line
+ * backwards gives the same line, we only take those directions whose last
+ * moving coordinate counts up.  We then walk through every square, and start
+ * a line there in each direction that would stay on the board for all
+ * NUM_ON_SIDE squares--those where every coordinate counting up starts at
+ * zero, and every one counting down starts at the far side.
+ *
+ * Lines are ordered first by the number of coordinates that move: the rows
+ * and columns first, then the diagonals, then the diagonal diagonals, and
+ * so forth.
+ */
+static void
+mklines(LPCOMBOROW lines) {
+	int	idx, nmoving, ndirs, dir, sq, axis, t, d, n;
+	int	step[NUM_DIMS], start[NUM_DIMS], spots[NUM_ON_SIDE];
+
+	// There are 3^NUM_DIMS directions, counting the one that goes nowhere
+	ndirs = GB_POW(3);
+
+	idx = 0;
+	for(nmoving=1; nmoving<=NUM_DIMS; nmoving++)
+	for(dir=0; dir<ndirs; dir++) {
+		// Direction dir, as a base three number: 0 stays put, 1
+		// counts up, and 2 counts down
+		for(axis=0, d=dir, n=0; axis<NUM_DIMS; axis++, d/=3) {
+			step[axis] = (d%3 == 2) ? -1 : (d%3);
+			if (step[axis])
+				n++;
+		}
+		if (n != nmoving)
+			continue;
+		for(axis=NUM_DIMS-1; step[axis]==0; axis--)
+			;
+		if (step[axis] < 0)
+			continue;
+
+		for(sq=0; sq<NUM_SQUARES; sq++) {
+			for(axis=0; axis<NUM_DIMS; axis++) {
+				start[axis] = gb_coord(sq, axis);
+				if ((step[axis] > 0)&&(start[axis] != 0))
+					break;
+				if ((step[axis] < 0)
+					&&(start[axis] != NUM_ON_SIDE-1))
+					break;
+			} if (axis < NUM_DIMS)
+				continue;
+
+			for(t=0; t<NUM_ON_SIDE; t++) {
+				int	c[NUM_DIMS];
+
+				for(axis=0; axis<NUM_DIMS; axis++)
+					c[axis] = start[axis] + t*step[axis];
+				spots[t] = gb_square(c);
+			}
+
+			if (idx < NUM_COMBOROWS) {
+				cr_init(&lines[idx], spots);
+				lines[idx].m_id = idx;
+			} idx++;
+		}
+	}
+
+	// We're only ever run once, at build time, so we can afford to check
+	// our count against the one the headers were built with
+	if (idx != NUM_COMBOROWS) {
+		fprintf(stderr, "ERR: Generated %d lines, not %d\n",
+			idx, NUM_COMBOROWS);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/*
+ * crossing
+ *
+ * Return the square two lines share, or -1 if they don't cross.
+ */
+static int
+crossing(LPCOMBOROW a, LPCOMBOROW b) {
+	int	i, j;
+
+	for(i=0; i<NUM_ON_SIDE; i++)
+		for(j=0; j<NUM_ON_SIDE; j++)
+			if (a->m_spots[i] == b->m_spots[j])
+				return a->m_spots[i];
+	return -1;
+}
+
+/*
+ * mksymmetries
+ *
+ * The symmetries of the board are those of the cube (or hypercube): every
+ * way of permuting the axes, and then of flipping any of them end for end.
+ * Write out where each one takes each square, the identity first.
+ */
+static void
+mksymmetries(void)
+{
+	int	nsyms = 0, perm[NUM_DIMS], orbit[NUM_SQUARES], i, k, axis, t,
+		flips;
+
+	for(i=0; i<NUM_SQUARES; i++)
+		orbit[i] = i;
+
+	printf("const unsigned char\tcs_symmetry[CS_NSYMS][NUM_SQUARES] = {\n");
+	// Count through every NUM_DIMS digit number, base NUM_DIMS, keeping
+	// those whose digits are all different
+	for(t=0; t<GB_POW(NUM_DIMS); t++) {
+		int	used = 0;
+
+		for(axis=0, i=t; axis<NUM_DIMS; axis++, i /= NUM_DIMS) {
+			perm[NUM_DIMS-1-axis] = i % NUM_DIMS;
+			used |= 1 << (i % NUM_DIMS);
+		} if (used != (1<<NUM_DIMS)-1)
+			continue;
+
+		for(flips=0; flips < (1<<NUM_DIMS); flips++) {
+			printf("\t{");
+			for(i=0; i<NUM_SQUARES; i++) {
+				int	c[NUM_DIMS];
+
+				for(axis=0; axis<NUM_DIMS; axis++) {
+					c[axis] = gb_coord(i, perm[axis]);
+					if ((flips >> axis)&1)
+						c[axis] = NUM_ON_SIDE-1-c[axis];
+				}
+				k = gb_square(c);
+				if (k < orbit[i])
+					orbit[i] = k;
+				printf("%s%d", (i==0) ? " " : (i%16) ? ", "
+					: ",\n\t  ", k);
+			} printf(" },\n");
+			nsyms++;
+		}
+	}
+	printf("};\n\n");
+
+	// On an empty board, every symmetry applies.  Each square's orbit is
+	// then every square any symmetry takes it to, and is represented by
+	// the lowest numbered of those.
+	printf("const unsigned char\tcs_orbit[NUM_SQUARES] = {");
+	for(i=0; i<NUM_SQUARES; i++)
+		printf("%s%d", (i%16) ? ", " : (i) ? ",\n\t" : "\n\t",
+			orbit[i]);
+	printf("\n};\n\n");
+
+	if (nsyms != CS_NSYMS) {
+		fprintf(stderr, "ERR: Generated %d symmetries, not %d\n",
+			nsyms, CS_NSYMS);
+		exit(EXIT_FAILURE);
+	}
+}
+
+int main(int argc, char **argv) {
+	COMBOROW	lines[NUM_COMBOROWS];
+	int		nincident[NUM_SQUARES],
+			incident[NUM_SQUARES][CS_MAXINCIDENT];
+	int		i, j, k;
+
+	mklines(lines);
+
+	for(i=0; i<NUM_SQUARES; i++)
+		nincident[i] = 0;
+	for(i=0; i<NUM_COMBOROWS; i++) {
+		for(j=0; j<NUM_ON_SIDE; j++) {
+			k = lines[i].m_spots[j];
+			if (nincident[k] >= CS_MAXINCIDENT) {
+				fprintf(stderr, "ERR: More than CS_MAXINCIDENT "
+					"lines pass through square %d\n", k);
+				exit(EXIT_FAILURE);
+			}
+			incident[k][nincident[k]++] = i;
+		}
+	}
+
+	printf("//\n// Generated by mkwins.  Do not edit.\n//\n");
+	printf("#include \"comboset.h\"\n\n");
+
+	printf("const COMBOSET\tcs_initial = {\n");
+	printf("\t.m_ninplay = %d,\n", NUM_COMBOROWS);
+	printf("\t.m_winningid = -1,\n");
+	printf("\t.m_inplay = {");
+	for(i=0; i<NUM_COMBOROWS; i++)
+		printf("%s%d", (i%16) ? ", " : (i) ? ",\n\t\t" : "\n\t\t", i);
+	printf("\n\t},\n");
+	printf("\t.m_slot = {");
+	for(i=0; i<NUM_COMBOROWS; i++)
+		printf("%s%d", (i%16) ? ", " : (i) ? ",\n\t\t" : "\n\t\t", i);
+	printf("\n\t},\n");
+	// Nobody owns any line, nor has filled any of it
+	printf("\t.m_spots = {\n");
+	for(i=0; i<NUM_COMBOROWS; i++) {
+		printf("\t\t{");
+		for(j=0; j<NUM_ON_SIDE; j++)
+			printf("%s%2d", (j) ? ", " : " ", lines[i].m_spots[j]);
+		printf(" },\n");
+	}
+	printf("\t},\n");
+	printf("\t.m_nlines = { [GB_NOONE] = { %d } },\n", NUM_COMBOROWS);
+
+	// Every square starts out open, on all of the lines through it, and
+	// nobody owns any of them yet
+	printf("\t.m_planes = { [GB_NOONE] = { [0] = {");
+	for(k=0; k<CS_NPLANES; k++) {
+		printf("%s\n\t\t{ {", (k) ? "," : "");
+		for(j=0; j<SS_WORDS; j++) {
+			unsigned	bits = 0;
+
+			for(i=j*32; (i<j*32+32)&&(i<NUM_SQUARES); i++)
+				if ((nincident[i] >> k)&1)
+					bits |= 1u << (i&31);
+			printf("%s0x%08x", (j) ? ", " : " ", bits);
+		} printf(" } }");
+	} printf("\n\t} } },\n");
+
+	// ... and so every square is live
+	printf("\t.m_live = { {");
+	for(j=0; j<SS_WORDS; j++) {
+		unsigned	bits = 0;
+
+		for(i=j*32; (i<j*32+32)&&(i<NUM_SQUARES); i++)
+			bits |= 1u << (i&31);
+		printf("%s0x%08x", (j) ? ", " : " ", bits);
+	} printf(" } }\n};\n\n");
+
+	// A line with k of one player's pieces in it is worth 1+8+...+8^(k-1),
+	// a bit more than seven lines with k-1--as many lines as pass through
+	// any one square of the classic board
+	printf("const int\tcs_weight[NUM_ON_SIDE+1] = {");
+	for(i=0, k=0; i<=NUM_ON_SIDE; i++, k=k*8+1)
+		printf("%s%d", (i) ? ", " : " ", k);
+	printf(" };\n\n");
+
+	printf("const unsigned char\tcs_lines[NUM_COMBOROWS][NUM_ON_SIDE] = {\n");
+	for(i=0; i<NUM_COMBOROWS; i++) {
+		printf("\t{");
+		for(j=0; j<NUM_ON_SIDE; j++)
+			printf("%s%2d", (j) ? ", " : " ", lines[i].m_spots[j]);
+		printf(" },\n");
+	}
+	printf("};\n\n");
+
+	printf("const unsigned char\tcs_nincident[NUM_SQUARES] = {");
+	for(i=0; i<NUM_SQUARES; i++)
+		printf("%s%d", (i%16) ? ", " : (i) ? ",\n\t" : "\n\t",
+			nincident[i]);
+	printf("\n};\n\n");
+
+	printf("const CR_ID\tcs_incident[NUM_SQUARES][CS_MAXINCIDENT] = {\n");
+	for(i=0; i<NUM_SQUARES; i++) {
+		printf("\t{");
+		for(j=0; j<nincident[i]; j++)
+			printf("%s%2d", (j) ? ", " : " ", incident[i][j]);
+		printf(" },\n");
+	}
+	printf("};\n\n");
+
+	mksymmetries();
+
+	printf("const CS_SQUARE\tcs_crossing[NUM_COMBOROWS][NUM_COMBOROWS] = {\n");
+	for(i=0; i<NUM_COMBOROWS; i++) {
+		printf("\t{");
+		for(j=0; j<NUM_COMBOROWS; j++) {
+			k = (i == j) ? -1
+				: crossing(&lines[i], &lines[j]);
+			printf("%s%2d", (j==0) ? " " : (j%16) ? ","
+				: ",\n\t  ", k);
+		}
+		printf(" },\n");
+	}
+	printf("};\n");
+
+	return 0;
+}
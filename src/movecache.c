@@ -0,0 +1,454 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	movecache.c
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	The shared cache of chosen moves, whether private to a process
+//		or kept in shared memory for many.  See movecache.h.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#define	_POSIX_C_SOURCE	200809L
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "movecache.h"
+
+// Each position is kept as two bits per square, sixteen squares to a word
+#define	MC_KEYWORDS	((NUM_SQUARES+15)/16)
+// Difficulty levels are kept in a short.  Any beyond it aren't cached.
+#define	MC_MAXLEVEL	0xffff
+// The most buckets a cache may have
+#define	MC_MAXBUCKETS	(1u<<28)
+
+// "TTMC", as it reads in memory on a little endian machine
+#define	MC_MAGIC	0x434d5454u
+#define	MC_VERSION	1
+// Each part of the cache's memory starts on a line of its own
+#define	MC_ALIGN(N)	(((N) + 63) & ~(size_t)63)
+
+typedef	struct	MCENTRY_S {
+	// Even once written, and zero until first written.  Odd while being
+	// written, when the rest of the count is the writer's process ID.
+	uint32_t	m_seq;
+	unsigned short	m_difficulty;
+	// The CLOCK reference bit, set whenever the entry is found
+	unsigned char	m_ref, m_unused;
+	uint32_t	m_key[MC_KEYWORDS];
+	// The best moves, as vs_best() found them
+	unsigned	m_best[SS_WORDS];
+} MCENTRY, *LPMCENTRY;
+
+/*
+ * MCHEADER
+ *
+ * The start of the cache's memory, followed by each bucket's CLOCK hand, and
+ * then by the entries.  A shared cache is laid out just so within its shared
+ * memory object, and a private one the same within memory of its own.  The
+ * fields up to m_nbuckets say how the rest is laid out, and every process
+ * attaching must agree with them.
+ */
+typedef	struct	MCHEADER_S {
+	uint32_t	m_magic, m_version;
+	uint32_t	m_nsquares, m_ways, m_entrysize, m_nbuckets;
+	// Set once the cache is laid out, and ready to use
+	uint32_t	m_ready;
+	// The sequence count the next entry written is given
+	uint32_t	m_nextseq;
+	uint32_t	m_nused, m_unused;
+	uint64_t	m_hits, m_misses, m_stores, m_evictions;
+} MCHEADER, *LPMCHEADER;
+
+struct	MOVECACHE_S {
+	LPMCHEADER	m_hdr;
+	unsigned	m_nbuckets;
+	unsigned char	*m_hand;
+	MCENTRY		*m_entries;
+	// The length of a shared cache's mapping, or zero for a private cache
+	size_t		m_maplen;
+};
+
+/*
+ * mc_nbuckets, mc_size
+ *
+ * The number of buckets needed to hold (about) nentries, and the memory a
+ * cache of nb buckets takes.
+ */
+static unsigned
+mc_nbuckets(unsigned nentries) {
+	unsigned	nb = 1;
+
+	while((nb < (nentries + MC_WAYS-1) / MC_WAYS)&&(nb < MC_MAXBUCKETS))
+		nb <<= 1;
+	return nb;
+}
+
+static size_t
+mc_size(unsigned nb) {
+	return MC_ALIGN(sizeof(MCHEADER)) + MC_ALIGN(nb)
+		+ (size_t)nb * MC_WAYS * sizeof(MCENTRY);
+}
+
+/*
+ * mc_layout
+ *
+ * Find the parts of a cache of nb buckets within its memory, and lay out its
+ * header if need be.  The rest of the memory must start out zero.
+ */
+static void
+mc_layout(LPMOVECACHE mc, void *mem, unsigned nb, bool init) {
+	unsigned char	*base = (unsigned char *)mem;
+
+	mc->m_hdr = (LPMCHEADER)base;
+	mc->m_nbuckets = nb;
+	mc->m_hand = base + MC_ALIGN(sizeof(MCHEADER));
+	mc->m_entries = (MCENTRY *)(mc->m_hand + MC_ALIGN(nb));
+
+	if (init) {
+		mc->m_hdr->m_magic     = MC_MAGIC;
+		mc->m_hdr->m_version   = MC_VERSION;
+		mc->m_hdr->m_nsquares  = NUM_SQUARES;
+		mc->m_hdr->m_ways      = MC_WAYS;
+		mc->m_hdr->m_entrysize = sizeof(MCENTRY);
+		mc->m_hdr->m_nbuckets  = nb;
+		mc->m_hdr->m_nextseq   = 2;
+	}
+}
+
+LPMOVECACHE	mc_new(unsigned nentries) {
+	LPMOVECACHE	mc;
+	void		*mem;
+	unsigned	nb = mc_nbuckets(nentries);
+
+	mc  = (LPMOVECACHE)calloc(1, sizeof(MOVECACHE));
+	mem = calloc(1, mc_size(nb));
+	if ((!mc)||(!mem)) {
+		free(mc);
+		free(mem);
+		return NULL;
+	}
+	mc_layout(mc, mem, nb, true);
+	mc->m_hdr->m_ready = 1;
+	return mc;
+}
+
+/*
+ * mc_agrees
+ *
+ * True if a shared cache's header, of a shared memory object of len bytes,
+ * lays the cache out just as we would
+ */
+static bool
+mc_agrees(const MCHEADER *h, size_t len) {
+	return (h->m_magic == MC_MAGIC)&&(h->m_version == MC_VERSION)
+		&&(h->m_nsquares == NUM_SQUARES)&&(h->m_ways == MC_WAYS)
+		&&(h->m_entrysize == sizeof(MCENTRY))
+		&&(h->m_nbuckets > 0)&&(h->m_nbuckets <= MC_MAXBUCKETS)
+		&&((h->m_nbuckets & (h->m_nbuckets-1)) == 0)
+		&&(len >= mc_size(h->m_nbuckets));
+}
+
+LPMOVECACHE	mc_attach(const char *name, unsigned nentries) {
+	LPMOVECACHE	mc = NULL;
+	MCHEADER	hdr;
+	struct flock	lk;
+	struct stat	st;
+	void		*mem;
+	unsigned	nb;
+	bool		init;
+	int		fd, err;
+
+	fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+	if (fd < 0)
+		return NULL;
+
+	// Only one process at a time may look the header over, and lay it
+	// out if it isn't yet.  The lock goes with the process holding it, so
+	// one that dies part way leaves the cache for the next to lay out.
+	memset(&lk, 0, sizeof(lk));
+	lk.l_type   = F_WRLCK;
+	lk.l_whence = SEEK_SET;
+	while(fcntl(fd, F_SETLKW, &lk) < 0)
+		if (errno != EINTR)
+			goto fail;
+
+	if (fstat(fd, &st) < 0)
+		goto fail;
+	init = ((size_t)st.st_size < sizeof(MCHEADER))
+		||(pread(fd, &hdr, sizeof(hdr), 0) != sizeof(hdr))
+		||(!hdr.m_ready);
+	if (init) {
+		// Empty it, in case another died part way through, and then
+		// make it the size we want
+		nb = mc_nbuckets(nentries);
+		if ((ftruncate(fd, 0) < 0)||(ftruncate(fd, mc_size(nb)) < 0))
+			goto fail;
+	} else if (mc_agrees(&hdr, st.st_size)) {
+		// Already laid out.  Whoever did so chose its size.
+		nb = hdr.m_nbuckets;
+	} else {
+		errno = EINVAL;
+		goto fail;
+	}
+
+	mc = (LPMOVECACHE)calloc(1, sizeof(MOVECACHE));
+	if (!mc)
+		goto fail;
+	mem = mmap(NULL, mc_size(nb), PROT_READ | PROT_WRITE, MAP_SHARED,
+			fd, 0);
+	if (mem == MAP_FAILED)
+		goto fail;
+	mc->m_maplen = mc_size(nb);
+	mc_layout(mc, mem, nb, init);
+	if (init)
+		__atomic_store_n(&mc->m_hdr->m_ready, 1, __ATOMIC_RELEASE);
+
+	// Closing the descriptor lets go of the lock
+	close(fd);
+	return mc;
+fail:
+	err = errno;
+	free(mc);
+	close(fd);
+	errno = err;
+	return NULL;
+}
+
+void	mc_free(LPMOVECACHE mc) {
+	if (!mc)
+		return;
+	if (mc->m_maplen)
+		munmap(mc->m_hdr, mc->m_maplen);
+	else
+		free(mc->m_hdr);
+	free(mc);
+}
+/*
+ * mc_key
+ *
+ * Pack a board into its key, and return the hash of that key together with
+ * the difficulty level.
+ */
+static unsigned
+mc_key(LPGBOARD brd, int difficulty, uint32_t *key) {
+	uint64_t	h = (unsigned)difficulty;
+	int		w, i;
+
+	for(w=0; w<MC_KEYWORDS; w++) {
+		uint32_t	k = 0;
+
+		for(i=w*16; (i < w*16+16)&&(i < NUM_SQUARES); i++)
+			k |= (uint32_t)(brd->m_spots[i] & 3) << ((i & 15)*2);
+		key[w] = k;
+		h = (h ^ k) * 0x9e3779b97f4a7c15ull;
+	}
+	return (unsigned)(h ^ (h >> 29) ^ (h >> 47));
+}
+
+/*
+ * mc_match
+ *
+ * Copy one entry's best moves into best, if it holds key at this difficulty
+ * level.  The copy is only good if the entry's sequence count was even, and
+ * didn't change while we were reading.
+ */
+static bool
+mc_match(LPMCENTRY e, int difficulty, const uint32_t *key, unsigned *best) {
+	unsigned	seq;
+	bool		match;
+	int		w;
+
+	seq = __atomic_load_n(&e->m_seq, __ATOMIC_ACQUIRE);
+	if ((seq == 0)||(seq & 1))
+		return false;
+
+	match = (__atomic_load_n(&e->m_difficulty, __ATOMIC_RELAXED)
+			== difficulty);
+	for(w=0; (match)&&(w<MC_KEYWORDS); w++)
+		match = (__atomic_load_n(&e->m_key[w], __ATOMIC_RELAXED)
+				== key[w]);
+	if (!match)
+		return false;
+	for(w=0; w<SS_WORDS; w++)
+		best[w] = __atomic_load_n(&e->m_best[w], __ATOMIC_RELAXED);
+
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return (__atomic_load_n(&e->m_seq, __ATOMIC_RELAXED) == seq);
+}
+
+bool	mc_lookup(LPMOVECACHE mc, LPGBOARD brd, int difficulty,
+		LPVSET spots) {
+	uint32_t	key[MC_KEYWORDS];
+	unsigned	best[SS_WORDS];
+	LPMCENTRY	bucket;
+	int		k, w, i;
+
+	if ((difficulty < 0)||(difficulty > MC_MAXLEVEL))
+		return false;
+
+	bucket = &mc->m_entries[(mc_key(brd, difficulty, key)
+				& (mc->m_nbuckets-1)) * MC_WAYS];
+	for(k=0; k<MC_WAYS; k++) {
+		if (!mc_match(&bucket[k], difficulty, key, best))
+			continue;
+
+		// Only write the reference bit when it needs it, so that
+		// entries found over and over again by many threads at once
+		// aren't written over and over again too
+		if (!__atomic_load_n(&bucket[k].m_ref, __ATOMIC_RELAXED))
+			__atomic_store_n(&bucket[k].m_ref, 1, __ATOMIC_RELAXED);
+		__atomic_fetch_add(&mc->m_hdr->m_hits, 1, __ATOMIC_RELAXED);
+
+		vs_clear(spots);
+		for(w=0; w<SS_WORDS; w++)
+			for(i=w*32; best[w]; i++, best[w] >>= 1)
+				if (best[w] & 1)
+					vs_incscore(spots, i);
+		return true;
+	}
+
+	__atomic_fetch_add(&mc->m_hdr->m_misses, 1, __ATOMIC_RELAXED);
+	return false;
+}
+
+/*
+ * mc_orphaned
+ *
+ * True if an entry's writer, as given by its (odd) sequence count, is no
+ * longer running
+ */
+static bool
+mc_orphaned(unsigned seq) {
+	return (kill((pid_t)(seq >> 1), 0) < 0)&&(errno == ESRCH);
+}
+
+void	mc_store(LPMOVECACHE mc, LPGBOARD brd, int difficulty,
+		LPVSET spots) {
+	uint32_t	key[MC_KEYWORDS];
+	SQSET		best;
+	unsigned	b, seq;
+	LPMCENTRY	bucket, e = NULL;
+	bool		evict = false;
+	int		k, w, hand;
+
+	if ((difficulty < 0)||(difficulty > MC_MAXLEVEL))
+		return;
+
+	b = mc_key(brd, difficulty, key) & (mc->m_nbuckets-1);
+	bucket = &mc->m_entries[b * MC_WAYS];
+
+	// Write over this same position if it's already here (another thread
+	// may have beaten us to it), or else into an empty entry
+	for(k=0; (!e)&&(k<MC_WAYS); k++) {
+		LPMCENTRY	c = &bucket[k];
+		bool		same;
+
+		if (__atomic_load_n(&c->m_seq, __ATOMIC_RELAXED) == 0) {
+			e = c;
+			break;
+		}
+		same = (__atomic_load_n(&c->m_difficulty, __ATOMIC_RELAXED)
+				== difficulty);
+		for(w=0; (same)&&(w<MC_KEYWORDS); w++)
+			same = (__atomic_load_n(&c->m_key[w], __ATOMIC_RELAXED)
+				== key[w]);
+		if (same)
+			e = c;
+	}
+
+	// Otherwise, push out whichever entry the CLOCK hand comes to first
+	// that hasn't been found since the hand last passed it
+	if (!e) {
+		hand = __atomic_load_n(&mc->m_hand[b], __ATOMIC_RELAXED)
+				% MC_WAYS;
+		for(k=0; k<2*MC_WAYS; k++, hand = (hand+1) % MC_WAYS) {
+			if (!__atomic_load_n(&bucket[hand].m_ref,
+					__ATOMIC_RELAXED))
+				break;
+			__atomic_store_n(&bucket[hand].m_ref, 0,
+					__ATOMIC_RELAXED);
+		}
+		e = &bucket[hand];
+		evict = true;
+		__atomic_store_n(&mc->m_hand[b], (hand+1) % MC_WAYS,
+				__ATOMIC_RELAXED);
+	}
+
+	// Claim the entry, unless someone else is already writing it.  If
+	// they died part way, it's ours to write over.
+	seq = __atomic_load_n(&e->m_seq, __ATOMIC_RELAXED);
+	if ((seq & 1)&&(!mc_orphaned(seq)))
+		return;
+	if (!__atomic_compare_exchange_n(&e->m_seq, &seq,
+			((uint32_t)getpid() << 1) | 1,
+			false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+		return;
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	if (seq == 0)
+		__atomic_fetch_add(&mc->m_hdr->m_nused, 1, __ATOMIC_RELAXED);
+	if (evict)
+		__atomic_fetch_add(&mc->m_hdr->m_evictions, 1, __ATOMIC_RELAXED);
+
+	vs_best(spots, &best);
+	__atomic_store_n(&e->m_difficulty, (unsigned short)difficulty,
+			__ATOMIC_RELAXED);
+	for(w=0; w<MC_KEYWORDS; w++)
+		__atomic_store_n(&e->m_key[w], key[w], __ATOMIC_RELAXED);
+	for(w=0; w<SS_WORDS; w++)
+		__atomic_store_n(&e->m_best[w], best.m_bits[w],
+				__ATOMIC_RELAXED);
+	__atomic_store_n(&e->m_ref, 0, __ATOMIC_RELAXED);
+
+	// Every entry written gets a count of its own, so that a reader
+	// can't mistake it for what was there before.  Zero means never
+	// written, so skip it should the count wrap around.
+	do {
+		seq = __atomic_fetch_add(&mc->m_hdr->m_nextseq, 2,
+				__ATOMIC_RELAXED);
+	} while(seq == 0);
+	__atomic_store_n(&e->m_seq, seq, __ATOMIC_RELEASE);
+	__atomic_fetch_add(&mc->m_hdr->m_stores, 1, __ATOMIC_RELAXED);
+}
+
+void	mc_stats(LPMOVECACHE mc, LPMC_STATS st) {
+	st->m_nentries  = mc->m_nbuckets * MC_WAYS;
+	st->m_nused     = __atomic_load_n(&mc->m_hdr->m_nused, __ATOMIC_RELAXED);
+	st->m_hits      = __atomic_load_n(&mc->m_hdr->m_hits, __ATOMIC_RELAXED);
+	st->m_misses    = __atomic_load_n(&mc->m_hdr->m_misses, __ATOMIC_RELAXED);
+	st->m_stores    = __atomic_load_n(&mc->m_hdr->m_stores, __ATOMIC_RELAXED);
+	st->m_evictions = __atomic_load_n(&mc->m_hdr->m_evictions, __ATOMIC_RELAXED);
+}
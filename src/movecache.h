@@ -0,0 +1,151 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	movecache.h
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	A cache of the moves chosen in each position, shared by every
+//		game a process is playing--or, kept in POSIX shared memory, by
+//	every process on the host that attaches it.  Across thousands of
+//	games, the same openings and middlegames come up again and again, and
+//	each time the strategy would work out the same answer.  The cache
+//	remembers that answer, by position and difficulty level.
+//
+//	What's kept is the set of equally good moves the strategy ends up
+//	with, not the move picked from among them.  The pick is still made
+//	from each game's own random number state, so a game plays exactly as
+//	it would have without the cache.
+//
+//	Entries are grouped into buckets of MC_WAYS, and each position may
+//	only be kept in the one bucket its hash selects.  When a bucket is
+//	full, the entry to give up is chosen CLOCK fashion: every entry has a
+//	reference bit, set each time it's found, and the bucket's hand skips
+//	(and clears) those with the bit set.
+//
+//	Finding an entry takes no lock.  Each is guarded by a sequence count,
+//	odd while the entry is being written, which the reader checks before
+//	and after copying the entry out--if it changed, the reader counts a
+//	miss.  A writer that finds an entry already being written simply
+//	gives up, since there's no harm in not caching something.
+//
+//	A shared cache (mc_attach()) starts with a header giving the version
+//	of its layout, the board it's for, and its size.  The first process to
+//	attach lays it out, at the size it asks for; every process after takes
+//	it at whatever size it already is, or fails to attach should the
+//	layout differ from its own.  The cache outlives the processes using
+//	it, so a worker that restarts finds it as warm as it left it, until
+//	the shared memory object is removed (as from /dev/shm).  Since any of
+//	those processes might die at any time, a writer marks an entry with its
+//	process ID while writing it.  An entry left so by a process no longer
+//	running is written over by the next to come along.  Every process
+//	sharing a cache must therefore see the others' process IDs, as they
+//	do on one host.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#ifndef	MOVECACHE_H
+#define	MOVECACHE_H
+
+#include "gboard.h"
+#include "vset.h"
+
+// The number of entries in each bucket
+#define	MC_WAYS		4
+
+typedef	struct	MOVECACHE_S	MOVECACHE, *LPMOVECACHE;
+
+typedef	struct	MC_STATS_S {
+	// The number of entries, and how many of them are in use
+	unsigned	m_nentries, m_nused;
+	// Lookups that found their position, and those that didn't
+	unsigned long	m_hits, m_misses;
+	// Entries written, and of those how many pushed another entry out
+	unsigned long	m_stores, m_evictions;
+} MC_STATS, *LPMC_STATS;
+
+/*
+ * mc_new
+ *
+ * Allocate a cache with room for (about) nentries positions.  The number is
+ * rounded up to a whole number of buckets, and then to a power of two.
+ * Returns NULL if the memory can't be had.
+ */
+extern	LPMOVECACHE	mc_new(unsigned nentries);
+
+/*
+ * mc_attach
+ *
+ * Attach the cache kept in the POSIX shared memory object name (such as
+ * "/tttt"), creating it with room for (about) nentries positions if it
+ * doesn't yet exist.  An existing cache is used at its own size, which
+ * mc_stats() gives.  Returns NULL, with errno set, on any failure--EINVAL
+ * if the existing cache is laid out for another version or board.
+ */
+extern	LPMOVECACHE	mc_attach(const char *name, unsigned nentries);
+
+/*
+ * mc_free
+ *
+ * Release a cache, or detach from a shared one, which is left as it is.  No
+ * game may be using it.
+ */
+extern	void	mc_free(LPMOVECACHE mc);
+
+/*
+ * mc_lookup
+ *
+ * Look for the moves chosen on this board at this difficulty level.  If
+ * they're found, spots is set to hold them (each with the same score, so
+ * vs_pickmember() chooses between them just as it would have from the
+ * strategy's own set) and true is returned.
+ */
+extern	bool	mc_lookup(LPMOVECACHE mc, LPGBOARD brd, int difficulty,
+			LPVSET spots);
+
+/*
+ * mc_store
+ *
+ * Remember the best moves in spots, as chosen on this board at this
+ * difficulty level.  Only the results of a strategy allowed to apply every
+ * one of its rules should be stored.
+ */
+extern	void	mc_store(LPMOVECACHE mc, LPGBOARD brd, int difficulty,
+			LPVSET spots);
+
+/*
+ * mc_stats
+ *
+ * Read the cache's counters.  These are only approximate while other threads
+ * are using the cache.  A shared cache's counters are those of every process
+ * using it.
+ */
+extern	void	mc_stats(LPMOVECACHE mc, LPMC_STATS st);
+
+#endif
@@ -0,0 +1,113 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	ponder.c
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	Pondering.  While the computer's opponent is thinking, we can
+//		be thinking too: for each move the opponent might make, work out
+//	the set of moves the computer would reply with.  When the opponent's
+//	move does arrive, the reply is then (hopefully) already known.
+//
+//	Only the set of candidate replies is kept, not the reply itself.  The
+//	final random pick from among them is made once the opponent has moved,
+//	from the game's own random number state, so pondering never changes
+//	which move the computer makes--only how soon it makes it.
+//
+//	The work is broken into steps, one opponent move per step, so that it
+//	may be done either by a background thread, or cooperatively between
+//	checks for input on a machine without threads.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#include <string.h>
+#include "ponder.h"
+
+void	ponder_start(LPPONDER p, LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs,
+		GB_PIECE who) {
+	VSET		likely;
+	GB_PIECE	opp = opponent(who);
+	int		i;
+
+	memcpy(&p->m_brd, brd, sizeof(GBOARD));
+	memcpy(&p->m_cs,  cs,  sizeof(COMBOSET));
+	memcpy(&p->m_strategy, s, sizeof(STRATEGY));
+	set_watch(&p->m_strategy, NULL, NULL);
+	p->m_who = who;
+	p->m_norder = 0;
+	p->m_next = 0;
+	for(i=0; i<NUM_SQUARES; i++)
+		p->m_done[i] = false;
+
+	if (whoseturn(brd) != opp)
+		return;
+
+	// The most likely moves our opponent might make are those we'd make
+	// in their place.  Consider those first, then all of the rest.
+	choosemoves(&p->m_strategy, &p->m_brd, &p->m_cs, opp, &likely);
+	for(i=0; i<NUM_SQUARES; i++)
+		if ((vs_isable(&likely, i))&&(legal(brd, opp, i)))
+			p->m_order[p->m_norder++] = i;
+	for(i=0; i<NUM_SQUARES; i++)
+		if ((!vs_isable(&likely, i))&&(legal(brd, opp, i)))
+			p->m_order[p->m_norder++] = i;
+}
+
+bool	ponder_step(LPPONDER p) {
+	GBOARD		brd;
+	COMBOSET	cs;
+	GB_PIECE	opp = opponent(p->m_who);
+	int		mv;
+
+	if (p->m_next >= p->m_norder)
+		return false;
+
+	mv = p->m_order[p->m_next++];
+	memcpy(&brd, &p->m_brd, sizeof(GBOARD));
+	memcpy(&cs,  &p->m_cs,  sizeof(COMBOSET));
+
+	gb_place(&brd, opp, mv);
+	if (cs_place(&cs, opp, mv))
+		// Our opponent wins with this move.  There's no reply to it.
+		vs_clear(&p->m_reply[mv]);
+	else
+		choosemoves(&p->m_strategy, &brd, &cs, p->m_who,
+			&p->m_reply[mv]);
+	p->m_done[mv] = true;
+
+	return (p->m_next < p->m_norder);
+}
+
+bool	ponder_reply(LPPONDER p, int oppmove, LPVSET spots) {
+	if ((oppmove < 0)||(oppmove >= NUM_SQUARES)||(!p->m_done[oppmove]))
+		return false;
+	vs_set(spots, &p->m_reply[oppmove]);
+	return true;
+}
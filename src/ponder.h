@@ -0,0 +1,89 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	ponder.h
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	Pondering: working out the computer's reply to every move its
+//		opponent might make, while waiting for that opponent to make
+//	up their mind.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#ifndef	PONDER_H
+#define	PONDER_H
+
+#include "gboard.h"
+#include "comboset.h"
+#include "strategy.h"
+
+typedef	struct	PONDER_S {
+	// The position we are pondering from, with the opponent to move
+	GBOARD		m_brd;
+	COMBOSET	m_cs;
+	// A copy of the computer's strategy, and which side it plays
+	STRATEGY	m_strategy;
+	GB_PIECE	m_who;
+	// The order in which to consider the opponent's moves, most likely
+	// first, and how far through that list we've gotten
+	int		m_norder, m_next;
+	unsigned char	m_order[NUM_SQUARES];
+	// The candidate replies to each opponent move, once m_done
+	bool		m_done[NUM_SQUARES];
+	VSET		m_reply[NUM_SQUARES];
+} PONDER, *LPPONDER;
+
+/*
+ * ponder_start
+ *
+ * Prepare to ponder the position given, where it is who's opponent's turn to
+ * move, and who is the computer using the strategy s.
+ */
+extern	void	ponder_start(LPPONDER p, LPSTRATEGY s, LPGBOARD brd,
+			LPCOMBOSET cs, GB_PIECE who);
+
+/*
+ * ponder_step
+ *
+ * Work out the computer's reply to one more of the opponent's moves.  Returns
+ * false once there's nothing left to ponder.  Each step costs about as much
+ * as one call to choosemoves().
+ */
+extern	bool	ponder_step(LPPONDER p);
+
+/*
+ * ponder_reply
+ *
+ * If the reply to the opponent's move has already been worked out, copy the
+ * set of candidate replies into spots and return true.
+ */
+extern	bool	ponder_reply(LPPONDER p, int oppmove, LPVSET spots);
+
+#endif
@@ -0,0 +1,130 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	position.c
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	Converts positions to and from the one line text format
+//		described in position.h.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#include "position.h"
+
+static char
+piecechar(GB_PIECE p) {
+	if (p == GB_BLACK)
+		return 'x';
+	else if (p == GB_WHITE)
+		return 'o';
+	return '-';
+}
+
+bool	pos_parse(const char *str, LPGBOARD brd, LPCOMBOSET cs) {
+	int		i, nblack = 0, nwhite = 0;
+	GB_PIECE	side, winner = GB_NOONE;
+
+	gb_reset(brd);
+	cs_init(cs);
+
+	while((*str == ' ')||(*str == '\t'))
+		str++;
+
+	for(i=0; i<NUM_SQUARES; i++) {
+		switch(str[i]) {
+		case 'x': case 'X':
+			brd->m_spots[i] = GB_BLACK; nblack++; break;
+		case 'o': case 'O':
+			brd->m_spots[i] = GB_WHITE; nwhite++; break;
+		case '-': case '.':
+			break;
+		default:
+			return false;
+		}
+	} str += NUM_SQUARES;
+
+	if ((*str != ' ')&&(*str != '\t'))
+		return false;
+	while((*str == ' ')||(*str == '\t'))
+		str++;
+	if ((*str == 'x')||(*str == 'X'))
+		side = GB_BLACK;
+	else if ((*str == 'o')||(*str == 'O'))
+		side = GB_WHITE;
+	else if (*str == '-')
+		side = GB_NOONE;
+	else
+		return false;
+	str++;
+	if ((*str)&&(*str != ' ')&&(*str != '\t')&&(*str != '\r')
+			&&(*str != '\n'))
+		return false;
+
+	// Black always moves first, so black has either as many pieces as
+	// white, or one more.
+	if ((nblack != nwhite)&&(nblack != nwhite+1))
+		return false;
+
+	// Now replay the pieces into the COMBOSET.  The order in which we do
+	// this doesn't matter to the COMBOSET--save that once a line is
+	// complete, the game is over and cs_place() ignores any more pieces.
+	brd->m_nfilled = nblack + nwhite;
+	brd->m_lastturn = (nblack > nwhite) ? GB_BLACK : GB_WHITE;
+	for(i=0; i<NUM_SQUARES; i++) {
+		if (brd->m_spots[i] == GB_NOONE)
+			continue;
+		if (cs_place(cs, brd->m_spots[i], i)) {
+			winner = brd->m_spots[i];
+			break;
+		}
+	}
+
+	if (winner != GB_NOONE) {
+		// Whoever won must have made the last move
+		if (brd->m_lastturn != winner)
+			return false;
+		brd->m_winner = winner;
+	} else if (brd->m_nfilled >= NUM_SQUARES)
+		brd->m_winner = GB_TIE;
+
+	if (side != whoseturn(brd))
+		return false;
+	return true;
+}
+
+void	pos_format(LPGBOARD brd, char *buf) {
+	int	i;
+
+	for(i=0; i<NUM_SQUARES; i++)
+		buf[i] = piecechar(brd->m_spots[i]);
+	buf[NUM_SQUARES] = ' ';
+	buf[NUM_SQUARES+1] = piecechar(whoseturn(brd));
+	buf[NUM_SQUARES+2] = '\0';
+}
@@ -0,0 +1,74 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	position.h
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	Defines a one line text format for a position, much like FEN
+//		is used for chess.  A position is written as one character per
+//	square, in gb_square() order, followed by a space and the side to move:
+//
+//		x---------------------------------------------------o---------- x
+//
+//	Squares hold 'x' (black), 'o' (white), or '-' (empty, '.' is also
+//	accepted).  The side to move is 'x' or 'o', or '-' if the game is over.
+//	Since black always moves first, the side to move must agree with the
+//	number of pieces of each color on the board.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#ifndef	POSITION_H
+#define	POSITION_H
+
+#include "gboard.h"
+#include "comboset.h"
+
+// The length of a position string, not counting its terminating NUL
+#define	POS_STRLEN	(NUM_SQUARES + 2)
+
+/*
+ * pos_parse
+ *
+ * Parse a position string into a board, and replay the pieces on that board
+ * into the given COMBOSET, so that both are exactly as though the game had
+ * been played to this point.  Anything following the side to move is
+ * ignored.  Returns false if the string isn't a valid position.
+ */
+extern	bool	pos_parse(const char *str, LPGBOARD brd, LPCOMBOSET cs);
+
+/*
+ * pos_format
+ *
+ * Write a board out as a position string.  buf must have room for at least
+ * POS_STRLEN+1 characters.
+ */
+extern	void	pos_format(LPGBOARD brd, char *buf);
+
+#endif
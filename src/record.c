@@ -0,0 +1,345 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	record.c
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	Reads and writes games in the binary record format described in
+//		record.h.  Writing is done in a streaming fashion: games are
+//	gathered into a block in memory, and each block is written as it fills.
+//	Reading is left to the caller, who is expected to have the whole file
+//	in memory (usually via mmap()).  We just help find and decode the
+//	games.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "record.h"
+
+struct	RECWRITER_S {
+	FILE		*m_fp;
+	bool		m_err;
+	uint64_t	m_offset;
+	// The block currently being filled
+	unsigned	m_blkgames;
+	size_t		m_blklen;
+	unsigned char	m_blk[REC_BLOCKSIZE + REC_MAXGAMESIZE];
+	// The index of all of the blocks written so far
+	int		m_nblocks, m_nalloc;
+	LPREC_BLOCK	m_index;
+};
+
+static void
+put16(unsigned char *p, unsigned v) {
+	p[0] = v; p[1] = v>>8;
+}
+
+static void
+put32(unsigned char *p, uint32_t v) {
+	put16(p, v & 0x0ffff); put16(p+2, v >> 16);
+}
+
+static void
+put64(unsigned char *p, uint64_t v) {
+	put32(p, (uint32_t)v); put32(p+4, (uint32_t)(v >> 32));
+}
+
+static unsigned
+get16(const unsigned char *p) {
+	return p[0] | (p[1]<<8);
+}
+
+static uint32_t
+get32(const unsigned char *p) {
+	return get16(p) | ((uint32_t)get16(p+2) << 16);
+}
+
+static uint64_t
+get64(const unsigned char *p) {
+	return get32(p) | ((uint64_t)get32(p+4) << 32);
+}
+
+static bool
+rec_emit(LPRECWRITER w, const unsigned char *buf, size_t len) {
+	if (fwrite(buf, 1, len, w->m_fp) != len)
+		w->m_err = true;
+	w->m_offset += len;
+	return !w->m_err;
+}
+
+LPRECWRITER	rec_open(const char *fname) {
+	LPRECWRITER	w;
+	unsigned char	hdr[REC_HEADERSIZE];
+
+	w = (LPRECWRITER)calloc(1, sizeof(RECWRITER));
+	if (!w)
+		return NULL;
+	w->m_fp = fopen(fname, "wb");
+	if (!w->m_fp) {
+		free(w);
+		return NULL;
+	}
+
+	memcpy(hdr, "TTTR", 4);
+	hdr[4] = REC_VERSION;
+	hdr[5] = REC_MOVEBITS;
+	put16(&hdr[6], NUM_SQUARES);
+	rec_emit(w, hdr, sizeof(hdr));
+	return w;
+}
+
+/*
+ * rec_flushblock
+ *
+ * Write the current block to the file, and note it within the index
+ */
+static bool
+rec_flushblock(LPRECWRITER w) {
+	unsigned char	hdr[REC_BLKHDRSIZE];
+
+	if (w->m_blkgames == 0)
+		return !w->m_err;
+
+	if (w->m_nblocks >= w->m_nalloc) {
+		int		nalloc = (w->m_nalloc) ? w->m_nalloc*2 : 64;
+		LPREC_BLOCK	idx;
+
+		idx = realloc(w->m_index, nalloc * sizeof(REC_BLOCK));
+		if (!idx) {
+			w->m_err = true;
+			return false;
+		}
+		w->m_index  = idx;
+		w->m_nalloc = nalloc;
+	}
+
+	w->m_index[w->m_nblocks].m_offset = w->m_offset;
+	w->m_index[w->m_nblocks].m_ngames = w->m_blkgames;
+	w->m_index[w->m_nblocks].m_nbytes = w->m_blklen;
+	w->m_nblocks++;
+
+	put32(&hdr[0], w->m_blkgames);
+	put32(&hdr[4], w->m_blklen);
+	rec_emit(w, hdr, sizeof(hdr));
+	rec_emit(w, w->m_blk, w->m_blklen);
+
+	w->m_blkgames = 0;
+	w->m_blklen   = 0;
+	return !w->m_err;
+}
+
+bool	rec_write(LPRECWRITER w, LPGAMEREC g) {
+	w->m_blklen += rec_encode(g, &w->m_blk[w->m_blklen]);
+	w->m_blkgames++;
+
+	if (w->m_blklen >= REC_BLOCKSIZE)
+		return rec_flushblock(w);
+	return !w->m_err;
+}
+
+bool	rec_close(LPRECWRITER w) {
+	unsigned char	buf[REC_IDXENTRYSIZE];
+	uint64_t	idxoffset;
+	bool		ok;
+	int		i;
+
+	rec_flushblock(w);
+
+	idxoffset = w->m_offset;
+	for(i=0; i<w->m_nblocks; i++) {
+		put64(&buf[0], w->m_index[i].m_offset);
+		put32(&buf[8], w->m_index[i].m_ngames);
+		put32(&buf[12],w->m_index[i].m_nbytes);
+		rec_emit(w, buf, REC_IDXENTRYSIZE);
+	}
+
+	put64(&buf[0], idxoffset);
+	put32(&buf[8], w->m_nblocks);
+	memcpy(&buf[12], "TTRX", 4);
+	rec_emit(w, buf, REC_FOOTERSIZE);
+
+	if (fclose(w->m_fp) != 0)
+		w->m_err = true;
+	ok = !w->m_err;
+	free(w->m_index);
+	free(w);
+	return ok;
+}
+
+size_t	rec_encode(LPGAMEREC g, unsigned char *buf) {
+	unsigned char	*ptr = &buf[REC_GAMEHDRSIZE];
+	unsigned	acc = 0;
+	int		nbits = 0, i;
+
+	put32(&buf[0], g->m_seed);
+	put16(&buf[4], g->m_difficulty[0]);
+	put16(&buf[6], g->m_difficulty[1]);
+	buf[8] = g->m_result;
+	buf[9] = g->m_nmoves & 0x0ff;
+
+	for(i=0; i<g->m_nmoves; i++) {
+		acc |= (unsigned)g->m_moves[i] << nbits;
+		nbits += REC_MOVEBITS;
+		while(nbits >= 8) {
+			*ptr++ = acc;
+			acc >>= 8;
+			nbits -= 8;
+		}
+	} if (nbits > 0)
+		*ptr++ = acc;
+
+	return ptr - buf;
+}
+
+size_t	rec_decode(const unsigned char *buf, size_t len, LPGAMEREC g) {
+	const unsigned char	*ptr = &buf[REC_GAMEHDRSIZE];
+	unsigned	acc = 0;
+	int		nbits = 0, i;
+	size_t		sz;
+
+	if (len < REC_GAMEHDRSIZE)
+		return 0;
+
+	g->m_seed = get32(&buf[0]);
+	g->m_difficulty[0] = get16(&buf[4]);
+	g->m_difficulty[1] = get16(&buf[6]);
+	g->m_result = buf[8];
+	g->m_nmoves = buf[9];
+	if ((g->m_nmoves == 0)&&(g->m_result != GB_NOONE))
+		g->m_nmoves = 256;
+
+	if ((g->m_nmoves > NUM_SQUARES)||(g->m_result > GB_TIE))
+		return 0;
+	sz = REC_GAMEHDRSIZE + (g->m_nmoves * REC_MOVEBITS + 7)/8;
+	if (sz > len)
+		return 0;
+
+	for(i=0; i<g->m_nmoves; i++) {
+		while(nbits < REC_MOVEBITS) {
+			acc |= (unsigned)(*ptr++) << nbits;
+			nbits += 8;
+		}
+		g->m_moves[i] = acc & ((1u<<REC_MOVEBITS)-1);
+		acc >>= REC_MOVEBITS;
+		nbits -= REC_MOVEBITS;
+	}
+
+	return sz;
+}
+
+/*
+ * rec_scan
+ *
+ * Walk the blocks of a file, one after the other, for when we can't use (or
+ * can't find) the index at the end.  A partially written last block is
+ * ignored.
+ */
+static int
+rec_scan(const unsigned char *data, size_t len, LPREC_BLOCK *blocks) {
+	size_t		offset = REC_HEADERSIZE;
+	int		nblocks = 0, nalloc = 0;
+	LPREC_BLOCK	idx = NULL, tmp;
+
+	while(offset + REC_BLKHDRSIZE <= len) {
+		unsigned	ngames = get32(&data[offset]),
+				nbytes = get32(&data[offset+4]);
+
+		if ((ngames == 0)||(offset + REC_BLKHDRSIZE + nbytes > len))
+			break;
+
+		if (nblocks >= nalloc) {
+			nalloc = (nalloc) ? nalloc * 2 : 64;
+			tmp = realloc(idx, nalloc * sizeof(REC_BLOCK));
+			if (!tmp) {
+				free(idx);
+				return -1;
+			} idx = tmp;
+		}
+
+		idx[nblocks].m_offset = offset;
+		idx[nblocks].m_ngames = ngames;
+		idx[nblocks].m_nbytes = nbytes;
+		nblocks++;
+		offset += REC_BLKHDRSIZE + nbytes;
+	}
+
+	*blocks = idx;
+	return nblocks;
+}
+
+int	rec_index(const unsigned char *data, size_t len, LPREC_BLOCK *blocks) {
+	const unsigned char	*ftr;
+	uint64_t	idxoffset;
+	unsigned	nblocks, i;
+	LPREC_BLOCK	idx;
+
+	*blocks = NULL;
+	if ((len < REC_HEADERSIZE)||(memcmp(data, "TTTR", 4) != 0)
+			||(data[4] != REC_VERSION)||(data[5] != REC_MOVEBITS)
+			||(get16(&data[6]) != NUM_SQUARES))
+		return -1;
+
+	if (len < REC_HEADERSIZE + REC_FOOTERSIZE)
+		return rec_scan(data, len, blocks);
+
+	ftr = &data[len - REC_FOOTERSIZE];
+	idxoffset = get64(&ftr[0]);
+	nblocks   = get32(&ftr[8]);
+	if ((memcmp(&ftr[12], "TTRX", 4) != 0)
+		||(idxoffset + (uint64_t)nblocks * REC_IDXENTRYSIZE
+				+ REC_FOOTERSIZE != len))
+		return rec_scan(data, len, blocks);
+
+	if (nblocks == 0)
+		return 0;
+
+	idx = (LPREC_BLOCK)malloc(nblocks * sizeof(REC_BLOCK));
+	if (!idx)
+		return -1;
+
+	for(i=0; i<nblocks; i++) {
+		const unsigned char *ent = &data[idxoffset+i*REC_IDXENTRYSIZE];
+
+		idx[i].m_offset = get64(&ent[0]);
+		idx[i].m_ngames = get32(&ent[8]);
+		idx[i].m_nbytes = get32(&ent[12]);
+		if (idx[i].m_offset + REC_BLKHDRSIZE + idx[i].m_nbytes
+				> idxoffset) {
+			// A corrupt index.  Fall back to walking the blocks
+			free(idx);
+			return rec_scan(data, len, blocks);
+		}
+	}
+
+	*blocks = idx;
+	return nblocks;
+}
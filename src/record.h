@@ -0,0 +1,154 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	record.h
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	Defines a compact binary format for recording games, and the
+//		interface used to read and write it.
+//
+//	A record file starts with an eight byte header: the magic "TTTR", a
+//	version byte, the number of bits per move, and the number of squares
+//	on the board (16 bits).  Games follow, gathered into blocks.  Each block
+//	starts with the number of games within it, and the number of bytes
+//	those games take up (32 bits each).  Every game is then:
+//
+//		seed		32 bits, the seed the game was started with
+//		difficulty	16 bits for black, then 16 bits for white.
+//				REC_HUMAN marks a person, rather than the
+//				computer.
+//		result		8 bits, GB_NOONE, GB_WHITE, GB_BLACK, or GB_TIE
+//		nmoves		8 bits.  A 256 square board may hold 256
+//				moves, recorded as zero.  (A game with no
+//				moves can't have a result, so this is never
+//				ambiguous.)
+//		moves		nmoves squares, packed REC_MOVEBITS (six for a
+//				4x4x4 board) bits each, LSB first, padded to a
+//				whole byte
+//
+//	After the last block comes an index, 16 bytes per block: the offset
+//	of the block within the file (64 bits), the number of games within the
+//	block, and the number of bytes in it.  The file ends with a 16 byte
+//	footer: the offset of the index (64 bits), the number of blocks (32
+//	bits), and the magic "TTRX".  A file without its index, such as one
+//	whose writer never finished, can still be read by walking the blocks.
+//
+//	All values are little endian, regardless of the machine writing them.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#ifndef	RECORD_H
+#define	RECORD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "gboard.h"
+
+#define	REC_VERSION	1
+#define	REC_HUMAN	0xffff
+
+// The number of bits required to hold any square on the board
+#define	REC_MOVEBITS	((NUM_SQUARES <=   64) ? 6	\
+			:(NUM_SQUARES <=  128) ? 7	\
+			:(NUM_SQUARES <=  256) ? 8	\
+			: 9)
+
+#define	REC_HEADERSIZE		8
+#define	REC_BLKHDRSIZE		8
+#define	REC_IDXENTRYSIZE	16
+#define	REC_FOOTERSIZE		16
+#define	REC_GAMEHDRSIZE		10
+#define	REC_MAXGAMESIZE	(REC_GAMEHDRSIZE+(NUM_SQUARES*REC_MOVEBITS+7)/8)
+
+// The writer starts a new block once the current one has reached this size
+#define	REC_BLOCKSIZE	65536
+
+typedef	struct	GAMEREC_S {
+	unsigned	m_seed;
+	// The difficulty each player played at, black first, or REC_HUMAN
+	int		m_difficulty[2];
+	GB_PIECE	m_result;
+	int		m_nmoves;
+	// The moves, in order, starting with black
+	unsigned char	m_moves[NUM_SQUARES];
+} GAMEREC, *LPGAMEREC;
+
+// A description of one block of games
+typedef	struct	REC_BLOCK_S {
+	uint64_t	m_offset;
+	unsigned	m_ngames, m_nbytes;
+} REC_BLOCK, *LPREC_BLOCK;
+
+typedef	struct	RECWRITER_S	RECWRITER, *LPRECWRITER;
+
+/*
+ * rec_open
+ *
+ * Create a record file, returning NULL (and setting errno) on any failure
+ */
+extern	LPRECWRITER	rec_open(const char *fname);
+
+/*
+ * rec_write
+ *
+ * Append a game to the file
+ */
+extern	bool	rec_write(LPRECWRITER w, LPGAMEREC g);
+
+/*
+ * rec_close
+ *
+ * Write any games not yet written, followed by the block index, and close the
+ * file.  Returns false if anything failed to write.
+ */
+extern	bool	rec_close(LPRECWRITER w);
+
+/*
+ * rec_encode, rec_decode
+ *
+ * Convert a single game to and from its binary form.  rec_encode() returns
+ * the number of bytes written (at most REC_MAXGAMESIZE).  rec_decode()
+ * returns the number of bytes used, or zero if the data is invalid.
+ */
+extern	size_t	rec_encode(LPGAMEREC g, unsigned char *buf);
+extern	size_t	rec_decode(const unsigned char *buf, size_t len, LPGAMEREC g);
+
+/*
+ * rec_index
+ *
+ * Given an entire record file in memory, such as from mmap(), check its
+ * header and find its blocks.  The block list is allocated and returned in
+ * *blocks, and the number of blocks is returned.  A negative return means
+ * the data isn't a record file for this size of board.
+ */
+extern	int	rec_index(const unsigned char *data, size_t len,
+			LPREC_BLOCK *blocks);
+
+#endif
@@ -0,0 +1,336 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	replay.c
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	Reads a file of recorded games (see record.h), and replays
+//		every game within it, move by move, asking the computer at
+//	every position what it would have done.  Any move the computer wouldn't
+//	have made is traced back to the rule that ruled it out.  Moves ruled out
+//	by the most important rules (those at or below the -l level, by default
+//	WIN and BLOCK) are counted as blunders.
+//
+//	The file is mapped into memory, and its blocks are divided among a
+//	number of threads.  Results are reported in file order regardless.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#define	_POSIX_C_SOURCE	200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "gboard.h"
+#include "comboset.h"
+#include "strategy.h"
+#include "record.h"
+
+// The results of analyzing one block
+typedef	struct	BLKRESULT_S {
+	unsigned long	m_nmoves, m_nblunders, m_ninvalid;
+	unsigned long	m_rejected[MAX_RULES];
+	// Any verbose output, kept until it can be printed in order
+	char		*m_text;
+	size_t		m_textlen, m_textsize;
+} BLKRESULT, *LPBLKRESULT;
+
+typedef	struct	REPLAY_S {
+	const unsigned char	*m_data;
+	LPREC_BLOCK	m_blocks;
+	int		m_nblocks, m_next;
+	int		m_difficulty, m_blunderlevel;
+	bool		m_verbose;
+	pthread_mutex_t	m_lock;
+	LPBLKRESULT	m_results;
+} REPLAY, *LPREPLAY;
+
+// What the rule watcher needs to know: the move that was played, and the
+// first rule to have ruled it out
+typedef	struct	WATCH_S {
+	int		m_move;
+	const RULE	*m_rejected;
+} WATCH;
+
+static void
+watch_move(void *arg, const RULE *rule, LPVSET result, LPVSET spots) {
+	WATCH	*w = (WATCH *)arg;
+
+	if ((!w->m_rejected)&&(!vs_isable(spots, w->m_move)))
+		w->m_rejected = rule;
+}
+
+static void
+blkprintf(LPBLKRESULT r, const char *fmt, ...) {
+	va_list	ap;
+	int	ln;
+
+	if (r->m_textsize - r->m_textlen < 256) {
+		size_t	sz = r->m_textsize * 2 + 4096;
+		char	*txt = realloc(r->m_text, sz);
+		if (!txt)
+			return;
+		r->m_text = txt;
+		r->m_textsize = sz;
+	}
+
+	va_start(ap, fmt);
+	ln = vsnprintf(r->m_text + r->m_textlen, 256, fmt, ap);
+	va_end(ap);
+	if (ln > 255)
+		ln = 255;
+	r->m_textlen += ln;
+}
+
+/*
+ * replay_game
+ *
+ * Replay one game through the board and the COMBOSET, checking every move
+ * against what the computer would have done.
+ */
+static void
+replay_game(LPREPLAY rp, LPSTRATEGY s, LPGAMEREC g, unsigned long gameno,
+		LPBLKRESULT r) {
+	GBOARD		brd;
+	COMBOSET	cs;
+	VSET		spots;
+	WATCH		w;
+	GB_PIECE	who;
+	int		i, k;
+
+	gb_reset(&brd);
+	cs_init(&cs);
+	set_watch(s, watch_move, &w);
+
+	for(i=0; i<g->m_nmoves; i++) {
+		who = whoseturn(&brd);
+		w.m_move = g->m_moves[i];
+		w.m_rejected = NULL;
+
+		choosemoves(s, &brd, &cs, who, &spots);
+		r->m_nmoves++;
+
+		if (!gb_place(&brd, who, w.m_move)) {
+			r->m_ninvalid++;
+			if (rp->m_verbose)
+				blkprintf(r, "Game %lu, move %d: %d is not a legal move\n",
+					gameno, i+1, w.m_move);
+			break;
+		}
+
+		if (w.m_rejected) {
+			for(k=0; k<s->m_num_rules; k++)
+				if (s->m_rules[k] == w.m_rejected)
+					r->m_rejected[k]++;
+			if (w.m_rejected->m_level <= rp->m_blunderlevel) {
+				r->m_nblunders++;
+				if (rp->m_verbose)
+					blkprintf(r, "Game %lu, move %d: %c to %2d, BLUNDER (%s)\n",
+						gameno, i+1,
+						(who == GB_BLACK) ? 'x':'o',
+						w.m_move,
+						w.m_rejected->m_name);
+			}
+		}
+
+		if (cs_place(&cs, who, w.m_move))
+			brd.m_winner = who;
+	}
+}
+
+static void *
+replay_thread(void *arg) {
+	LPREPLAY	rp = (LPREPLAY)arg;
+	STRATEGY	s;
+	GAMEREC		g;
+	unsigned long	gameno;
+	int		b, k;
+
+	set_difficulty(&s, rp->m_difficulty);
+
+	for(;;) {
+		const unsigned char	*ptr;
+		size_t		left, used;
+		LPBLKRESULT	r;
+
+		pthread_mutex_lock(&rp->m_lock);
+		b = rp->m_next++;
+		pthread_mutex_unlock(&rp->m_lock);
+		if (b >= rp->m_nblocks)
+			break;
+
+		// Number the games from the start of the file
+		gameno = 0;
+		for(k=0; k<b; k++)
+			gameno += rp->m_blocks[k].m_ngames;
+
+		r = &rp->m_results[b];
+		ptr  = &rp->m_data[rp->m_blocks[b].m_offset + REC_BLKHDRSIZE];
+		left = rp->m_blocks[b].m_nbytes;
+		for(k=0; k<(int)rp->m_blocks[b].m_ngames; k++) {
+			used = rec_decode(ptr, left, &g);
+			if (used == 0) {
+				r->m_ninvalid++;
+				break;
+			}
+			replay_game(rp, &s, &g, gameno+k, r);
+			ptr += used;
+			left -= used;
+		}
+	}
+
+	return NULL;
+}
+
+static void
+usage(void) {
+	fprintf(stderr,
+"USAGE: tttt-replay [-d <level>] [-l <level>] [-j <nthreads>] [-v] <file>\n"
+"\n"
+"\t-d <level>\tThe difficulty level to judge moves at, defaults to 1000\n"
+"\t-l <level>\tMoves ruled out by any rule at this level or below count\n"
+"\t\tas blunders.  Defaults to 1 (WIN and BLOCK)\n"
+"\t-j <nthreads>\tThe number of threads to use, defaults to the number\n"
+"\t\tof CPUs\n"
+"\t-v\t\tList every blunder found\n");
+}
+
+int	main(int argc, char **argv) {
+	REPLAY		rp;
+	STRATEGY	s;
+	struct stat	sb;
+	int		fd, opt, nthreads = 0, i, k;
+	unsigned long	ngames = 0, nmoves = 0, nblunders = 0, ninvalid = 0,
+			rejected[MAX_RULES];
+	pthread_t	*threads;
+	void		*data;
+
+	memset(&rp, 0, sizeof(rp));
+	rp.m_difficulty = 1000;
+	rp.m_blunderlevel = 1;
+	while((opt = getopt(argc, argv, "d:hj:l:v")) != -1) {
+		switch(opt) {
+		case 'd': rp.m_difficulty = atoi(optarg); break;
+		case 'j': nthreads = atoi(optarg); break;
+		case 'l': rp.m_blunderlevel = atoi(optarg); break;
+		case 'v': rp.m_verbose = true; break;
+		default:
+			usage();
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (optind+1 != argc) {
+		usage();
+		exit(EXIT_FAILURE);
+	}
+
+	if (nthreads <= 0)
+		nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (nthreads <= 0)
+		nthreads = 1;
+
+	fd = open(argv[optind], O_RDONLY);
+	if ((fd < 0)||(fstat(fd, &sb) < 0)) {
+		perror("O/S Err: Cannot open record file");
+		exit(EXIT_FAILURE);
+	}
+	if (sb.st_size == 0) {
+		fprintf(stderr, "ERR: %s is empty\n", argv[optind]);
+		exit(EXIT_FAILURE);
+	}
+	data = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (data == MAP_FAILED) {
+		perror("O/S Err: Cannot map record file");
+		exit(EXIT_FAILURE);
+	}
+
+	rp.m_data = (const unsigned char *)data;
+	rp.m_nblocks = rec_index(rp.m_data, sb.st_size, &rp.m_blocks);
+	if (rp.m_nblocks < 0) {
+		fprintf(stderr, "ERR: %s is not a record of 4x4x4 games\n",
+			argv[optind]);
+		exit(EXIT_FAILURE);
+	}
+
+	rp.m_results = (LPBLKRESULT)calloc(rp.m_nblocks+1, sizeof(BLKRESULT));
+	threads = (pthread_t *)malloc(nthreads * sizeof(pthread_t));
+	if ((!rp.m_results)||(!threads)) {
+		fprintf(stderr, "ERR: Out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+	pthread_mutex_init(&rp.m_lock, NULL);
+
+	for(i=0; i<nthreads; i++)
+		pthread_create(&threads[i], NULL, replay_thread, &rp);
+	for(i=0; i<nthreads; i++)
+		pthread_join(threads[i], NULL);
+
+	for(k=0; k<MAX_RULES; k++)
+		rejected[k] = 0;
+	for(i=0; i<rp.m_nblocks; i++) {
+		LPBLKRESULT	r = &rp.m_results[i];
+
+		if (r->m_text)
+			fwrite(r->m_text, 1, r->m_textlen, stdout);
+		ngames    += rp.m_blocks[i].m_ngames;
+		nmoves    += r->m_nmoves;
+		nblunders += r->m_nblunders;
+		ninvalid  += r->m_ninvalid;
+		for(k=0; k<MAX_RULES; k++)
+			rejected[k] += r->m_rejected[k];
+		free(r->m_text);
+	}
+
+	set_difficulty(&s, rp.m_difficulty);
+	printf("Games:     %10lu\n", ngames);
+	printf("Moves:     %10lu\n", nmoves);
+	printf("Blunders:  %10lu\n", nblunders);
+	if (ninvalid)
+		printf("Invalid:   %10lu\n", ninvalid);
+	printf("\nMoves ruled out, by rule:\n");
+	for(k=0; k<s.m_num_rules; k++) {
+		if (rejected[k])
+			printf("  %-12s %10lu\n", s.m_rules[k]->m_name,
+				rejected[k]);
+	}
+
+	free(threads);
+	free(rp.m_results);
+	free(rp.m_blocks);
+	munmap(data, sb.st_size);
+	close(fd);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,356 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	rulepool.c
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	Applies the longer rules of a move on a pool of threads.  See
+//		rulepool.h.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#define	_POSIX_C_SOURCE	200809L
+#include <stdlib.h>
+#include <sched.h>
+#include <pthread.h>
+#include "rulepool.h"
+#include "trace.h"
+
+// The state of a task: waiting for someone to apply its rule, being applied,
+// or done (or abandoned)
+#define	RP_PENDING	0
+#define	RP_RUNNING	1
+#define	RP_DONE		2
+
+typedef	struct	RPTASK_S {
+	const RULE	*m_rule;
+	int		m_state;
+	VSET		m_result;
+} RPTASK;
+
+// The long rules of one move, as handed to the workers
+typedef	struct	RPBATCH_S {
+	// The workers' copy of the strategy, stopping whenever the batch is
+	// cancelled or the strategy itself is told to stop
+	STRATEGY	m_strategy;
+	LPSTRATEGY	m_owner;
+	LPGBOARD	m_brd;
+	LPCOMBOSET	m_cs;
+	GB_PIECE	m_who;
+	// The candidates as of when the batch was started, which every later
+	// set of candidates lies within.  m_cands is either &m_candset, or
+	// NULL when there are too many of them to be worth passing.
+	SQSET		m_candset;
+	LPSQSET		m_cands;
+	int		m_cancel;
+	int		m_ntasks;
+	RPTASK		m_tasks[MAX_RULES];
+} RPBATCH, *LPRPBATCH;
+
+struct	RULEPOOL_S {
+	pthread_mutex_t	m_lock;
+	// m_work is signalled when a batch is started, m_idle when the last
+	// worker lets go of one
+	pthread_cond_t	m_work, m_idle;
+	int		m_nthreads;
+	pthread_t	*m_threads;
+	bool		m_quit;
+	// The batch the workers should be working on, which one that is (so
+	// that no worker goes back to a batch it's finished), and how many
+	// workers are within it.  All protected by m_lock.
+	LPRPBATCH	m_batch;
+	unsigned	m_gen;
+	int		m_users;
+	// Set while some move is using the pool
+	int		m_busy;
+};
+
+static bool
+stopping(LPSTRATEGY s)
+{
+	return (s->m_stop)&&(s->m_stop(s->m_stoparg));
+}
+
+/*
+ * batch_stop
+ *
+ * The stop function of the workers' strategy
+ */
+static bool
+batch_stop(void *arg)
+{
+	LPRPBATCH	b = (LPRPBATCH)arg;
+
+	return (__atomic_load_n(&b->m_cancel, __ATOMIC_RELAXED))
+		||(stopping(b->m_owner));
+}
+
+/*
+ * claim
+ *
+ * Take a task on, if nobody else has.
+ */
+static bool
+claim(LPRPBATCH b, int k)
+{
+	int	pending = RP_PENDING;
+
+	return __atomic_compare_exchange_n(&b->m_tasks[k].m_state, &pending,
+		RP_RUNNING, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+static void
+worker_batch(LPRPBATCH b)
+{
+	int	k;
+
+	for(k=0; k<b->m_ntasks; k++) {
+		if (__atomic_load_n(&b->m_cancel, __ATOMIC_RELAXED))
+			break;
+		if (!claim(b, k))
+			continue;
+		(b->m_tasks[k].m_rule->m_fn)(&b->m_strategy, b->m_brd, b->m_cs,
+			b->m_who, &b->m_tasks[k].m_result, b->m_cands);
+		__atomic_store_n(&b->m_tasks[k].m_state, RP_DONE,
+			__ATOMIC_RELEASE);
+	}
+}
+
+static void *
+worker(void *arg)
+{
+	LPRULEPOOL	p = (LPRULEPOOL)arg;
+	LPRPBATCH	b;
+	unsigned	seen = 0;
+
+	pthread_mutex_lock(&p->m_lock);
+	for(;;) {
+		while((!p->m_quit)&&((!p->m_batch)||(p->m_gen == seen)))
+			pthread_cond_wait(&p->m_work, &p->m_lock);
+		if (p->m_quit)
+			break;
+
+		b = p->m_batch;
+		seen = p->m_gen;
+		p->m_users++;
+		pthread_mutex_unlock(&p->m_lock);
+
+		worker_batch(b);
+
+		pthread_mutex_lock(&p->m_lock);
+		if (--p->m_users == 0)
+			pthread_cond_signal(&p->m_idle);
+	}
+	pthread_mutex_unlock(&p->m_lock);
+
+	return NULL;
+}
+
+/*
+ * rp_choose
+ *
+ * The chooser of a strategy with a pool.  Until a first rule finds some move,
+ * this is applyrules() in strategy.c.  From then on, the long rules are
+ * handed to the workers, while we go through the rules in order.
+ */
+static bool
+rp_choose(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who,
+		LPVSET spots)
+{
+	LPRULEPOOL	p = s->m_pool;
+	RPBATCH		b;
+	VSET		others, *result;
+	SQSET		cands;
+	const RULE	*rule;
+	int		rule_number, ncands, k, unused = 0;
+	bool		done = true, started = false;
+
+	vs_clear(spots);
+	for(rule_number=0; rule_number < s->m_num_rules; rule_number++) {
+		if ((rule_number > 0)&&(stopping(s))) {
+			vs_clear(spots);
+			return false;
+		}
+		TRACE_RULE(s->m_rules[rule_number] - get_rule(0), 0);
+		(s->m_rules[rule_number]->m_fn)(s, brd, cs, who, spots, NULL);
+		if (spots->m_active)
+			break;
+	}
+
+	if (++rule_number >= s->m_num_rules)
+		return true;
+	ncands = vs_best(spots, &cands);
+	TRACE_AFTER(ncands);
+	if (ncands <= 1)
+		return true;
+
+	// Gather up the long rules, and hand them to the workers--unless
+	// they're busy with another move
+	b.m_ntasks = 0;
+	for(k=rule_number; k<s->m_num_rules; k++) {
+		if (!rule_isheavy(s->m_rules[k]))
+			continue;
+		b.m_tasks[b.m_ntasks].m_rule  = s->m_rules[k];
+		b.m_tasks[b.m_ntasks].m_state = RP_PENDING;
+		b.m_ntasks++;
+	}
+
+	if ((b.m_ntasks > 1)&&(__atomic_compare_exchange_n(&p->m_busy,
+			&unused, 1, false, __ATOMIC_ACQUIRE,
+			__ATOMIC_RELAXED))) {
+		b.m_strategy = *s;
+		b.m_strategy.m_stop    = batch_stop;
+		b.m_strategy.m_stoparg = &b;
+		b.m_owner = s;
+		b.m_brd   = brd;
+		b.m_cs    = cs;
+		b.m_who   = who;
+		b.m_candset = cands;
+		b.m_cands = (ncands * CS_MAXINCIDENT < cs->m_ninplay)
+				? &b.m_candset : NULL;
+		b.m_cancel = 0;
+
+		pthread_mutex_lock(&p->m_lock);
+		p->m_batch = &b;
+		p->m_gen++;
+		pthread_cond_broadcast(&p->m_work);
+		pthread_mutex_unlock(&p->m_lock);
+		started = true;
+	}
+
+	// Now refine our moves by every rule, in order, just as applyrules()
+	// does
+	for(k=0; rule_number < s->m_num_rules; rule_number++) {
+		if (ncands <= 1)
+			break;
+		if (stopping(s)) {
+			done = false;
+			break;
+		}
+
+		rule = s->m_rules[rule_number];
+		TRACE_RULE(rule - get_rule(0), ncands);
+		if ((k < b.m_ntasks)&&(b.m_tasks[k].m_rule == rule)) {
+			// One of the long rules.  Apply it ourselves if no
+			// worker has yet, otherwise wait for its result.
+			result = &b.m_tasks[k].m_result;
+			if (claim(&b, k)) {
+				(rule->m_fn)(s, brd, cs, who, result,
+					(ncands * CS_MAXINCIDENT
+						< cs->m_ninplay)
+					? &cands : NULL);
+			} else while(__atomic_load_n(&b.m_tasks[k].m_state,
+					__ATOMIC_ACQUIRE) != RP_DONE)
+				sched_yield();
+			k++;
+		} else {
+			result = &others;
+			(rule->m_fn)(s, brd, cs, who, result,
+				(ncands * CS_MAXINCIDENT < cs->m_ninplay)
+				? &cands : NULL);
+		}
+		if (stopping(s)) {
+			done = false;
+			break;
+		}
+
+		ncands = vs_narrow(spots, result, &cands, ncands);
+		TRACE_AFTER(ncands);
+	}
+
+	// Call off the workers, and wait for them to let go of the batch
+	if (started) {
+		__atomic_store_n(&b.m_cancel, 1, __ATOMIC_RELAXED);
+		pthread_mutex_lock(&p->m_lock);
+		p->m_batch = NULL;
+		while(p->m_users > 0)
+			pthread_cond_wait(&p->m_idle, &p->m_lock);
+		pthread_mutex_unlock(&p->m_lock);
+		__atomic_store_n(&p->m_busy, 0, __ATOMIC_RELEASE);
+	}
+
+	return done;
+}
+
+LPRULEPOOL	rp_new(int nthreads) {
+	LPRULEPOOL	p;
+
+	if (nthreads <= 0)
+		return NULL;
+
+	p = (LPRULEPOOL)calloc(1, sizeof(RULEPOOL));
+	if (!p)
+		return NULL;
+	p->m_threads = (pthread_t *)calloc(nthreads, sizeof(pthread_t));
+	if (!p->m_threads) {
+		free(p);
+		return NULL;
+	}
+
+	pthread_mutex_init(&p->m_lock, NULL);
+	pthread_cond_init(&p->m_work, NULL);
+	pthread_cond_init(&p->m_idle, NULL);
+
+	for(p->m_nthreads=0; p->m_nthreads<nthreads; p->m_nthreads++) {
+		if (pthread_create(&p->m_threads[p->m_nthreads], NULL,
+				worker, p) != 0) {
+			rp_free(p);
+			return NULL;
+		}
+	}
+
+	return p;
+}
+
+void	rp_free(LPRULEPOOL p) {
+	int	i;
+
+	if (!p)
+		return;
+
+	pthread_mutex_lock(&p->m_lock);
+	p->m_quit = true;
+	pthread_cond_broadcast(&p->m_work);
+	pthread_mutex_unlock(&p->m_lock);
+
+	for(i=0; i<p->m_nthreads; i++)
+		pthread_join(p->m_threads[i], NULL);
+
+	pthread_mutex_destroy(&p->m_lock);
+	pthread_cond_destroy(&p->m_work);
+	pthread_cond_destroy(&p->m_idle);
+	free(p->m_threads);
+	free(p);
+}
+
+void	rp_attach(LPSTRATEGY s, LPRULEPOOL p) {
+	s->m_pool = p;
+	s->m_choose = (p) ? rp_choose : NULL;
+}
@@ -0,0 +1,81 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	rulepool.h
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	A small pool of threads for spreading the longer rules of a
+//		single move across several CPUs.  Once a strategy has a pool
+//	attached, choosemoves() hands its longer rules (see rule_isheavy())
+//	to the pool as soon as the first rule has found some moves, and then
+//	works through the rules in order itself: applying the short ones,
+//	taking over any long one no worker has started yet, and waiting on
+//	the rest.  The results are combined in priority order, exactly as
+//	without the pool, so the same moves are chosen either way.
+//
+//	Only one move at a time may use a pool.  A move that finds the pool
+//	already in use simply applies every rule itself.
+//
+//	This needs threads, and so is only built on the host.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#ifndef	RULEPOOL_H
+#define	RULEPOOL_H
+
+#include "strategy.h"
+
+typedef	struct	RULEPOOL_S	RULEPOOL, *LPRULEPOOL;
+
+/*
+ * rp_new
+ *
+ * Start a pool of nthreads worker threads.  Returns NULL if the threads, or
+ * the memory for them, can't be had.
+ */
+extern	LPRULEPOOL	rp_new(int nthreads);
+
+/*
+ * rp_free
+ *
+ * Stop the workers, and release the pool.  No strategy may be using it.
+ */
+extern	void	rp_free(LPRULEPOOL p);
+
+/*
+ * rp_attach
+ *
+ * Have the strategy spread its rules across the pool when choosing moves.
+ * set_difficulty() or set_rules() detach it again, as does attaching a NULL
+ * pool.  A watched strategy doesn't use its pool.
+ */
+extern	void	rp_attach(LPSTRATEGY s, LPRULEPOOL p);
+
+#endif
@@ -0,0 +1,82 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	selfplay.c
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	Plays the computer against itself.  This is the same loop as
+//		play_game() in main.c, only with a second strategy in place of
+//	the person at the keyboard.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#include "selfplay.h"
+#include "comboset.h"
+
+GB_PIECE	selfplay(LPSTRATEGY black, LPSTRATEGY white, LPGAMEREC rec) {
+	return selfplay_timed(black, white, rec, NULL);
+}
+
+GB_PIECE	selfplay_timed(LPSTRATEGY black, LPSTRATEGY white, LPGAMEREC rec,
+			LPLATTABLE lat) {
+	GBOARD		brd;
+	COMBOSET	cs;
+	LPSTRATEGY	s;
+	GB_PIECE	who;
+	uint64_t	start = 0;
+	int		mv;
+
+	gb_reset(&brd);
+	cs_init(&cs);
+	rec->m_nmoves = 0;
+
+	while(GB_NOONE != (who = whoseturn(&brd))) {
+		s = (who == GB_BLACK) ? black : white;
+		if (lat)
+			start = lat_now();
+		mv = makemove(s, &brd, &cs, who);
+		if (lat)
+			lat_trecord(lat, s->m_difficulty_level, brd.m_nfilled,
+				lat_now() - start);
+		if ((mv < 0)||(!gb_place(&brd, who, mv))) {
+			brd.m_winner = GB_TIE;
+			break;
+		}
+
+		rec->m_moves[rec->m_nmoves++] = mv;
+		if (cs_place(&cs, who, mv))
+			brd.m_winner = who;
+		else if (brd.m_nfilled >= NUM_SQUARES)
+			brd.m_winner = GB_TIE;
+	}
+
+	rec->m_result = brd.m_winner;
+	return brd.m_winner;
+}
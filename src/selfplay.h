@@ -0,0 +1,65 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	selfplay.h
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	Plays the computer against itself, recording the game.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#ifndef	SELFPLAY_H
+#define	SELFPLAY_H
+
+#include "gboard.h"
+#include "strategy.h"
+#include "record.h"
+#include "latency.h"
+
+/*
+ * selfplay
+ *
+ * Play one game from start to finish, with black following the black
+ * strategy and white the white one.  The moves and the result are placed
+ * into rec.  The seed and difficulty fields of rec are left for the caller.
+ */
+extern	GB_PIECE	selfplay(LPSTRATEGY black, LPSTRATEGY white,
+				LPGAMEREC rec);
+
+/*
+ * selfplay_timed
+ *
+ * The same, while also timing every move, and recording each time into lat
+ * by the difficulty level of the player making it.
+ */
+extern	GB_PIECE	selfplay_timed(LPSTRATEGY black, LPSTRATEGY white,
+				LPGAMEREC rec, LPLATTABLE lat);
+
+#endif
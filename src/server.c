@@ -0,0 +1,901 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	server.c
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	A game server, hosting many games at once within one process.
+//		Clients connect to a Unix domain socket, and then speak a
+//	simple line based protocol.  Every command is one line, and every
+//	command gets exactly one line in return:
+//
+//	NEW [difficulty [seed]]	Start a new game.
+//				Returns "OK <id>"
+//	MOVE <id> <square>	Place a piece for whoever's turn it is.  Squares
+//				are numbered as gb_square() numbers them, 0-63
+//				on the classic board
+//				Returns "OK <id> <square> <status>"
+//	ASK <id>		Have the computer pick a move, and make it.
+//				Returns "MOVE <id> <square> <status>"
+//	STATE <id>		Returns "STATE <id> <position> <status>",
+//				where position is a position string, as
+//				described in position.h, ending with whose
+//				turn it is.
+//	FREE <id>		End a game.  Returns "OK <id>".  If the computer
+//				was still thinking about a move for this game,
+//				it stops, and that ASK is answered with
+//				"ERR <id> cancelled"
+//	LATENCY			Returns "LATENCY <entry> ...", the time
+//				taken to compute moves, with one entry for
+//				each difficulty level, and then one for each
+//				group of fill counts within it:
+//				<level>/<fills>:<count>,<p50>,<p90>,<p99>,<max>
+//				where <fills> is "all", or the range of the
+//				number of squares filled, as "8-15", and the
+//				times are in microseconds.
+//	CACHE			Returns "CACHE <entries> <used> <hits>
+//				<misses> <stores> <evictions>", the counts
+//				kept by the move cache, or "ERR no cache"
+//	QUIT			Close the connection
+//
+//	<status> is one of PLAY, WIN, or TIE.  Any error returns
+//	"ERR [<id>] <reason>".  Games belong to the connection that created
+//	them, and go away when it closes.
+//
+//	The server runs one thread with an epoll() event loop, handling all of
+//	the I/O.  Since the computer's moves take (comparatively) a long time,
+//	ASK requests are handed off as jobs to an engine (see jobs.h), with its
+//	own pool of worker threads.  Finished jobs are returned through a list,
+//	waking the event loop with an eventfd.  While a game has a job out,
+//	any other requests for it (save FREE) are refused as busy.  Closing a
+//	connection cancels all of its jobs.
+//
+//	Games are drawn from a TTTT_POOL, sized by the -g option, so that
+//	starting a game costs little more than a memcpy().  Should the pool
+//	run dry, further games are allocated one at a time.
+//
+//	Every game shares one move cache (see movecache.h), sized by the -c
+//	option, so a position any game has already seen, at the same
+//	difficulty, is answered without thinking about it again.  With -s, the
+//	cache is kept in shared memory instead, shared with every other server
+//	on the host given the same name, and kept warm across restarts.
+//
+//	This program only builds on the (Linux) host.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#define	_GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "tttt.h"
+#include "jobs.h"
+#include "latency.h"
+
+#define	SV_MAXLINE	256
+// The longest any one conn_printf() may write: the longest being STATE, with
+// a whole position
+#define	SV_MAXOUT	(POS_STRLEN + 64)
+#define	SV_MAXEVENTS	64
+#define	SV_DIFFICULTY	1000
+#define	SV_POOLSIZE	4096
+#define	SV_CACHESIZE	65536
+
+typedef	struct	CONN_S	CONN, *LPCONN;
+typedef	struct	GAME_S	GAME, *LPGAME;
+
+struct	GAME_S {
+	LPTTTT	m_game;
+	// The connection that owns this game
+	LPCONN	m_conn;
+	int	m_id;
+	// A game is busy while a job is computing a move for it.  If the
+	// client frees the game meanwhile, it's only marked as m_freed until
+	// the job comes back.
+	bool	m_busy, m_freed;
+	LPTTTT_JOB	m_job;
+	// What the computer's move was asked at, and when the job for it
+	// was submitted and finished, for the latency table
+	int		m_difficulty, m_nfilled;
+	uint64_t	m_submitted, m_finished;
+	// m_next links the game into the done list, m_cnext links it into the
+	// list of games owned by its connection
+	LPGAME	m_next, m_cnext;
+};
+
+struct	CONN_S {
+	int	m_fd;
+	// The number of this connections games that have jobs out.  We
+	// can't free the connection until these come back.
+	int	m_pending;
+	bool	m_closed, m_wantout;
+	// Set once the connection is on the reap list, m_reapnext linking it
+	bool	m_reaped;
+	LPCONN	m_reapnext;
+	LPGAME	m_games;
+	int	m_inlen;
+	char	m_in[SV_MAXLINE];
+	int	m_outlen, m_outsize;
+	char	*m_out;
+};
+
+//
+// Event loop state.  This is only ever touched by the main thread.
+//
+static	int	sv_epfd, sv_listenfd, sv_evfd;
+static	LPGAME	*sv_games;
+static	int	sv_ngames, sv_nslots, *sv_freeids, sv_nfree;
+static	unsigned	sv_seed;
+static	LPTTTT_POOL	sv_pool;
+static	LPMOVECACHE	sv_cache;
+// Connections closed, and no longer referred to, waiting to be freed
+static	LPCONN	sv_reap;
+static	LPTTTT_ENGINE	sv_engine;
+static	unsigned	sv_budget;
+static	LATTABLE	sv_lat;
+
+//
+// The list of games whose jobs are done, protected by sv_lock
+//
+static	pthread_mutex_t	sv_lock = PTHREAD_MUTEX_INITIALIZER;
+static	LPGAME	sv_done;
+
+/*
+ * job_done
+ *
+ * Called by the engine, from whichever thread finished the job, once a job is
+ * done or cancelled.  Place the game onto the done list, and wake the event
+ * loop to answer it.
+ */
+static void
+job_done(void *arg, LPTTTT_JOB job) {
+	LPGAME		g = (LPGAME)arg;
+	uint64_t	one = 1;
+
+	g->m_finished = lat_now();
+	pthread_mutex_lock(&sv_lock);
+	g->m_next = sv_done;
+	sv_done = g;
+	pthread_mutex_unlock(&sv_lock);
+
+	if (write(sv_evfd, &one, sizeof(one)) < 0)
+		perror("O/S Err: eventfd write");
+}
+
+static bool
+submit(LPGAME g) {
+	g->m_busy = true;
+	g->m_conn->m_pending++;
+	g->m_nfilled = tttt_nfilled(g->m_game);
+	g->m_submitted = lat_now();
+	g->m_job = tttt_job_submit(sv_engine, g->m_game, sv_budget,
+			job_done, g);
+	if (!g->m_job) {
+		g->m_busy = false;
+		g->m_conn->m_pending--;
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * game_new
+ *
+ * Allocate a game, and give it an ID.  IDs are recycled once the game using
+ * them is freed.
+ */
+static LPGAME
+game_new(LPCONN c, int difficulty, unsigned seed) {
+	LPGAME	g;
+	int	id;
+
+	g = (LPGAME)calloc(1, sizeof(GAME));
+	if (!g)
+		return NULL;
+	g->m_game = tttt_pool_acquire(sv_pool, difficulty, seed);
+	if (!g->m_game)
+		g->m_game = tttt_new(difficulty, seed);
+	if (!g->m_game) {
+		free(g);
+		return NULL;
+	}
+	tttt_setcache(g->m_game, sv_cache);
+
+	if (sv_nfree > 0)
+		id = sv_freeids[--sv_nfree];
+	else {
+		if (sv_ngames >= sv_nslots) {
+			int	nslots = (sv_nslots) ? sv_nslots * 2 : 1024;
+			LPGAME	*games;
+			int	*ids;
+
+			games = realloc(sv_games, nslots * sizeof(LPGAME));
+			if (games)
+				sv_games = games;
+			ids = realloc(sv_freeids, nslots * sizeof(int));
+			if (ids)
+				sv_freeids = ids;
+			if ((!games)||(!ids)) {
+				tttt_free(g->m_game);
+				free(g);
+				return NULL;
+			}
+			sv_nslots = nslots;
+		}
+		id = sv_ngames++;
+	}
+
+	g->m_id = id;
+	g->m_difficulty = difficulty;
+	g->m_conn = c;
+	g->m_cnext = c->m_games;
+	c->m_games = g;
+	sv_games[id] = g;
+	return g;
+}
+
+static void
+game_free(LPGAME g) {
+	sv_games[g->m_id] = NULL;
+	sv_freeids[sv_nfree++] = g->m_id;
+	tttt_free(g->m_game);
+	free(g);
+}
+
+/*
+ * game_release
+ *
+ * Remove a game from its connection's list, and then free it.
+ */
+static void
+game_release(LPGAME g) {
+	LPGAME	*pp;
+
+	for(pp = &g->m_conn->m_games; *pp; pp = &(*pp)->m_cnext) {
+		if (*pp == g) {
+			*pp = g->m_cnext;
+			break;
+		}
+	}
+	game_free(g);
+}
+
+static void
+conn_free(LPCONN c) {
+	free(c->m_out);
+	free(c);
+}
+
+/*
+ * conn_close
+ *
+ * Close a connection, and free all of its games.  Any games that still have
+ * jobs out have those jobs cancelled, and will be freed as they come back.
+ * The connection itself is left for conn_reap() to free, once nothing refers
+ * to it anymore.
+ */
+static void
+conn_close(LPCONN c) {
+	LPGAME	g, nxt;
+
+	if (c->m_closed)
+		return;
+	c->m_closed = true;
+	close(c->m_fd);
+
+	for(g = c->m_games; g; g = nxt) {
+		nxt = g->m_cnext;
+		if (g->m_busy)
+			tttt_job_cancel(g->m_job);
+		else
+			game_free(g);
+	} c->m_games = NULL;
+}
+
+/*
+ * conn_reap
+ *
+ * Once a closed connection has no games with jobs out, place it onto the
+ * reap list.  It can't be freed at once, since later events from the same
+ * epoll_wait() may still refer to it.  The event loop frees the list, with
+ * reap_conns(), once it has handled all of them.
+ */
+static void
+conn_reap(LPCONN c) {
+	if ((c->m_closed)&&(c->m_pending == 0)&&(!c->m_reaped)) {
+		c->m_reaped = true;
+		c->m_reapnext = sv_reap;
+		sv_reap = c;
+	}
+}
+
+/*
+ * reap_conns
+ *
+ * Free every connection on the reap list
+ */
+static void
+reap_conns(void) {
+	LPCONN	c;
+
+	while(NULL != (c = sv_reap)) {
+		sv_reap = c->m_reapnext;
+		conn_free(c);
+	}
+}
+
+/*
+ * conn_flush
+ *
+ * Write as much of our pending output as the socket will take.  If it won't
+ * take it all, ask epoll to tell us when we can write more.
+ */
+static void
+conn_flush(LPCONN c) {
+	int	nw, done = 0;
+
+	while(done < c->m_outlen) {
+		nw = send(c->m_fd, c->m_out + done, c->m_outlen - done,
+				MSG_NOSIGNAL);
+		if (nw < 0) {
+			if (errno == EINTR)
+				continue;
+			if ((errno != EAGAIN)&&(errno != EWOULDBLOCK)) {
+				c->m_outlen = 0;
+				conn_close(c);
+				return;
+			} break;
+		} done += nw;
+	}
+
+	if (done > 0) {
+		memmove(c->m_out, c->m_out + done, c->m_outlen - done);
+		c->m_outlen -= done;
+	}
+
+	if ((c->m_outlen > 0) != c->m_wantout) {
+		struct epoll_event	ev;
+
+		c->m_wantout = (c->m_outlen > 0);
+		ev.events = EPOLLIN | ((c->m_wantout) ? EPOLLOUT : 0);
+		ev.data.ptr = c;
+		epoll_ctl(sv_epfd, EPOLL_CTL_MOD, c->m_fd, &ev);
+	}
+}
+
+static void
+conn_printf(LPCONN c, const char *fmt, ...)
+	__attribute__((format(printf, 2, 3)));
+
+static void
+conn_printf(LPCONN c, const char *fmt, ...) {
+	va_list	ap;
+	int	ln;
+
+	if (c->m_closed)
+		return;
+
+	if (c->m_outsize - c->m_outlen < SV_MAXOUT) {
+		int	sz = c->m_outsize * 2 + SV_MAXOUT;
+		char	*out = realloc(c->m_out, sz);
+		if (!out) {
+			conn_close(c);
+			return;
+		}
+		c->m_out = out;
+		c->m_outsize = sz;
+	}
+
+	va_start(ap, fmt);
+	ln = vsnprintf(c->m_out + c->m_outlen, SV_MAXOUT, fmt, ap);
+	va_end(ap);
+	if (ln >= SV_MAXOUT)
+		ln = SV_MAXOUT-1;
+	c->m_outlen += ln;
+}
+
+static const char *
+status(TTTT_RESULT r) {
+	if (r == TTTT_WIN)
+		return "WIN";
+	else if (r == TTTT_TIE)
+		return "TIE";
+	return "PLAY";
+}
+
+/*
+ * lookup
+ *
+ * Find the game with the given ID, making certain it belongs to the
+ * connection asking for it, and (unless busyok) that it has no job out.
+ */
+static LPGAME
+lookup(LPCONN c, const char *arg, int *idp, bool busyok) {
+	LPGAME	g;
+	int	id;
+
+	if ((!arg)||(sscanf(arg, "%d", &id) != 1)) {
+		conn_printf(c, "ERR missing game ID\n");
+		return NULL;
+	} *idp = id;
+
+	if ((id < 0)||(id >= sv_ngames)||(!sv_games[id])
+			||(sv_games[id]->m_conn != c)
+			||(sv_games[id]->m_freed)) {
+		conn_printf(c, "ERR %d no such game\n", id);
+		return NULL;
+	}
+
+	g = sv_games[id];
+	if ((g->m_busy)&&(!busyok)) {
+		conn_printf(c, "ERR %d busy\n", id);
+		return NULL;
+	}
+
+	return g;
+}
+
+static void
+latency_entry(LPCONN c, int level, const char *fills, const LATHIST *h) {
+	conn_printf(c, " %d/%s:%lu,%.1f,%.1f,%.1f,%.1f", level, fills,
+		h->m_count, lat_percentile(h, 50) / 1e3,
+		lat_percentile(h, 90) / 1e3, lat_percentile(h, 99) / 1e3,
+		h->m_max / 1e3);
+}
+
+/*
+ * latency
+ *
+ * Answer a LATENCY command, from the latency table
+ */
+static void
+latency(LPCONN c) {
+	LATHIST	all;
+	char	fills[16];
+	int	k, f;
+
+	conn_printf(c, "LATENCY");
+	for(k=0; k<sv_lat.m_nlevels; k++) {
+		lat_clear(&all);
+		for(f=0; f<LAT_NFILLS; f++)
+			lat_merge(&all, &sv_lat.m_hist[k][f]);
+		latency_entry(c, sv_lat.m_levels[k], "all", &all);
+		for(f=0; f<LAT_NFILLS; f++) {
+			if (sv_lat.m_hist[k][f].m_count == 0)
+				continue;
+			sprintf(fills, "%d-%d", f * LAT_FILLSTEP,
+				(f+1) * LAT_FILLSTEP - 1);
+			latency_entry(c, sv_lat.m_levels[k], fills,
+				&sv_lat.m_hist[k][f]);
+		}
+	} conn_printf(c, "\n");
+}
+
+/*
+ * cache
+ *
+ * Answer a CACHE command, from the move cache's counters
+ */
+static void
+cache(LPCONN c) {
+	MC_STATS	st;
+
+	if (!sv_cache) {
+		conn_printf(c, "ERR no cache\n");
+		return;
+	}
+	mc_stats(sv_cache, &st);
+	conn_printf(c, "CACHE %u %u %lu %lu %lu %lu\n", st.m_nentries,
+		st.m_nused, st.m_hits, st.m_misses, st.m_stores,
+		st.m_evictions);
+}
+
+/*
+ * command
+ *
+ * Process one line of input from a client.
+ */
+static void
+command(LPCONN c, char *line) {
+	char	*cmd, *arg1, *arg2, *save;
+	LPGAME	g;
+	int	id;
+
+	cmd  = strtok_r(line, " \t\r\n", &save);
+	arg1 = strtok_r(NULL, " \t\r\n", &save);
+	arg2 = strtok_r(NULL, " \t\r\n", &save);
+
+	if (!cmd)
+		return;
+	else if (strcasecmp(cmd, "NEW")==0) {
+		int		difficulty = SV_DIFFICULTY;
+		unsigned	seed;
+
+		if (arg1)
+			difficulty = atoi(arg1);
+		if (arg2)
+			seed = strtoul(arg2, NULL, 0);
+		else
+			seed = sv_seed++;
+		g = game_new(c, difficulty, seed);
+		if (!g)
+			conn_printf(c, "ERR out of memory\n");
+		else
+			conn_printf(c, "OK %d\n", g->m_id);
+	} else if (strcasecmp(cmd, "MOVE")==0) {
+		TTTT_RESULT	r;
+		int		where;
+
+		if (NULL == (g = lookup(c, arg1, &id, false)))
+			return;
+		if ((!arg2)||(sscanf(arg2, "%d", &where) != 1)) {
+			conn_printf(c, "ERR %d missing square\n", id);
+			return;
+		}
+		r = tttt_play(g->m_game, where);
+		if ((r == TTTT_OK)||(r == TTTT_WIN)||(r == TTTT_TIE))
+			conn_printf(c, "OK %d %d %s\n", id, where, status(r));
+		else
+			conn_printf(c, "ERR %d %s\n", id, tttt_strerror(r));
+	} else if (strcasecmp(cmd, "ASK")==0) {
+		if (NULL == (g = lookup(c, arg1, &id, false)))
+			return;
+		if (tttt_whoseturn(g->m_game) == GB_NOONE)
+			conn_printf(c, "ERR %d %s\n", id,
+				tttt_strerror(TTTT_GAMEOVER));
+		else if (!submit(g))
+			conn_printf(c, "ERR %d out of memory\n", id);
+	} else if (strcasecmp(cmd, "STATE")==0) {
+		char		pos[POS_STRLEN+1];
+		GB_PIECE	w;
+
+		if (NULL == (g = lookup(c, arg1, &id, false)))
+			return;
+		tttt_getposition(g->m_game, pos);
+		w = tttt_winner(g->m_game);
+		conn_printf(c, "STATE %d %s %s\n", id, pos,
+			(w == GB_TIE) ? "TIE"
+			: (w != GB_NOONE) ? "WIN" : "PLAY");
+	} else if (strcasecmp(cmd, "FREE")==0) {
+		if (NULL == (g = lookup(c, arg1, &id, true)))
+			return;
+		if (g->m_busy) {
+			// The game goes away once its job comes back
+			g->m_freed = true;
+			tttt_job_cancel(g->m_job);
+		} else
+			game_release(g);
+		conn_printf(c, "OK %d\n", id);
+	} else if (strcasecmp(cmd, "LATENCY")==0) {
+		latency(c);
+	} else if (strcasecmp(cmd, "CACHE")==0) {
+		cache(c);
+	} else if (strcasecmp(cmd, "QUIT")==0) {
+		conn_flush(c);
+		conn_close(c);
+	} else
+		conn_printf(c, "ERR unknown command %s\n", cmd);
+
+}
+
+/*
+ * conn_read
+ *
+ * Read whatever is available from a client, and process any complete lines
+ * found within it.
+ */
+static void
+conn_read(LPCONN c) {
+	int	nr, i, start;
+
+	for(;;) {
+		nr = read(c->m_fd, c->m_in + c->m_inlen,
+				SV_MAXLINE - c->m_inlen);
+		if (nr == 0) {
+			conn_close(c);
+			return;
+		} else if (nr < 0) {
+			if (errno == EINTR)
+				continue;
+			if ((errno != EAGAIN)&&(errno != EWOULDBLOCK))
+				conn_close(c);
+			break;
+		}
+
+		c->m_inlen += nr;
+		start = 0;
+		for(i=0; (i<c->m_inlen)&&(!c->m_closed); i++) {
+			if (c->m_in[i] == '\n') {
+				c->m_in[i] = '\0';
+				command(c, &c->m_in[start]);
+				start = i+1;
+			}
+		}
+
+		if (c->m_closed)
+			return;
+
+		if (start > 0) {
+			memmove(c->m_in, &c->m_in[start], c->m_inlen - start);
+			c->m_inlen -= start;
+		} else if (c->m_inlen >= SV_MAXLINE) {
+			// Drop any line that's too long to be a valid command
+			conn_printf(c, "ERR line too long\n");
+			c->m_inlen = 0;
+		}
+	}
+
+	conn_flush(c);
+}
+
+static void
+accept_conns(void) {
+	struct epoll_event	ev;
+	LPCONN	c;
+	int	fd;
+
+	while((fd = accept4(sv_listenfd, NULL, NULL, SOCK_NONBLOCK)) >= 0) {
+		c = (LPCONN)calloc(1, sizeof(CONN));
+		if (!c) {
+			close(fd);
+			continue;
+		}
+		c->m_fd = fd;
+		ev.events = EPOLLIN;
+		ev.data.ptr = c;
+		if (epoll_ctl(sv_epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+			close(fd);
+			free(c);
+		}
+	}
+}
+
+/*
+ * finish_jobs
+ *
+ * Answer all of the ASK requests whose jobs have finished.
+ */
+static void
+finish_jobs(void) {
+	LPGAME	g, nxt;
+	LPCONN	c;
+	uint64_t	count;
+
+	if (read(sv_evfd, &count, sizeof(count)) < 0)
+		return;
+
+	pthread_mutex_lock(&sv_lock);
+	g = sv_done;
+	sv_done = NULL;
+	pthread_mutex_unlock(&sv_lock);
+
+	for(; g; g = nxt) {
+		TTTT_JOBSTATE	state;
+		TTTT_RESULT	r;
+		int		mv = -1;
+
+		nxt = g->m_next;
+		c = g->m_conn;
+		state = tttt_job_poll(g->m_job);
+		r = tttt_job_result(g->m_job, &mv);
+		tttt_job_free(g->m_job);
+		g->m_job = NULL;
+		g->m_busy = false;
+		c->m_pending--;
+
+		if (c->m_closed) {
+			game_free(g);
+			conn_reap(c);
+			continue;
+		}
+
+		if (g->m_freed) {
+			conn_printf(c, "ERR %d cancelled\n", g->m_id);
+			game_release(g);
+		} else if (state != TTTT_JOB_DONE)
+			conn_printf(c, "ERR %d cancelled\n", g->m_id);
+		else {
+			lat_trecord(&sv_lat, g->m_difficulty, g->m_nfilled,
+				g->m_finished - g->m_submitted);
+			if (r == TTTT_OK)
+				r = tttt_play(g->m_game, mv);
+			if ((r == TTTT_OK)||(r == TTTT_WIN)||(r == TTTT_TIE))
+				conn_printf(c, "MOVE %d %d %s\n", g->m_id, mv,
+					status(r));
+			else
+				conn_printf(c, "ERR %d %s\n", g->m_id,
+					tttt_strerror(r));
+		}
+		conn_flush(c);
+		conn_reap(c);
+	}
+}
+
+static void
+usage(void) {
+	fprintf(stderr,
+"USAGE: tttt-server [-c <entries>] [-g <ngames>] [-j <nthreads>]\n"
+"\t\t[-s <name>] [-t <msecs>] <socket-path>\n"
+"\n"
+"\t-c <entries>\tNumber of positions the move cache has room for, or\n"
+"\t\tzero for no cache.  Defaults to %d\n"
+"\t-g <ngames>\tNumber of games to preallocate room for.  Defaults to %d\n"
+"\t-j <nthreads>\tNumber of worker threads to compute moves with.  Defaults\n"
+"\t\tto the number of CPUs\n"
+"\t-s <name>\tKeep the move cache in the POSIX shared memory object\n"
+"\t\t<name>, such as /tttt, shared by every server given the same\n"
+"\t\tname.  The first server creates it, with room for -c entries\n"
+"\t-t <msecs>\tThe longest the computer may think about any one move.\n"
+"\t\tWhen out of time, it plays the best move it has found so far.\n"
+"\t\tDefaults to no limit\n", SV_CACHESIZE, SV_POOLSIZE);
+}
+
+int	main(int argc, char **argv) {
+	struct sockaddr_un	addr;
+	struct epoll_event	ev, events[SV_MAXEVENTS];
+	int	nthreads = 0, poolsize = SV_POOLSIZE, opt, i, n;
+	int	cachesize = SV_CACHESIZE;
+	const char	*cachename = NULL;
+
+	while((opt = getopt(argc, argv, "c:g:j:s:t:h")) != -1) {
+		switch(opt) {
+		case 'c': cachesize = atoi(optarg); break;
+		case 'g': poolsize = atoi(optarg); break;
+		case 'j': nthreads = atoi(optarg); break;
+		case 's': cachename = optarg; break;
+		case 't': sv_budget = strtoul(optarg, NULL, 0) * 1000; break;
+		default:
+			usage();
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (optind+1 != argc) {
+		usage();
+		exit(EXIT_FAILURE);
+	}
+
+	if (nthreads <= 0)
+		nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (nthreads <= 0)
+		nthreads = 1;
+
+	sv_seed = (unsigned)time(NULL);
+	lat_tclear(&sv_lat);
+	if (poolsize > 0) {
+		sv_pool = tttt_pool_new(poolsize);
+		if (!sv_pool) {
+			fprintf(stderr, "ERR: No memory for %d games\n",
+				poolsize);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if ((cachename)&&(cachesize > 0)) {
+		sv_cache = mc_attach(cachename, cachesize);
+		if (!sv_cache) {
+			perror("O/S Err: Cannot attach the shared cache");
+			exit(EXIT_FAILURE);
+		}
+	} else if (cachesize > 0) {
+		sv_cache = mc_new(cachesize);
+		if (!sv_cache) {
+			fprintf(stderr, "ERR: No memory for a cache of %d\n",
+				cachesize);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(argv[optind]) >= sizeof(addr.sun_path)) {
+		fprintf(stderr, "ERR: Socket path is too long\n");
+		exit(EXIT_FAILURE);
+	}
+	strcpy(addr.sun_path, argv[optind]);
+	unlink(addr.sun_path);
+
+	sv_listenfd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+	if ((sv_listenfd < 0)
+		||(bind(sv_listenfd, (struct sockaddr *)&addr, sizeof(addr))<0)
+		||(listen(sv_listenfd, SOMAXCONN) < 0)) {
+		perror("O/S Err: Cannot listen on socket");
+		exit(EXIT_FAILURE);
+	}
+
+	sv_evfd = eventfd(0, EFD_NONBLOCK);
+	sv_epfd = epoll_create1(0);
+	if ((sv_evfd < 0)||(sv_epfd < 0)) {
+		perror("O/S Err: Cannot create event loop");
+		exit(EXIT_FAILURE);
+	}
+
+	// The listening socket is identified by a NULL pointer, and the
+	// eventfd by a pointer to its own descriptor.  Everything else is a
+	// connection.
+	ev.events = EPOLLIN;
+	ev.data.ptr = NULL;
+	epoll_ctl(sv_epfd, EPOLL_CTL_ADD, sv_listenfd, &ev);
+	ev.data.ptr = &sv_evfd;
+	epoll_ctl(sv_epfd, EPOLL_CTL_ADD, sv_evfd, &ev);
+
+	sv_engine = tttt_engine_new(nthreads);
+	if (!sv_engine) {
+		perror("O/S Err: Cannot start workers");
+		exit(EXIT_FAILURE);
+	}
+
+	for(;;) {
+		n = epoll_wait(sv_epfd, events, SV_MAXEVENTS, -1);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("O/S Err: epoll_wait");
+			break;
+		}
+
+		for(i=0; i<n; i++) {
+			void	*ptr = events[i].data.ptr;
+
+			if (ptr == NULL)
+				accept_conns();
+			else if (ptr == &sv_evfd)
+				finish_jobs();
+			else {
+				LPCONN	c = (LPCONN)ptr;
+
+				// Its descriptor may already be another's
+				if (c->m_closed)
+					continue;
+				if (events[i].events & (EPOLLERR|EPOLLHUP))
+					conn_close(c);
+				else if (events[i].events & EPOLLIN)
+					conn_read(c);
+				else if (events[i].events & EPOLLOUT)
+					conn_flush(c);
+				conn_reap(c);
+			}
+		}
+
+		reap_conns();
+	}
+
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,414 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	stackuse.c
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	Report the most stack a call to one function might use, from the
+//		call graphs GCC writes with -fcallgraph-info=su.  Each .ci
+//	file given lists the functions of one source file, the stack each one
+//	uses, and whom each calls.  We join them together, and then walk down
+//	from the function named looking for the deepest path.
+//
+//	The compiler can't see through calls made via function pointers.  The
+//	-i option tells us where those may go: -i "caller=fn fn fn ..." says
+//	that any call through a pointer made by caller may reach any of the
+//	functions listed.  -i may be given once for each such caller.  Any
+//	other call we have no stack numbers for--calls
+//	to the C library, or through pointers we weren't told about--is listed
+//	at the end as not counted.
+//
+//	Usage: stackuse [-i "caller=fn ..."]... function file.ci ...
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#define	_POSIX_C_SOURCE	200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define	MAXNODES	1024
+#define	MAXEDGES	8192
+#define	MAXINDIRECT	8
+#define	MAXNAME		128
+
+typedef	struct	NODE_S {
+	char	m_title[MAXNAME],	// Unique: file:name for static functions
+		m_name[MAXNAME],	// As given in the source
+		m_where[MAXNAME];	// file:line:col
+	long	m_bytes;		// Stack used by this function alone
+	int	m_known,		// Do we know how much stack it uses?
+		m_dynamic,		// Does that depend upon its arguments?
+		m_state,		// 0 unvisited, 1 on our path, 2 done
+		m_next;			// The next step down the deepest path
+	long	m_worst;		// The deepest path from here, in bytes
+} NODE;
+
+typedef	struct	EDGE_S {
+	int	m_from, m_to;
+} EDGE;
+
+static	NODE	nodes[MAXNODES];
+static	EDGE	edges[MAXEDGES];
+static	int	nnodes = 0, nedges = 0;
+
+// The -i options, each split on '=': who makes the indirect calls, and where
+// they may go
+static	struct {
+	const char	*m_caller, *m_targets;
+} indirect[MAXINDIRECT];
+static	int	nindirect = 0;
+
+/*
+ * findnode
+ *
+ * Look up a node by its title, adding it if we haven't seen it before.
+ */
+static int
+findnode(const char *title)
+{
+	int	i;
+
+	for(i=0; i<nnodes; i++)
+		if (strcmp(nodes[i].m_title, title)==0)
+			return i;
+	if (nnodes >= MAXNODES) {
+		fprintf(stderr, "ERR: Too many functions\n");
+		exit(EXIT_FAILURE);
+	}
+
+	memset(&nodes[nnodes], 0, sizeof(NODE));
+	strncpy(nodes[nnodes].m_title, title, MAXNAME-1);
+	nodes[nnodes].m_next = -1;
+	return nnodes++;
+}
+
+/*
+ * quoted
+ *
+ * Copy out the quoted string following key within line.  Returns NULL if
+ * key isn't there.
+ */
+static char *
+quoted(const char *line, const char *key, char *buf)
+{
+	const char	*p = strstr(line, key), *e;
+	size_t		n;
+
+	if (!p)
+		return NULL;
+	p += strlen(key);
+	while((*p)&&(*p != '"'))
+		p++;
+	if (!*p)
+		return NULL;
+	p++;
+	if (NULL == (e = strchr(p, '"')))
+		return NULL;
+	n = e - p;
+	if (n >= MAXNAME)
+		n = MAXNAME-1;
+	memcpy(buf, p, n);
+	buf[n] = '\0';
+	return buf;
+}
+
+/*
+ * readci
+ *
+ * Read one .ci file, as GCC writes it.  Nodes look like
+ *
+ *	node: { title: "file.c:sum" label: "sum\nfile.c:237:1\n64 bytes (static)" }
+ *
+ * where the label's escaped newlines separate the name, where it is, and (for
+ * those functions defined in this file) its stack use.  Edges look like
+ *
+ *	edge: { sourcename: "file.c:win" targetname: "file.c:sum" ... }
+ */
+static void
+readci(const char *fname)
+{
+	FILE	*fp;
+	char	line[1024], title[MAXNAME], label[MAXNAME], to[MAXNAME];
+
+	if (NULL == (fp = fopen(fname, "r"))) {
+		fprintf(stderr, "ERR: Could not open %s\n", fname);
+		exit(EXIT_FAILURE);
+	}
+
+	while(fgets(line, sizeof(line), fp)) {
+		if (strncmp(line, "node:", 5)==0) {
+			char	*nl, *bytes;
+			NODE	*np;
+
+			if ((!quoted(line, "title:", title))
+					||(!quoted(line, "label:", label)))
+				continue;
+			np = &nodes[findnode(title)];
+
+			// The name comes first, up to the first "\n"
+			if (NULL != (nl = strstr(label, "\\n")))
+				*nl = '\0';
+			strcpy(np->m_name, label);
+			if (!nl)
+				continue;
+
+			// Then where it is, and then how much stack it uses
+			bytes = strstr(nl+2, "\\n");
+			if (bytes)
+				*bytes = '\0';
+			if (!np->m_known)
+				strcpy(np->m_where, nl+2);
+			if ((bytes)&&(strstr(bytes+2, "bytes"))) {
+				long	b = atol(bytes+2);
+
+				// A function defined twice (a static inline,
+				// say) counts for the larger of the two
+				if ((!np->m_known)||(b > np->m_bytes))
+					np->m_bytes = b;
+				np->m_known = 1;
+				if ((strstr(bytes+2, "dynamic"))
+					&&(!strstr(bytes+2, "bounded")))
+					np->m_dynamic = 1;
+			}
+		} else if (strncmp(line, "edge:", 5)==0) {
+			if ((!quoted(line, "sourcename:", title))
+					||(!quoted(line, "targetname:", to)))
+				continue;
+			if (nedges >= MAXEDGES) {
+				fprintf(stderr, "ERR: Too many calls\n");
+				exit(EXIT_FAILURE);
+			}
+			edges[nedges].m_from = findnode(title);
+			edges[nedges].m_to   = findnode(to);
+			nedges++;
+		}
+	} fclose(fp);
+}
+
+/*
+ * findcaller
+ *
+ * Which of the -i options, if any, is for calls made by name?  Returns -1 if
+ * none is.
+ */
+static int
+findcaller(const char *name)
+{
+	int	k;
+
+	for(k=0; k<nindirect; k++)
+		if (strcmp(indirect[k].m_caller, name)==0)
+			return k;
+	return -1;
+}
+
+/*
+ * istarget
+ *
+ * Is name one of the functions an indirect call, from the caller of the k'th
+ * -i option, may reach?  The list is separated by spaces or commas.
+ */
+static int
+istarget(int k, const char *name)
+{
+	const char	*p = indirect[k].m_targets;
+	size_t		n = strlen(name);
+
+	while((p)&&(*p)) {
+		size_t	len = strcspn(p, " ,\t");
+
+		if ((len == n)&&(strncmp(p, name, n)==0))
+			return 1;
+		p += len;
+		p += strspn(p, " ,\t");
+	} return 0;
+}
+
+/*
+ * callee
+ *
+ * Return the next function called by node from, after edge *e, and advance
+ * *e--expanding any indirect call from our indirect caller into each of its
+ * targets.  Returns -1 when there are no more.  *t holds our place among the
+ * targets.
+ */
+static int
+callee(int from, int *e, int *t)
+{
+	int	k = findcaller(nodes[from].m_name);
+
+	for(; *e < nedges; (*e)++, *t = 0) {
+		EDGE	*ep = &edges[*e];
+
+		if (ep->m_from != from)
+			continue;
+		if ((strcmp(nodes[ep->m_to].m_title, "__indirect_call")!=0)
+				||(k < 0)) {
+			if (*t == 0) {
+				(*t)++;
+				return ep->m_to;
+			} continue;
+		}
+
+		for(; *t < nnodes; (*t)++) {
+			if ((nodes[*t].m_known)&&(istarget(k, nodes[*t].m_name)))
+				return (*t)++;
+		}
+	} return -1;
+}
+
+/*
+ * worst
+ *
+ * Find the deepest path down from node n, leaving the answer in the node.
+ * Recursion has no bound, and so ends the report.
+ */
+static long
+worst(int n)
+{
+	NODE	*np = &nodes[n];
+	int	e = 0, t = 0, c;
+
+	if (np->m_state == 2)
+		return np->m_worst;
+	if (np->m_state == 1) {
+		fprintf(stderr, "ERR: %s is recursive, its stack has no bound\n",
+			np->m_name);
+		exit(EXIT_FAILURE);
+	}
+
+	np->m_state = 1;
+	np->m_worst = 0;
+	np->m_next  = -1;
+	while((c = callee(n, &e, &t)) >= 0) {
+		long	w = worst(c);
+
+		if ((np->m_next < 0)||(w > np->m_worst)) {
+			np->m_worst = w;
+			np->m_next  = c;
+		}
+	}
+
+	np->m_worst += np->m_bytes;
+	np->m_state = 2;
+	return np->m_worst;
+}
+
+static void
+usage(void)
+{
+	fprintf(stderr, "Usage: stackuse [-i \"caller=fn ...\"]... function file.ci ...\n");
+}
+
+int main(int argc, char **argv) {
+	int	opt, root, i, e, t, c, k, nunknown, dynamic;
+
+	while((opt = getopt(argc, argv, "i:")) != -1) {
+		switch(opt) {
+		case 'i': {
+			char	*eq = strchr(optarg, '=');
+
+			if ((!eq)||(nindirect >= MAXINDIRECT)) {
+				usage();
+				exit(EXIT_FAILURE);
+			}
+			*eq = '\0';
+			indirect[nindirect].m_caller  = optarg;
+			indirect[nindirect].m_targets = eq+1;
+			nindirect++;
+			} break;
+		default:
+			usage();
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (argc - optind < 2) {
+		usage();
+		exit(EXIT_FAILURE);
+	}
+
+	for(i=optind+1; i<argc; i++)
+		readci(argv[i]);
+
+	for(root=0; root<nnodes; root++)
+		if ((nodes[root].m_known)
+				&&(strcmp(nodes[root].m_name, argv[optind])==0))
+			break;
+	if (root >= nnodes) {
+		fprintf(stderr, "ERR: No stack information for %s\n",
+			argv[optind]);
+		exit(EXIT_FAILURE);
+	}
+
+	// The deepest path
+	printf("%s: %ld bytes of stack, at most\n", argv[optind], worst(root));
+	dynamic = 0;
+	for(i=root; i>=0; i=nodes[i].m_next) {
+		printf("\t%6ld  %-20s %s%s\n", nodes[i].m_bytes, nodes[i].m_name,
+			nodes[i].m_where,
+			(nodes[i].m_dynamic) ? " (dynamic)" : "");
+		dynamic |= nodes[i].m_dynamic;
+	}
+	if (dynamic)
+		printf("Functions marked dynamic use more stack than this, "
+			"depending upon their arguments\n");
+
+	// How deep each indirect target goes, on its own
+	for(k=0; k<nindirect; k++) {
+		printf("Through %s:\n", indirect[k].m_caller);
+		for(i=0; i<nnodes; i++)
+			if ((nodes[i].m_known)&&(istarget(k, nodes[i].m_name))
+					&&(nodes[i].m_state == 2))
+				printf("\t%6ld  %s\n", nodes[i].m_worst,
+					nodes[i].m_name);
+	}
+
+	// Everything we reached, but couldn't count
+	nunknown = 0;
+	for(i=0; i<nnodes; i++) {
+		if ((nodes[i].m_state != 2)||(!nodes[i].m_known))
+			continue;
+		for(e=0, t=0; (c = callee(i, &e, &t)) >= 0; ) {
+			if (nodes[c].m_known)
+				continue;
+			if (nunknown++ == 0)
+				printf("Not counted:\n");
+			printf("\t%s, from %s\n",
+				(strcmp(nodes[c].m_title, "__indirect_call")==0)
+				? "(a call through a pointer)" : nodes[c].m_name,
+				nodes[i].m_name);
+		}
+	}
+
+	return 0;
+}
@@ -51,10 +51,12 @@
 ////////////////////////////////////////////////////////////////////////////////
 //
 //
-#include <stdio.h>
+#include <stddef.h>
 #include "strategy.h"
+#include "trace.h"
 
 const static RULE ruleset[];
+static inline bool isheavy(int rule);
 
 /*
  * set_difficulty
@@ -70,6 +72,12 @@ void set_difficulty(LPSTRATEGY s, int difficulty) {
 
 	idx = 0;
 	s->m_difficulty_level = difficulty;
+	s->m_watch = NULL;
+	s->m_watcharg = NULL;
+	s->m_stop = NULL;
+	s->m_stoparg = NULL;
+	s->m_weights = NULL;
+	s->m_pool = NULL;
 
 	// For each potential rule
 	for(rp = ruleset; rp->m_fn; rp++) {
@@ -83,30 +91,311 @@ void set_difficulty(LPSTRATEGY s, int difficulty) {
 	// Count the number of rules we actually chose to use for this
 	// difficulty level.
 	s->m_num_rules = idx;
+	s->m_choose = NULL;
 }
 
 /*
- * makemove
+ * set_rules
+ *
+ * Set up the strategy with exactly the rules given, in order, rather than by
+ * difficulty.  The difficulty level is left at -1, as no level matches.
+ */
+void set_rules(LPSTRATEGY s, const RULE *const *rules, int nrules) {
+	int	idx;
+
+	set_difficulty(s, -1);
+	if (nrules > MAX_RULES)
+		nrules = MAX_RULES;
+	for(idx=0; idx<nrules; idx++)
+		s->m_rules[idx] = rules[idx];
+	s->m_num_rules = nrules;
+}
+
+/*
+ * get_rule
+ *
+ * Look up a rule from our ruleset by number.
+ */
+const RULE *get_rule(int idx) {
+	const RULE	*rp;
+
+	if (idx < 0)
+		return NULL;
+	for(rp = ruleset; (rp->m_fn)&&(idx > 0); rp++, idx--)
+		;
+	return (rp->m_fn) ? rp : NULL;
+}
+
+/*
+ * set_weights
+ *
+ * Set the line weights used by the GAIN rule.  The strategy only keeps the
+ * pointer, so the weights need to last as long as it does.
+ */
+void set_weights(LPSTRATEGY s, const int *weights) {
+	s->m_weights = weights;
+}
+
+/*
+ * set_seed
+ *
+ * Set the state of the random number generator this strategy uses to pick
+ * from among equally valued moves.  Every strategy carries its own, so that
+ * separate games never share (or race on) any random number state.
+ */
+void set_seed(LPSTRATEGY s, unsigned seed) {
+	s->m_seed = seed;
+}
+
+/*
+ * set_watch
+ *
+ * Attach a watcher to the strategy, or detach it with a NULL fn.
+ */
+void set_watch(LPSTRATEGY s, RULEWATCH fn, void *arg) {
+	s->m_watch = fn;
+	s->m_watcharg = arg;
+}
+
+/*
+ * set_stop
+ *
+ * Attach a stop function to the strategy, or detach it with a NULL fn.
+ */
+void set_stop(LPSTRATEGY s, RULESTOP fn, void *arg) {
+	s->m_stop = fn;
+	s->m_stoparg = arg;
+}
+
+/*
+ * stopping
+ *
+ * Returns true if the strategy has been told to stop.
+ */
+static bool
+stopping(LPSTRATEGY s)
+{
+	return (s->m_stop)&&(s->m_stop(s->m_stoparg));
+}
+
+/*
+ * SYMMETRY
+ *
+ * Early in the game, many squares are as good as each other, by symmetry:
+ * on an empty board, every corner is the same as every other.  Those
+ * symmetries of the board (see cs_symmetry) that leave the position as it
+ * was (its stabilizer) split the squares into orbits, within which every
+ * rule must score every square the same.  m_rep gives the lowest numbered
+ * square of each square's orbit, which is the one we actually ask the rules
+ * about.  m_any is false if only the identity leaves the position alone, and
+ * so every square is in an orbit of its own.  Since only the longer rules
+ * gain from this, the orbits aren't found (m_found) until one of those needs
+ * them.
+ *
+ * Past the first few moves, hardly any position is left alone by anything
+ * but the identity, so we stop looking after SYM_MAXFILL pieces.
+ */
+#define	SYM_MAXFILL	(2*NUM_ON_SIDE)
+
+typedef	struct	SYMMETRY_S {
+	bool		m_found, m_any;
+	unsigned char	m_rep[NUM_SQUARES];
+	// The representatives of the last set of candidates asked about, and
+	// how many candidates that set held.  The candidates only ever shrink,
+	// so while their number stays the same, so do they.
+	int		m_ncands, m_nreps;
+	SQSET		m_reps;
+} SYMMETRY, *LPSYMMETRY;
+
+// As with the rules' scratch (see RULESCRATCH), the small build keeps its
+// one SYMMETRY off of the stack.
+#ifdef	TTTT_SMALL
+static	SYMMETRY	symscratch;
+#define	SYMSCRATCH(NAME)	LPSYMMETRY NAME = &symscratch
+#else
+#define	SYMSCRATCH(NAME)	SYMMETRY NAME##_local, *NAME = &NAME##_local
+#endif
+
+/*
+ * findorbits
+ *
+ * Find the stabilizer of the position on brd, and from it the orbits of
+ * every square.  Each orbit is the set of squares any of the symmetries takes
+ * its representative to, so the lowest of those is the representative.
+ */
+static void
+findorbits(LPGBOARD brd, LPSYMMETRY sym)
+{
+	const unsigned char	*map;
+	unsigned char		filled[NUM_SQUARES];
+	int			nfilled = 0, g, i;
+
+	// A symmetry leaves the position alone if it takes every piece to
+	// another of the same color.  Only the pieces need checking.
+	for(i=0; i<NUM_SQUARES; i++)
+		if (brd->m_spots[i] != GB_NOONE)
+			filled[nfilled++] = i;
+
+	sym->m_found = true;
+	sym->m_ncands = 0;
+	// Every symmetry leaves an empty board alone, and those orbits were
+	// found when we were built
+	if (nfilled == 0) {
+		for(i=0; i<NUM_SQUARES; i++)
+			sym->m_rep[i] = cs_orbit[i];
+		sym->m_any = true;
+		return;
+	}
+
+	sym->m_any = false;
+	for(g=1; g<CS_NSYMS; g++) {
+		map = cs_symmetry[g];
+		for(i=0; i<nfilled; i++)
+			if (brd->m_spots[map[filled[i]]]
+					!= brd->m_spots[filled[i]])
+				break;
+		if (i < nfilled)
+			continue;
+
+		if (!sym->m_any) {
+			for(i=0; i<NUM_SQUARES; i++)
+				sym->m_rep[i] = i;
+			sym->m_any = true;
+		}
+		for(i=0; i<NUM_SQUARES; i++)
+			if (map[i] < sym->m_rep[i])
+				sym->m_rep[i] = map[i];
+	}
+}
+
+/*
+ * symreps
+ *
+ * The representatives of the orbits among cands, and their number.  Since
+ * every rule before this one scored the squares of each orbit alike, cands
+ * holds either all of an orbit or none of it.
+ */
+static int
+symreps(LPSYMMETRY sym, LPSQSET cands, LPSQSET reps)
+{
+	unsigned	bits;
+	int		w, i, n = 0;
+
+	ss_clear(reps);
+	for(w=0; w<SS_WORDS; w++)
+		for(i=w*32, bits = cands->m_bits[w]; bits; i++, bits >>= 1)
+			if ((bits & 1)&&(sym->m_rep[i] == i)) {
+				reps->m_bits[w] |= 1u << (i & 31);
+				n++;
+			}
+	return n;
+}
+
+/*
+ * symspread
+ *
+ * Once a rule has scored the representatives, give every other candidate
+ * the score of its representative.
+ */
+static void
+symspread(LPSYMMETRY sym, LPSQSET cands, LPVSET spots)
+{
+	unsigned	bits;
+	int		w, i, r;
+
+	// Nothing to spread if the rule found nothing
+	if (spots->m_active <= 0)
+		return;
+
+	for(w=0; w<SS_WORDS; w++)
+		for(i=w*32, bits = cands->m_bits[w]; bits; i++, bits >>= 1) {
+			if ((!(bits & 1))||((r = sym->m_rep[i]) == i))
+				continue;
+			if (spots->m_data[i] == spots->m_data[r])
+				continue;
+			if (spots->m_data[i] == 0)
+				spots->m_active++;
+			else if (spots->m_data[r] == 0)
+				spots->m_active--;
+			spots->m_data[i] = spots->m_data[r];
+		}
+}
+
+/*
+ * askabout
+ *
+ * Which squares to ask a refining rule about: the ncands best moves so far,
+ * if few enough that looking at only the lines through them beats looking at
+ * every line, or else NULL for every square.  A longer rule (see isheavy()),
+ * given too many early in the game, is asked about one square from each
+ * orbit instead, should the position's symmetries make those few enough.
+ * If m_reps is returned, the rule's scores must then be spread to the rest
+ * of each orbit by symspread().
+ */
+static LPSQSET
+askabout(LPGBOARD brd, LPCOMBOSET cs, LPSYMMETRY sym, bool heavy,
+		LPSQSET cands, int ncands)
+{
+	if (ncands * CS_MAXINCIDENT < cs->m_ninplay)
+		return cands;
+	if ((!heavy)||(brd->m_nfilled > SYM_MAXFILL))
+		return NULL;
+	if (!sym->m_found)
+		findorbits(brd, sym);
+	if (!sym->m_any)
+		return NULL;
+	if (sym->m_ncands != ncands) {
+		sym->m_nreps = symreps(sym, cands, &sym->m_reps);
+		sym->m_ncands = ncands;
+	}
+	return (sym->m_nreps * CS_MAXINCIDENT < cs->m_ninplay)
+		? &sym->m_reps : NULL;
+}
+
+/*
+ * applyrules
  *
  * If you are trying to look for where/how the magic happens in the computers
- * strategy, you really want to start here.  This is the routine the computer
- * uses to make his move(s).  This routine calls the rules in order, applying
- * each of them, to determine a set of "good" places to move.  We then pick
- * from among that list randomly.
+ * strategy, you really want to start here.  This routine calls the rules in
+ * order, applying each of them, to determine a set of "good" places to move.
+ * That set is left in spots.
+ *
+ * If the strategy has a watcher, it is told of the results of every rule as
+ * it is applied.
+ *
+ * If the strategy has a stop function, it is checked before every rule save
+ * the first.  Since every rule only ever refines the set given by the rules
+ * before it, stopping early still leaves us with a set of legal moves--just
+ * not as well chosen a set.  A rule that was itself stopped part way is
+ * ignored.
+ *
+ * Only the best scoring of our moves can survive vs_combine(), so those are
+ * all the refining rules are asked about.  Once there's only one of them,
+ * no later rule can change our mind, and (unless watched) we stop.  Of those,
+ * where the position is symmetric, only one from each orbit is asked about.
  */
-int
-makemove(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE whosemove)
+static bool
+applyrules(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE whosemove,
+		LPVSET spots)
 {
-	VSET	spots;
 	int	rule_number;
 
-	vs_clear(&spots);
+	vs_clear(spots);
 
 	// Find one rule that gives us some result we can work with.  This
 	// should be the first rule that returns any valid/legal move.
 	for(rule_number=0; rule_number < s->m_num_rules; rule_number++) {
-		(s->m_rules[rule_number]->m_fn)(brd, cs, whosemove, &spots);
-		if (spots.m_active)
+		if ((rule_number > 0)&&(stopping(s))) {
+			vs_clear(spots);
+			return false;
+		}
+		TRACE_RULE(s->m_rules[rule_number] - ruleset, 0);
+		(s->m_rules[rule_number]->m_fn)(s, brd, cs, whosemove, spots,
+				NULL);
+		if (s->m_watch)
+			s->m_watch(s->m_watcharg, s->m_rules[rule_number],
+				spots, spots);
+		if (spots->m_active)
 			break;
 	}
 
@@ -118,59 +407,176 @@ makemove(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE whosemove)
 	if (rule_number < s->m_num_rules) {
 		// Keep track of this refining value in a separate VSET
 		VSET	others;
-
-		do {
-			// Apply a subsequent rule
-			(s->m_rules[rule_number]->m_fn)(brd, cs,
-						whosemove, &others);
-
-			// Attempt to combine its results with our own.
-			vs_combine(&spots, &others);
+		SQSET	cands, *ask;
+		SYMSCRATCH(sym);
+		bool	refined = false;
+		int	ncands;
 
 		// We are done when we have exhausted all of our rules, or 
 		// equivalently when there's only one possible move to chose
-		// from and therefore nothing left to refine.
-		} while((++rule_number < s->m_num_rules)&&(spots.m_active > 1));
+		// from and therefore nothing left to refine.  A watcher,
+		// though, gets to see the first refining rule, and every one
+		// after it for as long as there's more than one move in the
+		// set at all.
+		ncands = vs_best(spots, &cands);
+		TRACE_AFTER(ncands);
+		sym->m_found = false;
+		for(; rule_number < s->m_num_rules; rule_number++) {
+			if ((ncands <= 1)&&((!s->m_watch)
+					||((refined)&&(spots->m_active <= 1))))
+				break;
+			refined = true;
+
+			if (stopping(s))
+				return false;
+
+			// Apply a subsequent rule, asking only about the
+			// candidates if there are few enough of them.  A
+			// watcher sees every rule's full set of scores.
+			TRACE_RULE(s->m_rules[rule_number] - ruleset, ncands);
+			ask = (s->m_watch) ? NULL : askabout(brd, cs, sym,
+				isheavy(s->m_rules[rule_number] - ruleset),
+				&cands, ncands);
+			(s->m_rules[rule_number]->m_fn)(s, brd, cs,
+					whosemove, &others, ask);
+			if (stopping(s))
+				return false;
+			if (ask == &sym->m_reps)
+				symspread(sym, &cands, &others);
+
+			// Attempt to combine its results with our own.
+			ncands = vs_narrow(spots, &others, &cands, ncands);
+			TRACE_AFTER(ncands);
+			if (s->m_watch)
+				s->m_watch(s->m_watcharg,
+					s->m_rules[rule_number],
+					&others, spots);
+		}
 	}
 
+	return true;
+}
+
+/*
+ * choosemoves
+ *
+ * Unless we're being watched, use the strategy's chooser--if it has one, such
+ * as a rule pool's.  Otherwise, apply the rules one at a time.
+ */
+bool
+choosemoves(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE whosemove,
+		LPVSET spots)
+{
+	bool	done;
+
+	TRACE_START(whosemove, s->m_difficulty_level, brd->m_nfilled,
+		cs->m_ninplay);
+	if ((s->m_choose)&&(!s->m_watch))
+		done = (s->m_choose)(s, brd, cs, whosemove, spots);
+	else
+		done = applyrules(s, brd, cs, whosemove, spots);
+	TRACE_END(whosemove, done);
+	return done;
+}
+
+/*
+ * makemove
+ *
+ * This is the routine the computer uses to make his move(s).  It finds the
+ * set of "good" places to move, via choosemoves() above, and then picks from
+ * among that list randomly.
+ */
+int
+makemove(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE whosemove)
+{
+	VSET	spots;
+	int	move;
+
+	choosemoves(s, brd, cs, whosemove, &spots);
+
 	// Finally, now that we have our set of spots that we might wish to move
-	// from, pick one at random from the set.
-	return vs_pickmember(&spots);
+	// from, pick one at random from the set.  If there are no legal
+	// moves at all, this will return -1.
+	move = vs_pickmember(&spots, &s->m_seed);
+	TRACE_PICK(whosemove, move);
+	return move;
 }
 
 /*
- * sum
+ * atleast
  *
- * A simple helper function.  This just counts up the number of times a 
- * piece on the board is a part of a combo either owned by who or by no one,
- * that has nfilled spaces filled within it.
+ * Score every square (or every one of the cands, if given) lying on at least
+ * n lines owned by who, with nfilled filled, by the number of those lines.
  */
 static void
-sum(LPCOMBOSET cs, LPVSET spots, GB_PIECE who, int nfilled)
+atleast(LPCOMBOSET cs, LPVSET spots, GB_PIECE who, int nfilled, int n,
+		LPSQSET cands)
 {
-	int	i, j;
+	SQSET		on, *planes;
+	unsigned	bits;
+	int		w, b, p, count;
 
 	vs_clear(spots);
-
-	for(i=0; i< cs->m_ninplay; i++) {
-		if ((cs->m_data[i].m_nfilled == nfilled)
-				&&(cs->m_data[i].m_owner == who)) {
-			for(j=0; j< NUM_ON_SIDE-cs->m_data[i].m_nfilled; j++)
-				vs_incscore(spots, cs->m_data[i].m_spots[j]);
+	cs_atleast(cs, who, nfilled, n, &on);
+	if (cands)
+		ss_and(&on, cands);
+
+	// Put each square's count back together from the bit planes
+	planes = cs->m_planes[who][nfilled];
+	for(w=0; w<SS_WORDS; w++) {
+		for(b=0, bits = on.m_bits[w]; bits; b++, bits >>= 1) {
+			if (!(bits & 1))
+				continue;
+			for(p=0, count=0; p<CS_NPLANES; p++)
+				count |= ((planes[p].m_bits[w] >> b)&1) << p;
+			vs_addscore(spots, w*32+b, count);
 		}
 	}
 }
 
+/*
+ * sum
+ *
+ * A simple helper function.  This just counts up the number of times a 
+ * piece on the board is a part of a combo either owned by who or by no one,
+ * that has nfilled spaces filled within it.  The comboset keeps these counts,
+ * a bit plane at a time, so all that's left is to copy them into spots--only
+ * for the cands, if given.
+ *
+ * The rules below speak of ones, twos, and threes, as on the classic board.
+ * On any board, these are the lines one, two, and three short of a win: with
+ * NUM_ON_SIDE-3, NUM_ON_SIDE-2, and NUM_ON_SIDE-1 filled.
+ */
+static void
+sum(LPCOMBOSET cs, LPVSET spots, GB_PIECE who, int nfilled, LPSQSET cands)
+{
+	atleast(cs, spots, who, nfilled, 1, cands);
+}
+
 /*
  * RULE: any
  *
  * Returns any legal move.  All choices of moves past this must intersect this
  * set.
+ *
+ * A square with no line still in play through it can't help either player,
+ * so as long as there's a live square left (see m_live), only those are
+ * offered.  Once there are none, the game will be a tie, and any legal move
+ * will do.
  */
 static void
-any(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
+any(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who,
+		LPVSET spots, LPSQSET cands)
 {
-	int	i;
+	unsigned	bits;
+	int		w, i;
+
+	for(w=0; w<SS_WORDS; w++)
+		for(i=w*32, bits = cs->m_live.m_bits[w]; bits; i++, bits >>= 1)
+			if ((bits & 1)&&(legal(brd, who, i)))
+				vs_incscore(spots, i);
+	if (spots->m_active)
+		return;
 
 	for(i=0; i<NUM_SQUARES; i++)
 		if (legal(brd, who, i))
@@ -183,9 +589,10 @@ any(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
  * If you can win on this move, do so
  */
 static void
-win(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
+win(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who,
+		LPVSET spots, LPSQSET cands)
 {
-	sum(cs, spots, who, 3);
+	sum(cs, spots, who, NUM_ON_SIDE-1, cands);
 }
 
 /*
@@ -197,9 +604,10 @@ win(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
  * if the set of winning moves is the empty set.
  */
 static void
-block(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
+block(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who,
+		LPVSET spots, LPSQSET cands)
 {
-	sum(cs, spots, opponent(who), 3);
+	sum(cs, spots, opponent(who), NUM_ON_SIDE-1, cands);
 }
 
 /*
@@ -209,9 +617,10 @@ block(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
  * row, make a three in a row out of it.
  */
 static void
-makethree(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
+makethree(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who,
+		LPVSET spots, LPSQSET cands)
 {
-	sum(cs, spots, who, 2);
+	sum(cs, spots, who, NUM_ON_SIDE-2, cands);
 }
 
 /*
@@ -221,9 +630,10 @@ makethree(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
  * it lest he get three in a row.
  */
 static void
-blocktwo(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
+blocktwo(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who,
+		LPVSET spots, LPSQSET cands)
 {
-	sum(cs, spots, opponent(who), 2);
+	sum(cs, spots, opponent(who), NUM_ON_SIDE-2, cands);
 }
 
 /*
@@ -234,9 +644,10 @@ blocktwo(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
  * we already have in a row.
  */
 static void
-maketwo(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
+maketwo(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who,
+		LPVSET spots, LPSQSET cands)
 {
-	sum(cs, spots, who, 1);
+	sum(cs, spots, who, NUM_ON_SIDE-3, cands);
 }
 
 /*
@@ -248,9 +659,10 @@ maketwo(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
  * decent, but not too smart.
  */
 static void
-blockone(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
+blockone(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who,
+		LPVSET spots, LPSQSET cands)
 {
-	sum(cs, spots, opponent(who), 1);
+	sum(cs, spots, opponent(who), NUM_ON_SIDE-3, cands);
 }
 
 /*
@@ -263,16 +675,10 @@ blockone(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
  * case, we take the empty space.
  */
 static void
-force(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
+force(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who,
+		LPVSET spots, LPSQSET cands)
 {
-	int	i;
-
-	sum(cs, spots, who, 2);
-
-	for(i=0; i<NUM_SQUARES; i++) {
-		if (spots->m_data[i] < 2)
-			vs_disable(spots, i);
-	}
+	atleast(cs, spots, who, NUM_ON_SIDE-2, 2, cands);
 }
 
 /*
@@ -282,9 +688,10 @@ force(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
  * him on this one.  Block him now.
  */
 static void
-blockforce(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
+blockforce(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who,
+		LPVSET spots, LPSQSET cands)
 {
-	force(brd, cs, opponent(who), spots);
+	force(s, brd, cs, opponent(who), spots, cands);
 }
 
 /*
@@ -296,33 +703,64 @@ blockforce(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
  * force on the next move.
  */
 static void
-setupforce(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
+setupforce(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who,
+		LPVSET spots, LPSQSET cands)
 {
-	VSET	onesum, twosum;
-	int	i, j, k;
+	SQSET	ones, twos;
+	int	i, j, k, nopen;
 
 	vs_clear(spots);
-	sum(cs, &onesum, who, 1);
-	sum(cs, &twosum, who, 2);
+	cs_atleast(cs, who, NUM_ON_SIDE-3, 1, &ones);
+	cs_atleast(cs, who, NUM_ON_SIDE-2, 1, &twos);
+	ss_and(&ones, &twos);
+
+	// With only a few squares to score, look only at the lines through
+	// them.  Each square ahead of a candidate, in a row one short of a win,
+	// that's also in both a one and a two of ours, counts for it.
+	if (cands) {
+		for(i=0; i<NUM_SQUARES; i++) {
+			if (!ss_ismember(cands, i))
+				continue;
+			for(j=0; j<cs_nincident[i]; j++) {
+				int	id = cs_incident[i][j];
+				GB_BYTE	*sp = cs->m_spots[id];
+
+				if ((!cs_inplay(cs, id))
+						||(cs->m_nfilled[id] != NUM_ON_SIDE-1)
+						||(cs->m_owner[id] != who))
+					continue;
+				nopen = NUM_ON_SIDE - cs->m_nfilled[id];
+				for(k=0; (k < nopen)&&(sp[k] != i); k++)
+					;
+				for(k++; k<nopen; k++)
+					if (ss_ismember(&ones, sp[k]))
+						vs_incscore(spots, i);
+			}
+		}
+		return;
+	}
 
 	for(i=0; i<NUM_SQUARES; i++) {
-		if ((!vs_isable(&onesum, i))||(!vs_isable(&twosum, i)))
+		if (!ss_ismember(&ones, i))
 			continue;
 
 		for(j=0; j < cs->m_ninplay; j++) {
-			LPCOMBOROW cr = &cs->m_data[j];
-			if (cr->m_nfilled != 3)
+			int	id = cs->m_inplay[j];
+			GB_BYTE	*sp = cs->m_spots[id];
+
+			if (cs->m_nfilled[id] != NUM_ON_SIDE-1)
 				continue;
-			if (cr->m_owner != who)
+			if (cs->m_owner[id] != who)
 				continue;
-			for(k=0; k < 4-cr->m_nfilled; k++) {
-				if (cr->m_spots[k] == i)
+			nopen = NUM_ON_SIDE - cs->m_nfilled[id];
+			for(k=0; k < nopen; k++) {
+				if (sp[k] == i)
 					break;
-			} if (k != 4-cr->m_nfilled) {
-				for(k=0; k<4-cr->m_nfilled; k++) {
-					if (cr->m_spots[k] == i)
+			} if (k != nopen) {
+				for(k=0; k<nopen; k++) {
+					if (sp[k] == i)
 						break;
-					vs_incscore(spots, cr->m_spots[k]);
+					vs_incscore(spots, sp[k]);
 				}
 			}
 		}
@@ -336,23 +774,64 @@ setupforce(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
  * first.
  */
 static void
-nixsetup(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
+nixsetup(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who,
+		LPVSET spots, LPSQSET cands)
 {
-	VSET	onesum, twosum;
+	SQSET	ones, twos;
 	int	i;
 
 	vs_clear(spots);
-	sum(cs, &onesum, who, 1);
-	sum(cs, &twosum, who, 2);
+	cs_atleast(cs, who, NUM_ON_SIDE-3, 1, &ones);
+	cs_atleast(cs, who, NUM_ON_SIDE-2, 1, &twos);
+	ss_and(&ones, &twos);
+	if (cands)
+		ss_and(&ones, cands);
 
 	for(i=0; i<NUM_SQUARES; i++) {
-		if ((!vs_isable(&onesum, i))||(!vs_isable(&twosum, i)))
-			continue;
-
-		vs_incscore(spots, i);
+		if (ss_ismember(&ones, i))
+			vs_incscore(spots, i);
 	}
 }
 
+/*
+ * RULESCRATCH
+ *
+ * The working space of killn() and live(), our two longest rules: the sums
+ * of where we have ones and twos, and the list of rows that matched.  Since
+ * no two rules ever run at once, the small build gives them all one copy to
+ * share, rather than a copy on the stack of each.  This makes that build's
+ * engine good for one thread only--as is the ZipCPU.  Everywhere else, the
+ * scratch goes on the stack, so that many games may be played at once.
+ */
+typedef	struct	RULESCRATCH_S {
+	VSET		m_onesum, m_twosum;
+	unsigned char	m_fo[NUM_COMBOROWS], m_ft[NUM_COMBOROWS];
+	CR_ID		m_match[NUM_COMBOROWS];
+} RULESCRATCH;
+
+#ifdef	TTTT_SMALL
+static	RULESCRATCH	scratch;
+#define	SCRATCH(NAME)	RULESCRATCH *NAME = &scratch
+#else
+#define	SCRATCH(NAME)	RULESCRATCH NAME##_local, *NAME = &NAME##_local
+#endif
+
+/*
+ * isable
+ *
+ * cr_isable(), for the line id of our comboset.
+ */
+static bool
+isable(LPCOMBOSET cs, int id, int where)
+{
+	int	i;
+
+	for(i=0; i<cs->m_nfilled[id]; i++)
+		if (cs->m_spots[id][i] == where)
+			return true;
+	return false;
+}
+
 /*
  * killn
  *
@@ -363,27 +842,39 @@ nixsetup(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
  * generate two pieces per row in each cross row before walking down this row
  * turning each of those cross rows into a 3-in a row that the opponent must
  * block.
+ *
+ * The cross row has twos+ones open squares, and so NUM_ON_SIDE-twos-ones
+ * filled.  A trick needing more open squares than a line has can't be played
+ * on this board at all, so we don't look for one.
+ *
+ * This is one of our longer scans, so every so often we check whether we've
+ * been told to stop.  If so, spots is left empty.
  */
 static void
-killn(LPCOMBOSET cs, GB_PIECE who, LPVSET spots, int twos, int ones)
+killn(LPSTRATEGY s, LPCOMBOSET cs, GB_PIECE who, LPVSET spots, LPSQSET cands,
+		int twos, int ones)
 {
-	VSET		onesum, twosum;
+	SCRATCH(sc);
+	LPVSET		onesum = &sc->m_onesum, twosum = &sc->m_twosum;
+	unsigned char	*fo = sc->m_fo, *ft = sc->m_ft;
+	CR_ID		*match = sc->m_match;
 	GB_PIECE	opp = opponent(who);
-	int	i, j, k, nv, found_ones, found_twos, found_zeros;
-	LPCOMBOROW	cr;
-	int	fo[80], ft[80], match[80];
+	int	i, j, k, nv, found_ones, found_twos, found_zeros, id, nfilled;
+	GB_BYTE		*sp;
 
 	vs_clear(spots);
-	sum(cs, &onesum, who, 1);
-	sum(cs, &twosum, who, 2);
+	if (twos + ones > NUM_ON_SIDE)
+		return;
+	sum(cs, onesum, who, NUM_ON_SIDE-3, NULL);
+	sum(cs, twosum, who, NUM_ON_SIDE-2, NULL);
 
-	if (onesum.m_active < ones*3)
+	if (onesum->m_active < ones*3)
 		return;
-	if (twosum.m_active < twos*2)
+	if (twosum->m_active < twos*2)
 		return;
 
 	nv = 0;
-	for(i=0; i<80; i++)
+	for(i=0; i<NUM_COMBOROWS; i++)
 		fo[i] = ft[i] = 0;
 
 	// First step ... find a cross-bar--an uncompleted combo that we might
@@ -392,10 +883,16 @@ killn(LPCOMBOSET cs, GB_PIECE who, LPVSET spots, int twos, int ones)
 	// and "ones" of the unused locations connect to combos having one
 	// of our pieces within them.
 	for(i=0; i < cs->m_ninplay; i++) {
-		LPCOMBOROW	cr = &cs->m_data[i];
-		if (cr->m_owner == opp)
+		id = cs->m_inplay[i];
+		nfilled = cs->m_nfilled[id];
+		sp = cs->m_spots[id];
+		if (((i & 15)==0)&&(stopping(s))) {
+			vs_clear(spots);
+			return;
+		}
+		if (cs->m_owner[id] == opp)
 			continue;
-		if (cr->m_nfilled != NUM_ON_SIDE - ones - twos)
+		if (nfilled != NUM_ON_SIDE - ones - twos)
 			continue;
 
 		found_twos  = 0;
@@ -403,13 +900,13 @@ killn(LPCOMBOSET cs, GB_PIECE who, LPVSET spots, int twos, int ones)
 		found_zeros = 0;
 		// Now, cycle through the unused locations within this
 		// row of four
-		for(j=0; j < NUM_ON_SIDE - cr->m_nfilled; j++) {
+		for(j=0; j < NUM_ON_SIDE - nfilled; j++) {
 			// First check: is this unused location connected to
 			// another combo already having two filled?
-			if (cr->m_nfilled == 2) {
+			if (nfilled == NUM_ON_SIDE-2) {
 				// Let's be careful not to count this particular
 				// combo more than once
-				if ((twosum.m_data[cr->m_spots[j]])>1) {
+				if ((twosum->m_data[sp[j]])>1) {
 					found_twos++;
 
 					// We continue, so as not to count this
@@ -418,18 +915,18 @@ killn(LPCOMBOSET cs, GB_PIECE who, LPVSET spots, int twos, int ones)
 					// or the number of ones, but not both.
 					continue;
 				}
-			} else if ((twosum.m_data[cr->m_spots[j]])>0) {
+			} else if ((twosum->m_data[sp[j]])>0) {
 					found_twos++;
 					continue;
 			}
 
-			if (cr->m_nfilled == 3) {
+			if (nfilled == NUM_ON_SIDE-1) {
 				// Only count this one if it's not this comborow
-				if ((onesum.m_data[cr->m_spots[j]])>1) {
+				if ((onesum->m_data[sp[j]])>1) {
 					found_ones++;
 					continue;
 				}
-			} else if ((onesum.m_data[cr->m_spots[j]])>0) {
+			} else if ((onesum->m_data[sp[j]])>0) {
 				found_ones++;
 				continue;
 			}
@@ -447,41 +944,49 @@ killn(LPCOMBOSET cs, GB_PIECE who, LPVSET spots, int twos, int ones)
 		if ((found_ones == ones)&&(found_twos >= twos)) {
 			fo[nv] = found_ones;
 			ft[nv] = found_twos;
-			match[nv++] = i;
+			match[nv++] = id;
 		}
 	}
 
 	for(int i=0; i< nv; i++) {
 		// i is the index of the base we are working with
-		LPCOMBOROW	cross = &cs->m_data[match[i]];
+		int	cross = match[i];
+		if (stopping(s)) {
+			vs_clear(spots);
+			return;
+		}
 		for(int j=0; j< cs->m_ninplay; j++) {
-			if (j == i)
+			if (cs->m_inplay[j] == cross)
 				continue;
-			cr = &cs->m_data[j];
+			id = cs->m_inplay[j];
+			nfilled = cs->m_nfilled[id];
+			sp = cs->m_spots[id];
 
-			if (cr->m_owner == opp)
+			if (cs->m_owner[id] == opp)
 				continue;
 
 			if (fo[i] != 0) {
 				// Filling in the ones is our first priority
-				if (cr->m_nfilled != 3)
+				if (nfilled != NUM_ON_SIDE-1)
 					continue;
 			} else if (ft[i] != 0) {
 				// If there are no ones and only twos left,
 				// then its time to force the win
-				if (cr->m_nfilled != 2)
+				if (nfilled != NUM_ON_SIDE-2)
 					continue;
 			}
 
-			if (!cr_isects(cr, cross))
+			if (!cs_isects(cs, id, cross))
 				continue;
-			for(k=0; k<NUM_ON_SIDE-cr->m_nfilled; k++) {
+			for(k=0; k<NUM_ON_SIDE-nfilled; k++) {
 				// All spots, but the ones on the cross piece,
 				// are ones we'll want to advance.  Those on the
 				// cross we save for the very end.
-				if (cr_isable(cross, cr->m_spots[k]))
+				if (isable(cs, cross, sp[k]))
+					continue;
+				if ((cands)&&(!ss_ismember(cands, sp[k])))
 					continue;
-				vs_incscore(spots, cr->m_spots[k]);
+				vs_incscore(spots, sp[k]);
 			}
 		}
 	}
@@ -493,24 +998,28 @@ killn(LPCOMBOSET cs, GB_PIECE who, LPVSET spots, int twos, int ones)
  * This is very similar to killn() above, but in this case we wish to keep our
  * opponent from killing us.  Hence, we find any row that might be used for that
  * purpose and rather than building up the cross rows, we try to cleanup that
- * pivot row.
+ * pivot row.  As with killn(), a trick longer than a line is never looked for.
  */
 static void
-live(LPCOMBOSET cs, GB_PIECE who, LPVSET spots, int twos, int ones)
+live(LPSTRATEGY s, LPCOMBOSET cs, GB_PIECE who, LPVSET spots, LPSQSET cands,
+		int twos, int ones)
 {
-	VSET		onesum, twosum;
+	SCRATCH(sc);
+	LPVSET		onesum = &sc->m_onesum, twosum = &sc->m_twosum;
+	CR_ID		*match = sc->m_match;
 	GB_PIECE	opp = opponent(who);
-	int	i, j, nv, found_ones, found_twos, found_zeros;
-	LPCOMBOROW	cr;
-	int	match[80];
+	int	i, j, nv, found_ones, found_twos, found_zeros, id, nfilled;
+	GB_BYTE		*sp;
 
 	vs_clear(spots);
-	sum(cs, &onesum, opp, 1);
-	sum(cs, &twosum, opp, 2);
+	if (twos + ones > NUM_ON_SIDE)
+		return;
+	sum(cs, onesum, opp, NUM_ON_SIDE-3, NULL);
+	sum(cs, twosum, opp, NUM_ON_SIDE-2, NULL);
 
-	if (onesum.m_active < ones*3)
+	if (onesum->m_active < ones*3)
 		return;
-	if (twosum.m_active < twos*2)
+	if (twosum->m_active < twos*2)
 		return;
 
 	nv = 0;
@@ -521,24 +1030,38 @@ live(LPCOMBOSET cs, GB_PIECE who, LPVSET spots, int twos, int ones)
 	// and "ones" of the unused locations connect to combos having one
 	// of our pieces within them.
 	for(i=0; i < cs->m_ninplay; i++) {
-		LPCOMBOROW	cr = &cs->m_data[i];
-		if (cr->m_owner == who)
+		id = cs->m_inplay[i];
+		nfilled = cs->m_nfilled[id];
+		sp = cs->m_spots[id];
+		if (((i & 15)==0)&&(stopping(s))) {
+			vs_clear(spots);
+			return;
+		}
+		if (cs->m_owner[id] == who)
 			continue;
-		if (cr->m_nfilled != NUM_ON_SIDE - ones - twos)
+		if (nfilled != NUM_ON_SIDE - ones - twos)
 			continue;
+		// A row with no candidates in it can't add to their scores
+		if (cands) {
+			for(j=0; j < NUM_ON_SIDE - nfilled; j++)
+				if (ss_ismember(cands, sp[j]))
+					break;
+			if (j >= NUM_ON_SIDE - nfilled)
+				continue;
+		}
 
 		found_twos  = 0;
 		found_ones  = 0;
 		found_zeros = 0;
 		// Now, cycle through the unused locations within this
 		// row of four
-		for(j=0; j < NUM_ON_SIDE - cr->m_nfilled; j++) {
+		for(j=0; j < NUM_ON_SIDE - nfilled; j++) {
 			// First check: is this unused location connected to
 			// another combo already having two filled?
-			if (cr->m_nfilled == 2) {
+			if (nfilled == NUM_ON_SIDE-2) {
 				// Let's be careful not to count this particular
 				// combo more than once
-				if ((twosum.m_data[cr->m_spots[j]])>1) {
+				if ((twosum->m_data[sp[j]])>1) {
 					found_twos++;
 
 					// We continue, so as not to count this
@@ -547,18 +1070,18 @@ live(LPCOMBOSET cs, GB_PIECE who, LPVSET spots, int twos, int ones)
 					// or the number of ones, but not both.
 					continue;
 				}
-			} else if ((twosum.m_data[cr->m_spots[j]])>0) {
+			} else if ((twosum->m_data[sp[j]])>0) {
 					found_twos++;
 					continue;
 			}
 
-			if (cr->m_nfilled == 3) {
+			if (nfilled == NUM_ON_SIDE-1) {
 				// Only count this one if it's not this comborow
-				if ((onesum.m_data[cr->m_spots[j]])>1) {
+				if ((onesum->m_data[sp[j]])>1) {
 					found_ones++;
 					continue;
 				}
-			} else if ((onesum.m_data[cr->m_spots[j]])>0) {
+			} else if ((onesum->m_data[sp[j]])>0) {
 				found_ones++;
 				continue;
 			}
@@ -571,7 +1094,7 @@ live(LPCOMBOSET cs, GB_PIECE who, LPVSET spots, int twos, int ones)
 		if (found_zeros > 0)
 			continue;
 		if ((found_ones == ones)&&(found_twos >= twos))
-			match[nv++] = i;
+			match[nv++] = id;
 	}
 
 	// Unlike the killn approach above, we aren't trying to set ourselves
@@ -580,9 +1103,11 @@ live(LPCOMBOSET cs, GB_PIECE who, LPVSET spots, int twos, int ones)
 	// the pivot points, rather than the quiet setups
 	// 
 	for(i=0; i< nv; i++) {
-		cr = &cs->m_data[match[i]];
-		for(j=0; j< 4-cr->m_nfilled; j++)
-			vs_incscore(spots, cr->m_spots[j]);
+		id = match[i];
+		sp = cs->m_spots[id];
+		for(j=0; j< NUM_ON_SIDE-cs->m_nfilled[id]; j++)
+			if ((!cands)||(ss_ismember(cands, sp[j])))
+				vs_incscore(spots, sp[j]);
 	}
 }
 
@@ -593,9 +1118,10 @@ live(LPCOMBOSET cs, GB_PIECE who, LPVSET spots, int twos, int ones)
  * pull the pin on it and force a win.
  */
 static void
-newforce(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
+newforce(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who,
+		LPVSET spots, LPSQSET cands)
 {
-	killn(cs, who, spots, 1, 0);
+	killn(s, cs, who, spots, cands, 1, 0);
 }
 
 /*
@@ -605,9 +1131,10 @@ newforce(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
  * lose.
  */
 static void
-newblockforce(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
+newblockforce(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who,
+		LPVSET spots, LPSQSET cands)
 {
-	live(cs, who, spots, 1, 0);
+	live(s, cs, who, spots, cands, 1, 0);
 }
 
 /*
@@ -617,9 +1144,10 @@ newblockforce(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
  * and try to set one up one move from now.
  */
 static void
-kill_setup_1(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
+kill_setup_1(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who,
+		LPVSET spots, LPSQSET cands)
 {
-	killn(cs, who, spots, 2, 1);
+	killn(s, cs, who, spots, cands, 2, 1);
 }
 
 /*
@@ -628,9 +1156,10 @@ kill_setup_1(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
  * Same as kill_setup_1, but our goal is to block.
  */
 static void
-kill_block_1(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
+kill_block_1(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who,
+		LPVSET spots, LPSQSET cands)
 {
-	live(cs, who, spots, 2, 1);
+	live(s, cs, who, spots, cands, 2, 1);
 }
 
 /*
@@ -640,9 +1169,10 @@ kill_block_1(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
  * force opponent to do X moves.
  */
 static void
-kill_setup_2(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
+kill_setup_2(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who,
+		LPVSET spots, LPSQSET cands)
 {
-	killn(cs, who, spots, 3, 2);
+	killn(s, cs, who, spots, cands, 3, 2);
 }
 
 /*
@@ -651,8 +1181,9 @@ kill_setup_2(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
  * Same as kill_block_1, but block a longer trick.
  */
 static void
-kill_block_2(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots) {
-	live(cs, who, spots, 3, 2);
+kill_block_2(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who,
+		LPVSET spots, LPSQSET cands) {
+	live(s, cs, who, spots, cands, 3, 2);
 }
 
 /*
@@ -662,8 +1193,9 @@ kill_block_2(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots) {
  * of force opponent to do X moves.
  */
 static void
-kill_setup_3(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots) {
-	killn(cs, who, spots, 4, 3);
+kill_setup_3(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who,
+		LPVSET spots, LPSQSET cands) {
+	killn(s, cs, who, spots, cands, 4, 3);
 }
 
 /*
@@ -672,20 +1204,50 @@ kill_setup_3(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots) {
  * Same as kill_block_2, but block a longer trick.
  */
 static void
-kill_block_3(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots) {
-	live(cs, who, spots, 4, 3);
+kill_block_3(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who,
+		LPVSET spots, LPSQSET cands) {
+	live(s, cs, who, spots, cands, 4, 3);
 }
 
 static void
-prekill(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
+prekill(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who,
+		LPVSET spots, LPSQSET cands)
 {
-	killn(cs, who, spots, 1, 1);
+	killn(s, cs, who, spots, cands, 1, 1);
 }
 
 static void
-prekill_1(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
+prekill_1(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who,
+		LPVSET spots, LPSQSET cands)
 {
-	killn(cs, who, spots, 0, 2);
+	killn(s, cs, who, spots, cands, 0, 2);
+}
+
+/*
+ * RULE: gain
+ *
+ * Move wherever the lines through the square would gain us the most, as
+ * scored by cs_movegain().  This is the one rule driven by weights, rather
+ * than by patterns of pieces, and so it's the one the tuner can adjust.
+ */
+static void
+gain(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who,
+		LPVSET spots, LPSQSET cands)
+{
+	int	i, g, best = 0;
+
+	vs_clear(spots);
+
+	for(i=0; i<NUM_SQUARES; i++) {
+		if (!legal(brd, who, i))
+			continue;
+		g = cs_movegain(cs, who, i, s->m_weights);
+		if (g > best) {
+			vs_clear(spots);
+			best = g;
+		} if ((g > 0)&&(g == best))
+			vs_incscore(spots, i);
+	}
 }
 
 /*
@@ -697,54 +1259,105 @@ prekill_1(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
  * something at random, now we have some more method to our madness.
  */
 static void
-corners(LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who, LPVSET spots)
+corners(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET cs, GB_PIECE who,
+		LPVSET spots, LPSQSET cands)
 {
 
+	int	corner, axis, c[NUM_DIMS];
+
 	vs_clear(spots);
 
-	// Simply rate the corners more valuable than anywhere else
-	vs_incscore(spots, coordtoint(0, 0, 0));
-	vs_incscore(spots, coordtoint(3, 0, 0));
-	vs_incscore(spots, coordtoint(0, 3, 0));
-	vs_incscore(spots, coordtoint(3, 3, 0));
-	vs_incscore(spots, coordtoint(0, 0, 3));
-	vs_incscore(spots, coordtoint(3, 0, 3));
-	vs_incscore(spots, coordtoint(0, 3, 3));
-	vs_incscore(spots, coordtoint(3, 3, 3));
+	// Simply rate the corners more valuable than anywhere else.  Each bit
+	// of corner picks either the near or far side along one axis.
+	for(corner=0; corner < (1<<NUM_DIMS); corner++) {
+		for(axis=0; axis<NUM_DIMS; axis++)
+			c[axis] = ((corner >> axis)&1) ? NUM_ON_SIDE-1 : 0;
+		vs_incscore(spots, gb_square(c));
+	}
 }
 
 /*
- * ruleset
+ * RULESET
  *
  * Here's our list of rules that we use in decision making.  Every rule has a
- * name, a difficulty level at or above which it will be applied, and a pointer
- * to the function that applies the rule.
+ * name, a difficulty level at or above which it will be applied, and the
+ * function that applies the rule.  The list is kept as a macro, R(name, level,
+ * fn) per rule, so that it can be expanded both into the ruleset table below
+ * and into the index of each rule that follows it.
+ *
+ * GAIN isn't a part of any difficulty level.  It's only ever used when the
+ * rules are chosen by set_rules().
+ */
+#define	RULESET(R)				\
+	R("ANY",	0, any)			\
+	R("WIN",	1, win)			\
+	R("BLOCK",	1, block)		\
+	R("NEW-FORCE", 	6, newforce)		\
+	R("NWBK-FORCE",	6, newblockforce)	\
+	R("KBLOCK-1",	7, kill_block_1)	\
+	R("KSETUP-1",	7, kill_setup_1)	\
+	R("KBLOCK-2",	8, kill_block_2)	\
+	R("KBLOCK-3",	9, kill_block_3)	\
+	R("KSETUP-2",	7, kill_setup_2)	\
+	R("KSETUP-3",	7, kill_setup_3)	\
+	R("PREK",	10, prekill)		\
+	R("PREK-1",	10, prekill_1)		\
+	R("FORCE",	4, force)		\
+	R("BLOCK-FORCE", 4, blockforce)		\
+	R("SETUP-FORCE", 5, setupforce)		\
+	R("NIX-SETUP",	5, nixsetup)		\
+	R("MAKE-THREE",	2, makethree)		\
+	R("BLOCK-TWO",	2, blocktwo)		\
+	R("MAKE-TWO",	3, maketwo)		\
+	R("BLOCK-ONE",	3, blockone)		\
+	R("GAIN",	INT_MAX, gain)		\
+	R("CORNERS",	9, corners)
+
+/*
+ * ruleset
+ *
+ * The rules, as a table.  The last entry has a NULL rule, so that we can tell
+ * that it is the last entry and use no more.
  */
+#define	RULE_ENTRY(NAME, LEVEL, FN)	{ NAME, LEVEL, FN },
 const static RULE ruleset[] = {
-	{ "ANY",	0, any },
-	{ "WIN",	1, win },
-	{ "BLOCK",	1, block },
-	{ "NEW-FORCE", 	6, newforce },
-	{ "NWBK-FORCE",	6, newblockforce },
-	{ "KBLOCK-1",	7, kill_block_1 },
-	{ "KSETUP-1",	7, kill_setup_1 },
-	{ "KBLOCK-2",	8, kill_block_2 },
-	{ "KBLOCK-3",	9, kill_block_3 },
-	{ "KSETUP-2",	7, kill_setup_2 },
-	{ "KSETUP-3",	7, kill_setup_3 },
-	{ "PREK",	10, prekill },
-	{ "PREK-1",	10, prekill_1 },
-	{ "FORCE",	4, force },
-	{ "BLOCK-FORCE", 4, blockforce },
-	{ "SETUP-FORCE", 5, setupforce },
-	{ "NIX-SETUP",	5, nixsetup },
-	{ "MAKE-THREE",	2, makethree },
-	{ "BLOCK-TWO",	2, blocktwo },
-	{ "MAKE-TWO",	3, maketwo },
-	{ "BLOCK-ONE",	3, blockone },
-	{ "CORNERS",	9, corners },
-	// The last entry has a NULL rule, so that we can tell that it is the
-	// last entry and use no more.
+	RULESET(RULE_ENTRY)
 	{ "", 0, NULL }
 };
 
+/*
+ * RULE_fn
+ *
+ * The index of each rule within the ruleset, named after its function, so
+ * that isheavy() may name the rules, and the trace may say which rule it's
+ * applying.
+ */
+#define	RULE_INDEX(NAME, LEVEL, FN)	RULE_##FN,
+enum	{ RULESET(RULE_INDEX) };
+
+/*
+ * isheavy, rule_isheavy
+ *
+ * The rules built on killn() and live(), setupforce(), and nixsetup() take
+ * far longer than the rest.  isheavy() takes the rule's index within the
+ * ruleset.
+ */
+static inline bool
+isheavy(int rule)
+{
+	switch(rule) {
+	case RULE_newforce:	case RULE_newblockforce:
+	case RULE_kill_block_1:	case RULE_kill_setup_1:
+	case RULE_kill_block_2:	case RULE_kill_block_3:
+	case RULE_kill_setup_2:	case RULE_kill_setup_3:
+	case RULE_prekill:	case RULE_prekill_1:
+	case RULE_setupforce:	case RULE_nixsetup:
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool rule_isheavy(const RULE *rule) {
+	return isheavy(rule - ruleset);
+}
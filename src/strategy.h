@@ -47,9 +47,21 @@
 
 #define	MAX_RULES	32
 
+typedef	struct STRATEGY_S	STRATEGY, *LPSTRATEGY;
+struct	RULEPOOL_S;
+
 // Here's the definition of a "rule".  It's a function that sets the values
-// of a given VSET, in this case, the VSET named spots.
-typedef	void	(*RULEFN)(LPGBOARD brd, LPCOMBOSET, GB_PIECE, LPVSET spots);
+// of a given VSET, in this case, the VSET named spots.  The strategy applying
+// the rule is passed along, so that long rules may check whether they've
+// been asked to stop.
+//
+// Once a first set of moves has been found, the later rules can only choose
+// from among the best of those.  These are given as cands.  A rule given
+// cands need only score those squares correctly, and may leave every other
+// square out--saving the time of looking at lines that can't matter.  cands
+// is NULL when the whole board matters.
+typedef	void	(*RULEFN)(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET, GB_PIECE,
+			LPVSET spots, LPSQSET cands);
 
 // We keep track of rules by more than just the function pointer.  We allow
 // every rule to have a name and a difficulty level.  The rule will apply
@@ -60,16 +72,50 @@ typedef	struct RULE_S {
 	RULEFN	m_fn;
 } RULE, *LPRULE;
 
+// A watcher may be attached to a strategy, to be told of the result of every
+// rule as it is applied.  result is what the rule itself returned, spots is
+// the set of candidate moves remaining once that result has been combined
+// with those of the rules before it.
+typedef	void	(*RULEWATCH)(void *arg, const RULE *rule, LPVSET result,
+			LPVSET spots);
+
+// A strategy may also be told to stop part way through choosing a move.  The
+// stop function is checked between rules, and every so often within the
+// longer rules, and returns true once the strategy should give up.
+typedef	bool	(*RULESTOP)(void *arg);
+
+// A chooser applies a whole set of rules at once, the way choosemoves() does,
+// such as when the rules are spread across a pool of threads.
+typedef	bool	(*CHOOSEFN)(LPSTRATEGY s, LPGBOARD brd, LPCOMBOSET,
+			GB_PIECE, LPVSET spots);
+
 // Finally, we define our strategy.  The strategy is nothing more than a list
 // of rules for a given difficulty level.
-typedef	struct STRATEGY_S {
+struct STRATEGY_S {
 	// The difficulty level determines which rules were applied
 	int	m_difficulty_level,
 		// Keep track of how many rules are valid ones
 		m_num_rules;
+	// The state of our random number generator, used to pick from among
+	// equally good moves
+	unsigned	m_seed;
+	// An optional watcher, given the results of each rule
+	RULEWATCH	m_watch;
+	void		*m_watcharg;
+	// An optional means of stopping early
+	RULESTOP	m_stop;
+	void		*m_stoparg;
+	// The worth of a line, by the number of our pieces in it, for those
+	// rules that evaluate positions.  NULL uses cs_weight.
+	const int	*m_weights;
 	// And here's where we point to all of our rules
 	const RULE *m_rules[MAX_RULES];
-} STRATEGY, *LPSTRATEGY;
+	// The chooser to apply these rules with, or NULL to apply them in turn
+	CHOOSEFN	m_choose;
+	// The pool of threads to spread the longer rules across, if any (see
+	// rulepool.h)
+	struct RULEPOOL_S	*m_pool;
+};
 
 /*
  * set_difficulty
@@ -79,11 +125,79 @@ typedef	struct STRATEGY_S {
  */
 extern	void	set_difficulty(LPSTRATEGY s, int difficulty);
 
+/*
+ * set_rules
+ *
+ * Rather than choosing the rules by difficulty, use the nrules rules given,
+ * in the order given.  This is for tuning the strategy (see tune.c).  As with
+ * set_difficulty(), any watcher or stop function is removed.
+ */
+extern	void	set_rules(LPSTRATEGY s, const RULE *const *rules, int nrules);
+
+/*
+ * get_rule
+ *
+ * Returns the idx'th rule of the full set of rules, in its usual order, or
+ * NULL once idx runs off the end.
+ */
+extern	const RULE	*get_rule(int idx);
+
+/*
+ * rule_isheavy
+ *
+ * Returns true for the rules that take the longest to apply, and are worth
+ * handing to another thread.
+ */
+extern	bool	rule_isheavy(const RULE *rule);
+
+/*
+ * set_weights
+ *
+ * Give the strategy its own line weights (NUM_ON_SIDE+1 of them, see
+ * cs_weight), or NULL to go back to the usual ones.
+ */
+extern	void	set_weights(LPSTRATEGY s, const int *weights);
+
+/*
+ * set_seed
+ *
+ * Seed the random number generator used when choosing between equally good
+ * moves.
+ */
+extern	void	set_seed(LPSTRATEGY s, unsigned seed);
+
+/*
+ * set_watch
+ *
+ * Attach a function to be called after every rule is applied, for the
+ * purpose of analysis.  set_difficulty() removes any watcher.
+ */
+extern	void	set_watch(LPSTRATEGY s, RULEWATCH fn, void *arg);
+
+/*
+ * set_stop
+ *
+ * Attach a function to be checked, as the rules are applied, to see whether
+ * the strategy should stop early.  set_difficulty() removes any stop function.
+ */
+extern	void	set_stop(LPSTRATEGY s, RULESTOP fn, void *arg);
+
+/*
+ * choosemoves
+ *
+ * Apply our ruleset, placing the final set of candidate moves into spots.
+ * All of these are equally good in the strategies eyes.  Returns false if
+ * told to stop before every rule was applied, in which case spots holds the
+ * candidates chosen by the rules applied so far.
+ */
+extern	bool	choosemoves(LPSTRATEGY, LPGBOARD, LPCOMBOSET, GB_PIECE,
+			LPVSET spots);
+
 /*
  * makemove
  *
  * Use our ruleset, as applied to the board and the set of 4-in a row
- * combinations to choose a move.
+ * combinations to choose a move.  Returns -1 if no legal move exists.
  */
 extern	int	makemove(LPSTRATEGY, LPGBOARD, LPCOMBOSET, GB_PIECE);
 
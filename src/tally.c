@@ -0,0 +1,322 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	tally.c
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	Reads and writes the tally of one shard of an arena or analysis
+//		run, in the format described in tally.h, and adds tallies up.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#define	_POSIX_C_SOURCE	200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "tally.h"
+
+// The most a tally file may hold: the header and counts, and every bucket of
+// every histogram
+#define	TL_MAXSIZE	(TL_HEADERSIZE + 128 + LAT_MAXLEVELS * (4		\
+			+ LAT_NFILLS * (28 + 6 * LAT_NBUCKETS)))
+
+bool	tl_parseshard(const char *spec, int *shard, int *nshards) {
+	char	*end;
+	long	i, n;
+
+	i = strtol(spec, &end, 10);
+	if ((end == spec)||(*end != '/'))
+		return false;
+	spec = end+1;
+	n = strtol(spec, &end, 10);
+	if ((end == spec)||(*end != '\0'))
+		return false;
+	if ((n < 1)||(n > 0x7fffffff)||(i < 0)||(i >= n))
+		return false;
+	*shard   = (int)i;
+	*nshards = (int)n;
+	return true;
+}
+
+void	tl_clear(LPTALLY t, TL_KIND kind, int shard, int nshards) {
+	int	k;
+
+	t->m_kind = kind;
+	t->m_shard = shard;
+	t->m_nshards = nshards;
+	t->m_difficulty[0] = t->m_difficulty[1] = 0;
+	t->m_seed   = 0;
+	t->m_total  = 0;
+	t->m_count  = 0;
+	t->m_errors = 0;
+	t->m_nmoves = 0;
+	for(k=0; k<=GB_TIE; k++)
+		t->m_wins[k] = 0;
+	t->m_lat = NULL;
+}
+
+void	tl_merge(LPTALLY dst, const TALLY *src) {
+	int	k;
+
+	dst->m_count  += src->m_count;
+	dst->m_errors += src->m_errors;
+	dst->m_nmoves += src->m_nmoves;
+	for(k=0; k<=GB_TIE; k++)
+		dst->m_wins[k] += src->m_wins[k];
+	if ((dst->m_lat)&&(src->m_lat))
+		lat_tmerge(dst->m_lat, src->m_lat);
+}
+
+static unsigned char *
+put16(unsigned char *p, unsigned v) {
+	p[0] = v; p[1] = v>>8;
+	return p+2;
+}
+
+static unsigned char *
+put32(unsigned char *p, uint32_t v) {
+	put16(p, v & 0x0ffff); put16(p+2, v >> 16);
+	return p+4;
+}
+
+static unsigned char *
+put64(unsigned char *p, uint64_t v) {
+	put32(p, (uint32_t)v); put32(p+4, (uint32_t)(v >> 32));
+	return p+8;
+}
+
+static unsigned
+get16(const unsigned char *p) {
+	return p[0] | (p[1]<<8);
+}
+
+static uint32_t
+get32(const unsigned char *p) {
+	return get16(p) | ((uint32_t)get16(p+2) << 16);
+}
+
+static uint64_t
+get64(const unsigned char *p) {
+	return get32(p) | ((uint64_t)get32(p+4) << 32);
+}
+
+/*
+ * tl_encode
+ *
+ * Convert a tally to its binary form, returning the number of bytes used
+ */
+static size_t
+tl_encode(const TALLY *t, unsigned char *buf) {
+	unsigned char	*p = buf, *nused;
+	const LATHIST	*h;
+	int		k, f, b, n;
+
+	memcpy(p, "TTTS", 4);
+	p[4] = TL_VERSION;
+	p[5] = t->m_kind;
+	put16(&p[6], NUM_SQUARES);
+	p += TL_HEADERSIZE;
+
+	p = put32(p, t->m_shard);
+	p = put32(p, t->m_nshards);
+	p = put16(p, t->m_difficulty[0]);
+	p = put16(p, t->m_difficulty[1]);
+	p = put32(p, t->m_seed);
+	p = put64(p, t->m_total);
+	p = put64(p, t->m_count);
+	p = put64(p, t->m_errors);
+	p = put64(p, t->m_nmoves);
+	for(k=0; k<=GB_TIE; k++)
+		p = put64(p, t->m_wins[k]);
+
+	if (!t->m_lat)
+		return put32(p, 0) - buf;
+
+	p = put32(p, t->m_lat->m_nlevels);
+	p = put64(p, t->m_lat->m_dropped);
+	for(k=0; k<t->m_lat->m_nlevels; k++) {
+		p = put32(p, t->m_lat->m_levels[k]);
+		for(f=0; f<LAT_NFILLS; f++) {
+			h = &t->m_lat->m_hist[k][f];
+			p = put64(p, h->m_count);
+			p = put64(p, h->m_total);
+			p = put64(p, h->m_max);
+			nused = p;
+			p += 4;
+			for(b=0, n=0; b<LAT_NBUCKETS; b++) {
+				if (h->m_buckets[b] == 0)
+					continue;
+				p = put16(p, b);
+				p = put32(p, h->m_buckets[b]);
+				n++;
+			} put32(nused, n);
+		}
+	}
+
+	return p - buf;
+}
+
+/*
+ * tl_decode
+ *
+ * Convert len bytes back into a tally.  Returns false if they aren't one,
+ * for this size of board.  Any latency table goes into lat, which is only
+ * kept if used.
+ */
+static bool
+tl_decode(const unsigned char *buf, size_t len, LPTALLY t, LPLATTABLE lat) {
+	const unsigned char	*p = buf, *end = buf + len;
+	LPLATHIST		h;
+	int			k, f, n;
+	unsigned		b;
+
+	if ((len < TL_HEADERSIZE + 84)||(memcmp(p, "TTTS", 4) != 0)
+			||(p[4] != TL_VERSION)
+			||((p[5] != TL_ARENA)&&(p[5] != TL_ANALYZE))
+			||(get16(&p[6]) != NUM_SQUARES))
+		return false;
+	tl_clear(t, (TL_KIND)p[5], 0, 1);
+	p += TL_HEADERSIZE;
+
+	t->m_shard   = (int)get32(p);		p += 4;
+	t->m_nshards = (int)get32(p);		p += 4;
+	t->m_difficulty[0] = get16(p);		p += 2;
+	t->m_difficulty[1] = get16(p);		p += 2;
+	t->m_seed    = get32(p);		p += 4;
+	t->m_total   = get64(p);		p += 8;
+	t->m_count   = get64(p);		p += 8;
+	t->m_errors  = get64(p);		p += 8;
+	t->m_nmoves  = get64(p);		p += 8;
+	for(k=0; k<=GB_TIE; k++, p += 8)
+		t->m_wins[k] = get64(p);
+	n = (int)get32(p);			p += 4;
+	if ((t->m_nshards < 1)||(t->m_shard < 0)
+			||(t->m_shard >= t->m_nshards)
+			||(n < 0)||(n > LAT_MAXLEVELS))
+		return false;
+	if (n == 0)
+		return (p == end);
+
+	lat_tclear(lat);
+	if (end - p < 8)
+		return false;
+	lat->m_nlevels = n;
+	lat->m_dropped = get64(p);		p += 8;
+	for(k=0; k<lat->m_nlevels; k++) {
+		if (end - p < 4)
+			return false;
+		lat->m_levels[k] = (int)get32(p);	p += 4;
+		for(f=0; f<LAT_NFILLS; f++) {
+			h = &lat->m_hist[k][f];
+			if (end - p < 28)
+				return false;
+			h->m_count = get64(p);		p += 8;
+			h->m_total = get64(p);		p += 8;
+			h->m_max   = get64(p);		p += 8;
+			n = (int)get32(p);		p += 4;
+			if ((n < 0)||(n > LAT_NBUCKETS)||(end - p < 6 * n))
+				return false;
+			for(; n > 0; n--, p += 6) {
+				b = get16(p);
+				if (b >= LAT_NBUCKETS)
+					return false;
+				h->m_buckets[b] = get32(p+2);
+			}
+		}
+	}
+
+	if (p != end)
+		return false;
+	t->m_lat = lat;
+	return true;
+}
+
+bool	tl_write(const char *fname, const TALLY *t) {
+	unsigned char	*buf;
+	size_t		len;
+	FILE		*fp;
+	bool		ok;
+
+	buf = (unsigned char *)malloc(TL_MAXSIZE);
+	if (!buf)
+		return false;
+	len = tl_encode(t, buf);
+
+	fp = fopen(fname, "wb");
+	if (!fp) {
+		free(buf);
+		return false;
+	}
+	ok = (fwrite(buf, 1, len, fp) == len);
+	if (fclose(fp) != 0)
+		ok = false;
+	free(buf);
+	return ok;
+}
+
+bool	tl_read(const char *fname, LPTALLY t) {
+	unsigned char	*buf;
+	LPLATTABLE	lat;
+	size_t		len;
+	FILE		*fp;
+	bool		ok;
+
+	buf = (unsigned char *)malloc(TL_MAXSIZE+1);
+	lat = (LPLATTABLE)malloc(sizeof(LATTABLE));
+	fp  = fopen(fname, "rb");
+	if ((!buf)||(!lat)||(!fp)) {
+		if (fp)
+			fclose(fp);
+		free(buf);
+		free(lat);
+		return false;
+	}
+
+	len = fread(buf, 1, TL_MAXSIZE+1, fp);
+	ok = !ferror(fp);
+	fclose(fp);
+	if ((ok)&&((len > TL_MAXSIZE)||(!tl_decode(buf, len, t, lat)))) {
+		errno = EINVAL;
+		ok = false;
+	}
+
+	free(buf);
+	if ((!ok)||(!t->m_lat))
+		free(lat);
+	if (!ok)
+		t->m_lat = NULL;
+	return ok;
+}
+
+void	tl_free(LPTALLY t) {
+	free(t->m_lat);
+	t->m_lat = NULL;
+}
@@ -0,0 +1,153 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	tally.h
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	Partial results, for spreading one large arena or analysis run
+//		across many processes, or many machines, that share nothing
+//	but files.  Each process is given a shard, "i/n": the i'th of n, counting
+//	from zero.  The arena's shard i plays every game whose number leaves i
+//	when divided by n, and the analyzer's every position whose line number
+//	does.  Since every game's seed, and every position's, depends only upon
+//	its number, each game and each choice is the same no matter how many
+//	shards there are, or which of them plays it.
+//
+//	Each shard writes its tally to a small file: the header "TTTS", a
+//	version byte, the kind of run (TL_ARENA or TL_ANALYZE), the number of
+//	squares on the board (16 bits), and then, 32 bits each unless noted,
+//
+//		shard, nshards		which shard this is, of how many
+//		difficulty		16 bits for black, then 16 bits for white.
+//					The analyzer only uses black's.
+//		seed
+//		total			64 bits: the number of games (or
+//					positions) in the whole run, across
+//					every shard
+//		count, errors, nmoves	64 bits each: the games (positions)
+//					played, those that couldn't be, and the
+//					moves made across them
+//		wins			64 bits each, for GB_NOONE, GB_WHITE,
+//					GB_BLACK, and GB_TIE
+//		nlevels			the number of difficulty levels timed,
+//					or zero if the run wasn't timed (-l)
+//
+//	If timed, the number of moves dropped from the latency table (64 bits)
+//	follows, and then for each level its number, and for each of its
+//	LAT_NFILLS histograms the count, total, and longest time (64 bits
+//	each), the number of buckets used, and each used bucket's index (16
+//	bits) and count.  All values are little endian.
+//
+//	tttt-merge reads the tally of every shard, checks that together they
+//	cover the whole run once, and adds them up, in order of shard, into the
+//	same statistics a single process would have reported.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#ifndef	TALLY_H
+#define	TALLY_H
+
+#include <stdint.h>
+#include "gboard.h"
+#include "latency.h"
+
+#define	TL_VERSION	1
+#define	TL_HEADERSIZE	8
+
+typedef	enum	TL_KIND_E {
+	TL_ARENA=1, TL_ANALYZE
+} TL_KIND;
+
+typedef	struct	TALLY_S {
+	TL_KIND		m_kind;
+	int		m_shard, m_nshards;
+	int		m_difficulty[2];
+	unsigned	m_seed;
+	unsigned long	m_total;
+	uint64_t	m_count, m_errors, m_nmoves, m_wins[GB_TIE+1];
+	// The time taken by every move, or NULL if the run wasn't timed
+	LPLATTABLE	m_lat;
+} TALLY, *LPTALLY;
+
+/*
+ * tl_parseshard
+ *
+ * Read a shard, as "i/n", into *shard and *nshards.  Returns false unless
+ * 0 <= i < n.
+ */
+extern	bool	tl_parseshard(const char *spec, int *shard, int *nshards);
+
+/*
+ * tl_inshard
+ *
+ * True if game (or line) number k belongs to the given shard
+ */
+#define	tl_inshard(K, SHARD, NSHARDS)	((K) % (NSHARDS) == (unsigned)(SHARD))
+
+/*
+ * tl_clear
+ *
+ * Start an empty tally, for shard of nshards.  The latency table, if any, is
+ * left for the caller.
+ */
+extern	void	tl_clear(LPTALLY t, TL_KIND kind, int shard, int nshards);
+
+/*
+ * tl_merge
+ *
+ * Add src's counts into dst, and its times into dst's latency table, if dst
+ * has one.
+ */
+extern	void	tl_merge(LPTALLY dst, const TALLY *src);
+
+/*
+ * tl_write, tl_read
+ *
+ * Write a tally to a file, or read it back.  tl_read() allocates the latency
+ * table, if the file has one, which tl_free() releases.  Both return false
+ * (with errno set, if the O/S failed) on any error, including, for tl_read(),
+ * a file that isn't a tally of this size of board.
+ */
+extern	bool	tl_write(const char *fname, const TALLY *t);
+extern	bool	tl_read(const char *fname, LPTALLY t);
+extern	void	tl_free(LPTALLY t);
+
+/*
+ * tl_print
+ *
+ * Write out, to stdout, what the arena (or the analyzer) reports once done:
+ * the number of games, how many each side won, and how long they were--or
+ * the number of positions, and how many couldn't be evaluated--followed by
+ * the latency table, if any.  This is found in display.c, with the rest of
+ * the routines that print.
+ */
+extern	void	tl_print(const TALLY *t);
+
+#endif
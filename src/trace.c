@@ -0,0 +1,201 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	trace.c
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	The per-thread ring buffers behind the decision trace, and the
+//		binary form of a trace file.  See trace.h.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#define	_POSIX_C_SOURCE	200809L
+#include <time.h>
+#include "strategy.h"
+#include "trace.h"
+
+#ifdef	TTTT_TRACE
+#ifdef	TTTT_SMALL
+TRACE_RING	trace_ring;
+#else
+__thread TRACE_RING	trace_ring;
+#endif
+
+/*
+ * nanoseconds
+ *
+ * The time, from some arbitrary start, in nanoseconds--or zero if there's no
+ * clock to be had.
+ */
+static uint64_t
+nanoseconds(void)
+{
+#ifdef	CLOCK_MONOTONIC
+	struct timespec	ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+		return ts.tv_sec * (uint64_t)1000000000 + ts.tv_nsec;
+#endif
+	return 0;
+}
+
+#if	!defined(__x86_64__)&&!defined(__i386__)
+uint64_t
+trace_clock(void)
+{
+	return nanoseconds();
+}
+#endif
+#endif
+
+unsigned
+trace_read(LPTRACE_EVENT events, unsigned max)
+{
+#ifdef	TTTT_TRACE
+	unsigned	k, n, first;
+
+	n = trace_ring.m_head;
+	if (n > TRACE_SIZE)
+		n = TRACE_SIZE;
+	if (n > max)
+		n = max;
+	first = trace_ring.m_head - n;
+	for(k=0; k<n; k++)
+		events[k] = trace_ring.m_events[(first + k) & (TRACE_SIZE-1)];
+	return n;
+#else
+	return 0;
+#endif
+}
+
+void
+trace_clear(void)
+{
+#ifdef	TTTT_TRACE
+	trace_ring.m_head = 0;
+#endif
+}
+
+uint64_t
+trace_rate(void)
+{
+#if	defined(TTTT_TRACE)&&(defined(__x86_64__)||defined(__i386__))
+	static uint64_t	rate = 0;
+	uint64_t	t0, c0, t1, c1;
+
+	if (rate == 0) {
+		// Count the ticks across ten milliseconds
+		t0 = nanoseconds();
+		c0 = trace_clock();
+		do {
+			t1 = nanoseconds();
+			c1 = trace_clock();
+		} while(t1 - t0 < 10000000);
+		rate = (c1 - c0) * 1000000000.0 / (t1 - t0);
+	}
+
+	return rate;
+#else
+	return 1000000000;
+#endif
+}
+
+static void
+put16(unsigned char *p, unsigned v) {
+	p[0] = v; p[1] = v>>8;
+}
+
+static void
+put32(unsigned char *p, uint32_t v) {
+	put16(p, v & 0x0ffff); put16(p+2, v >> 16);
+}
+
+static void
+put64(unsigned char *p, uint64_t v) {
+	put32(p, (uint32_t)v); put32(p+4, (uint32_t)(v >> 32));
+}
+
+static unsigned
+get16(const unsigned char *p) {
+	return p[0] | (p[1]<<8);
+}
+
+static uint32_t
+get32(const unsigned char *p) {
+	return get16(p) | ((uint32_t)get16(p+2) << 16);
+}
+
+static uint64_t
+get64(const unsigned char *p) {
+	return get32(p) | ((uint64_t)get32(p+4) << 32);
+}
+
+void
+trace_header(unsigned char *buf)
+{
+	int	nrules;
+
+	for(nrules=0; get_rule(nrules); nrules++)
+		;
+	buf[0] = 'T'; buf[1] = 'T'; buf[2] = 'R'; buf[3] = 'T';
+	buf[4] = TRACE_VERSION;
+	buf[5] = TRACE_EVENTSIZE;
+	put16(&buf[6], nrules);
+	put64(&buf[8], trace_rate());
+}
+
+void
+trace_block(unsigned char *buf, unsigned thread, unsigned nevents)
+{
+	put32(&buf[0], thread);
+	put32(&buf[4], nevents);
+}
+
+void
+trace_encode(const TRACE_EVENT *ev, unsigned char *buf)
+{
+	put64(&buf[0], ev->m_time);
+	buf[8] = ev->m_type;
+	buf[9] = ev->m_arg;
+	put16(&buf[10], ev->m_val[0]);
+	put16(&buf[12], ev->m_val[1]);
+	put16(&buf[14], ev->m_val[2]);
+}
+
+void
+trace_decode(const unsigned char *buf, LPTRACE_EVENT ev)
+{
+	ev->m_time = get64(&buf[0]);
+	ev->m_type = buf[8];
+	ev->m_arg  = buf[9];
+	ev->m_val[0] = get16(&buf[10]);
+	ev->m_val[1] = get16(&buf[12]);
+	ev->m_val[2] = get16(&buf[14]);
+}
@@ -0,0 +1,207 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	trace.h
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	Traces the engine's decisions, as compact binary events, into a
+//		ring buffer of the last TRACE_SIZE events for every thread.
+//	When a move is slow, or odd, the trace shows which rules were applied
+//	to choose it, how long each took, and how many candidate moves each
+//	left behind.
+//
+//	Tracing is built in only with TTTT_TRACE defined (make TRACE=1).
+//	Otherwise, every TRACE_ macro below is empty, and costs nothing.
+//	On x86 hosts, recording an event takes a handful of instructions,
+//	reading the time stamp counter inline.  Elsewhere, the time comes from
+//	trace_clock(), the O/S's monotonic clock.
+//
+//	A trace file starts with a 16 byte header: the magic "TTRT", a version
+//	byte, the number of bytes per event, the number of rules in the
+//	ruleset (16 bits), and the number of clock ticks per second (64 bits).
+//	Blocks follow, one per ring buffer saved: the number of the thread
+//	it came from, and the number of events within it (32 bits each),
+//	followed by the events themselves, oldest first:
+//
+//		time		64 bits, in clock ticks
+//		type		8 bits, one of TR_START, TR_RULE, TR_END, or
+//				TR_PICK
+//		arg		8 bits.  For TR_RULE, the rule's index within
+//				the ruleset (see get_rule()).  Otherwise, whose
+//				move it is.
+//		values		three of 16 bits each, as given by the type
+//				below
+//
+//	All values are little endian, regardless of the machine writing them.
+//	tttt-tracedump decodes them.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#ifndef	TRACE_H
+#define	TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define	TRACE_VERSION		1
+#define	TRACE_HEADERSIZE	16
+#define	TRACE_BLKHDRSIZE	8
+#define	TRACE_EVENTSIZE		16
+
+// The number of events each thread keeps.  This must be a power of two.
+#ifndef	TRACE_SIZE
+#define	TRACE_SIZE	16384
+#endif
+
+typedef	enum	TRACE_TYPE_E {
+	// choosemoves() was called.  The values are the difficulty level, the
+	// number of squares filled, and the number of lines still in play.
+	TR_START = 1,
+	// A rule was applied.  The values are the number of candidate moves
+	// before it, and after it: zero, until some rule finds a move, and
+	// the number of best scoring moves from then on.  The rule ran until
+	// the time of the next event.
+	TR_RULE,
+	// choosemoves() returned.  The first value is one if every rule was
+	// applied, zero if told to stop early.
+	TR_END,
+	// makemove() picked a move.  The first value is the square, or 0xffff
+	// if there was no legal move.
+	TR_PICK
+} TRACE_TYPE;
+
+typedef	struct	TRACE_EVENT_S {
+	uint64_t	m_time;
+	uint8_t		m_type, m_arg;
+	uint16_t	m_val[3];
+} TRACE_EVENT, *LPTRACE_EVENT;
+
+#ifdef	TTTT_TRACE
+#define	TRACE_ENABLED	1
+
+typedef	struct	TRACE_RING_S {
+	unsigned	m_head;
+	TRACE_EVENT	m_events[TRACE_SIZE];
+} TRACE_RING;
+
+// The small build has but one thread, and may not have thread local storage
+#ifdef	TTTT_SMALL
+extern	TRACE_RING	trace_ring;
+#else
+extern	__thread TRACE_RING	trace_ring;
+#endif
+
+/*
+ * trace_clock
+ *
+ * The time, in ticks of trace_rate() per second.  On x86, this is the time
+ * stamp counter, read inline.
+ */
+#if	defined(__x86_64__)||defined(__i386__)
+#define	trace_clock()	__builtin_ia32_rdtsc()
+#else
+extern	uint64_t	trace_clock(void);
+#endif
+
+/*
+ * trace_event
+ *
+ * Record one event into this thread's ring, overwriting the oldest.
+ */
+static inline void
+trace_event(int type, int arg, unsigned a, unsigned b, unsigned c)
+{
+	LPTRACE_EVENT	ev;
+
+	ev = &trace_ring.m_events[trace_ring.m_head++ & (TRACE_SIZE-1)];
+	ev->m_time = trace_clock();
+	ev->m_type = type;
+	ev->m_arg  = arg;
+	ev->m_val[0] = a;
+	ev->m_val[1] = b;
+	ev->m_val[2] = c;
+}
+
+#define	TRACE_START(WHO, LEVEL, NFILLED, NINPLAY)	\
+	trace_event(TR_START, (WHO), (LEVEL), (NFILLED), (NINPLAY))
+#define	TRACE_RULE(IDX, BEFORE)	trace_event(TR_RULE, (IDX), (BEFORE), 0, 0)
+// Fill in how many candidates the rule just recorded left behind
+#define	TRACE_AFTER(AFTER)	trace_ring.m_events[(trace_ring.m_head-1)\
+					& (TRACE_SIZE-1)].m_val[1] = (AFTER)
+#define	TRACE_END(WHO, DONE)	trace_event(TR_END, (WHO), (DONE), 0, 0)
+#define	TRACE_PICK(WHO, SQUARE)	trace_event(TR_PICK, (WHO), (SQUARE), 0, 0)
+#else
+#define	TRACE_ENABLED	0
+#define	TRACE_START(WHO, LEVEL, NFILLED, NINPLAY)
+#define	TRACE_RULE(IDX, BEFORE)
+#define	TRACE_AFTER(AFTER)
+#define	TRACE_END(WHO, DONE)
+#define	TRACE_PICK(WHO, SQUARE)
+#endif
+
+/*
+ * trace_read
+ *
+ * Copy up to max of this thread's events, the most recent ones, into events,
+ * oldest first.  Returns the number copied--always zero when tracing isn't
+ * built in.
+ */
+extern	unsigned	trace_read(LPTRACE_EVENT events, unsigned max);
+
+/*
+ * trace_clear
+ *
+ * Forget every event this thread has recorded.
+ */
+extern	void	trace_clear(void);
+
+/*
+ * trace_rate
+ *
+ * Returns the number of trace_clock() ticks per second.  Measuring this takes
+ * about a hundredth of a second, the first time it's asked for.
+ */
+extern	uint64_t	trace_rate(void);
+
+/*
+ * trace_header, trace_block, trace_encode, trace_decode
+ *
+ * Convert the parts of a trace file to and from their binary form.
+ * trace_header() writes the TRACE_HEADERSIZE byte header, trace_block() the
+ * TRACE_BLKHDRSIZE byte header of a block, and trace_encode() one event of
+ * TRACE_EVENTSIZE bytes.  trace_decode() reads one event back.
+ */
+extern	void	trace_header(unsigned char *buf);
+extern	void	trace_block(unsigned char *buf, unsigned thread,
+			unsigned nevents);
+extern	void	trace_encode(const TRACE_EVENT *ev, unsigned char *buf);
+extern	void	trace_decode(const unsigned char *buf, LPTRACE_EVENT ev);
+
+#endif
@@ -0,0 +1,290 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	tracedump.c
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	Decodes a trace file, as saved by tttt-arena -t from a build with
+//		tracing (make TRACE=1), and lists the moves within it: for
+//	each, who chose it, at what difficulty level, how long it took, and
+//	then every rule applied--how long each took, and how many candidate
+//	moves it left.  Moves may be limited to the slow ones, or summarized
+//	by rule.  See trace.h for the format.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#define	_POSIX_C_SOURCE	200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "gboard.h"
+#include "strategy.h"
+#include "trace.h"
+
+typedef	struct	DUMP_S {
+	// Microseconds per clock tick
+	double		m_usec;
+	int		m_nrules;
+	// Only list moves taking at least this long, in microseconds
+	double		m_slow;
+	bool		m_summary;
+	// Per rule: how often it was applied, and the total and most time
+	// it took
+	unsigned long	*m_count;
+	double		*m_total, *m_max;
+	unsigned long	m_nmoves, m_nlisted;
+} DUMP, *LPDUMP;
+
+static const char *
+rulename(int idx) {
+	const RULE	*r = get_rule(idx);
+
+	return (r) ? r->m_name : "(unknown)";
+}
+
+static const char *
+piecename(int who) {
+	return (who == GB_BLACK) ? "black" : (who == GB_WHITE) ? "white" : "?";
+}
+
+/*
+ * dump_move
+ *
+ * Given the n events of one move, starting with its TR_START, either list it
+ * or add it to the summary.
+ */
+static void
+dump_move(LPDUMP d, unsigned thread, const TRACE_EVENT *ev, int n) {
+	double	elapsed, dt;
+	int	k, square = -1;
+	bool	done = false;
+
+	elapsed = (ev[n-1].m_time - ev[0].m_time) * d->m_usec;
+	for(k=1; k<n; k++) {
+		if (ev[k].m_type == TR_END)
+			done = (ev[k].m_val[0] != 0);
+		else if ((ev[k].m_type == TR_PICK)&&(ev[k].m_val[0] != 0xffff))
+			square = ev[k].m_val[0];
+	}
+
+	d->m_nmoves++;
+	if (elapsed < d->m_slow)
+		return;
+	d->m_nlisted++;
+
+	if (!d->m_summary) {
+		printf("T%u: %s, level %d, %d filled, %d lines: %.2f us",
+			thread, piecename(ev[0].m_arg), ev[0].m_val[0],
+			ev[0].m_val[1], ev[0].m_val[2], elapsed);
+		if (square >= 0)
+			printf(", square %d", square);
+		printf("%s\n", (done) ? "" : " (stopped)");
+	}
+
+	for(k=1; k<n-1; k++) {
+		if (ev[k].m_type != TR_RULE)
+			continue;
+		dt = (ev[k+1].m_time - ev[k].m_time) * d->m_usec;
+		if (d->m_summary) {
+			if (ev[k].m_arg >= d->m_nrules)
+				continue;
+			d->m_count[ev[k].m_arg]++;
+			d->m_total[ev[k].m_arg] += dt;
+			if (dt > d->m_max[ev[k].m_arg])
+				d->m_max[ev[k].m_arg] = dt;
+		} else
+			printf("\t%-12s %4d -> %-4d %10.2f us\n",
+				rulename(ev[k].m_arg), ev[k].m_val[0],
+				ev[k].m_val[1], dt);
+	}
+}
+
+/*
+ * dump_block
+ *
+ * Walk the n events of one thread's trace, a move at a time.  A ring may
+ * begin part way through a move, and end part way through another.  Those
+ * moves are skipped.
+ */
+static void
+dump_block(LPDUMP d, unsigned thread, const unsigned char *buf, unsigned n) {
+	TRACE_EVENT	*ev;
+	unsigned	k;
+	int		nmove = -1;
+
+	ev = (TRACE_EVENT *)malloc((n+1) * sizeof(TRACE_EVENT));
+	if (!ev) {
+		fprintf(stderr, "ERR: Out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+
+	for(k=0; k<n; k++) {
+		trace_decode(&buf[k * TRACE_EVENTSIZE], &ev[k]);
+		if (ev[k].m_type == TR_START)
+			nmove = k;
+		else if ((nmove >= 0)&&(ev[k].m_type == TR_END)) {
+			// A move made by makemove() ends with its pick
+			if ((k+1 < n)&&(buf[(k+1)*TRACE_EVENTSIZE + 8]
+						== TR_PICK)) {
+				k++;
+				trace_decode(&buf[k * TRACE_EVENTSIZE], &ev[k]);
+			}
+			dump_move(d, thread, &ev[nmove], k+1-nmove);
+			nmove = -1;
+		}
+	}
+
+	free(ev);
+}
+
+static unsigned
+get32(const unsigned char *p) {
+	return p[0] | (p[1]<<8) | (p[2]<<16) | ((unsigned)p[3]<<24);
+}
+
+static uint64_t
+get64(const unsigned char *p) {
+	return get32(p) | ((uint64_t)get32(p+4) << 32);
+}
+
+static void
+usage(void) {
+	fprintf(stderr,
+"USAGE: tttt-tracedump [-m <usec>] [-s] <file>\n"
+"\n"
+"\t-m <usec>\tOnly list moves taking at least <usec> microseconds\n"
+"\t-s\t\tRather than listing moves, summarize the time taken by each\n"
+"\t\trule\n");
+}
+
+int	main(int argc, char **argv) {
+	DUMP		d;
+	struct stat	sb;
+	const unsigned char	*data;
+	size_t		pos;
+	unsigned	thread, n;
+	uint64_t	rate;
+	int		fd, opt, k;
+	void		*map;
+
+	d.m_slow = 0;
+	d.m_summary = false;
+	d.m_nmoves = d.m_nlisted = 0;
+	while((opt = getopt(argc, argv, "hm:s")) != -1) {
+		switch(opt) {
+		case 'm': d.m_slow = atof(optarg); break;
+		case 's': d.m_summary = true; break;
+		default:
+			usage();
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (optind+1 != argc) {
+		usage();
+		exit(EXIT_FAILURE);
+	}
+
+	fd = open(argv[optind], O_RDONLY);
+	if ((fd < 0)||(fstat(fd, &sb) < 0)) {
+		perror("O/S Err: Cannot open trace file");
+		exit(EXIT_FAILURE);
+	}
+	if (sb.st_size < TRACE_HEADERSIZE) {
+		fprintf(stderr, "ERR: %s is not a trace file\n", argv[optind]);
+		exit(EXIT_FAILURE);
+	}
+	map = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED) {
+		perror("O/S Err: Cannot map trace file");
+		exit(EXIT_FAILURE);
+	}
+	data = (const unsigned char *)map;
+
+	for(d.m_nrules=0; get_rule(d.m_nrules); d.m_nrules++)
+		;
+	rate = get64(&data[8]);
+	if ((data[0] != 'T')||(data[1] != 'T')||(data[2] != 'R')
+			||(data[3] != 'T')||(data[4] != TRACE_VERSION)
+			||(data[5] != TRACE_EVENTSIZE)||(rate == 0)) {
+		fprintf(stderr, "ERR: %s is not a trace file\n", argv[optind]);
+		exit(EXIT_FAILURE);
+	}
+	if ((data[6] | (data[7]<<8)) != d.m_nrules)
+		fprintf(stderr, "WARNING: %s was traced with a different "
+			"ruleset--rule names may be wrong\n", argv[optind]);
+	d.m_usec = 1e6 / rate;
+
+	d.m_count = (unsigned long *)calloc(d.m_nrules, sizeof(unsigned long));
+	d.m_total = (double *)calloc(d.m_nrules, sizeof(double));
+	d.m_max   = (double *)calloc(d.m_nrules, sizeof(double));
+	if ((!d.m_count)||(!d.m_total)||(!d.m_max)) {
+		fprintf(stderr, "ERR: Out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+
+	for(pos = TRACE_HEADERSIZE; pos + TRACE_BLKHDRSIZE <= (size_t)sb.st_size;
+			pos += (size_t)n * TRACE_EVENTSIZE) {
+		thread = get32(&data[pos]);
+		n = get32(&data[pos+4]);
+		pos += TRACE_BLKHDRSIZE;
+		if ((size_t)n * TRACE_EVENTSIZE > sb.st_size - pos) {
+			fprintf(stderr, "WARNING: %s is cut short\n",
+				argv[optind]);
+			n = (sb.st_size - pos) / TRACE_EVENTSIZE;
+		}
+		dump_block(&d, thread, &data[pos], n);
+	}
+
+	if (d.m_summary) {
+		printf("Moves:  %10lu", d.m_nmoves);
+		if (d.m_slow > 0)
+			printf(", %lu of them slow", d.m_nlisted);
+		printf("\n\n%-12s %10s %12s %10s %10s\n", "Rule", "Applied",
+			"Total (us)", "Mean (us)", "Max (us)");
+		for(k=0; k<d.m_nrules; k++) {
+			if (!d.m_count[k])
+				continue;
+			printf("%-12s %10lu %12.1f %10.3f %10.2f\n",
+				rulename(k), d.m_count[k], d.m_total[k],
+				d.m_total[k] / d.m_count[k], d.m_max[k]);
+		}
+	}
+
+	free(d.m_count);
+	free(d.m_total);
+	free(d.m_max);
+	munmap(map, sb.st_size);
+	close(fd);
+	return EXIT_SUCCESS;
+}
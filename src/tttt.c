@@ -0,0 +1,350 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	tttt.c
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	Implements the handle based libtttt interface.  A handle is
+//		nothing more than the board, the COMBOSET, and the STRATEGY
+//	that main.c's play_game() would otherwise keep on its stack, gathered
+//	together into one allocation.
+//
+//	Handles may also come from a TTTT_POOL.  A pool is one slab of memory,
+//	cut into cache line aligned blocks, one per game, together with a free
+//	list.  Acquiring and releasing a game are then both O(1).
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "tttt.h"
+#include "comboset.h"
+#include "strategy.h"
+#include "position.h"
+#include "movecache.h"
+
+// The size of a cache line.  Pool blocks are aligned to, and padded out to,
+// a multiple of this.
+#define	TTTT_CACHELINE	64
+
+struct	TTTT_S {
+	GBOARD		m_brd;
+	COMBOSET	m_cs;
+	STRATEGY	m_strategy;
+	// If this handle came from a pool, m_pool points to it, and m_nextfree
+	// links it into the pool's free list while unused.  m_inuse is set
+	// from its acquisition until its release, so that it can't be
+	// released twice.
+	LPTTTT_POOL	m_pool;
+	LPTTTT		m_nextfree;
+	bool		m_inuse;
+	// The cache of moves shared with other games, if any
+	LPMOVECACHE	m_cache;
+};
+
+struct	TTTT_POOL_S {
+	int	m_nblocks, m_nfree;
+	size_t	m_blocksize;
+	// m_alloc is what malloc() gave us, m_base the aligned slab within it
+	char	*m_alloc, *m_base;
+	LPTTTT	m_free;
+};
+
+LPTTTT	tttt_new(int difficulty, unsigned seed) {
+	LPTTTT	g;
+
+	g = (LPTTTT)malloc(sizeof(TTTT));
+	if (!g)
+		return NULL;
+
+	g->m_pool = NULL;
+	g->m_nextfree = NULL;
+	g->m_inuse = false;
+	g->m_cache = NULL;
+	set_difficulty(&g->m_strategy, difficulty);
+	set_seed(&g->m_strategy, seed);
+	tttt_reset(g);
+	return g;
+}
+
+void	tttt_free(LPTTTT g) {
+	if ((g)&&(g->m_pool))
+		tttt_pool_release(g->m_pool, g);
+	else
+		free(g);
+}
+
+LPTTTT	tttt_clone(LPTTTT g) {
+	LPTTTT	c;
+
+	if (!g)
+		return NULL;
+	c = (LPTTTT)malloc(sizeof(TTTT));
+	if (!c)
+		return NULL;
+
+	memcpy(c, g, sizeof(TTTT));
+	c->m_pool = NULL;
+	c->m_nextfree = NULL;
+	c->m_inuse = false;
+	vs_random(&g->m_strategy.m_seed);
+	return c;
+}
+
+void	tttt_reset(LPTTTT g) {
+	if (!g)
+		return;
+	gb_reset(&g->m_brd);
+	cs_init(&g->m_cs);
+}
+
+void	tttt_difficulty(LPTTTT g, int difficulty) {
+	if (g)
+		set_difficulty(&g->m_strategy, difficulty);
+}
+
+void	tttt_setcache(LPTTTT g, LPMOVECACHE mc) {
+	if (g)
+		g->m_cache = mc;
+}
+
+/*
+ * tttt_play
+ *
+ * This is the same sequence play_game() goes through in main.c: place the
+ * piece on the board, register it with the COMBOSET, and then check for a
+ * win.  The difference is that we also notice when the board fills up, and
+ * call that a tie.
+ */
+TTTT_RESULT	tttt_play(LPTTTT g, int where) {
+	GB_PIECE	who;
+
+	if (!g)
+		return TTTT_BADARG;
+
+	who = whoseturn(&g->m_brd);
+	if (who == GB_NOONE)
+		return TTTT_GAMEOVER;
+	if (!gb_place(&g->m_brd, who, where))
+		return TTTT_ILLEGAL;
+
+	if (cs_place(&g->m_cs, who, where)) {
+		g->m_brd.m_winner = who;
+		return TTTT_WIN;
+	} else if (g->m_brd.m_nfilled >= NUM_SQUARES) {
+		g->m_brd.m_winner = GB_TIE;
+		return TTTT_TIE;
+	}
+
+	return TTTT_OK;
+}
+
+TTTT_RESULT	tttt_askmove(LPTTTT g, int *where) {
+	return tttt_askmove_until(g, where, NULL, NULL);
+}
+
+TTTT_RESULT	tttt_askmove_until(LPTTTT g, int *where, TTTT_STOPFN stop,
+			void *arg) {
+	GB_PIECE	who;
+	VSET		spots;
+	bool		finished, cached;
+	int		mv;
+
+	if ((!g)||(!where))
+		return TTTT_BADARG;
+
+	who = whoseturn(&g->m_brd);
+	if (who == GB_NOONE)
+		return TTTT_GAMEOVER;
+
+	// A position found in the cache was chosen with every rule applied,
+	// so there's no need to check whether we've been told to stop
+	cached = false;
+#ifndef	TTTT_SMALL
+	cached = (g->m_cache)&&(mc_lookup(g->m_cache, &g->m_brd,
+			g->m_strategy.m_difficulty_level, &spots));
+#endif
+	if (cached)
+		finished = true;
+	else {
+		set_stop(&g->m_strategy, stop, arg);
+		finished = choosemoves(&g->m_strategy, &g->m_brd, &g->m_cs,
+				who, &spots);
+		set_stop(&g->m_strategy, NULL, NULL);
+#ifndef	TTTT_SMALL
+		if ((g->m_cache)&&(finished))
+			mc_store(g->m_cache, &g->m_brd,
+				g->m_strategy.m_difficulty_level, &spots);
+#endif
+	}
+
+	mv = vs_pickmember(&spots, &g->m_strategy.m_seed);
+	if (mv < 0)
+		return (finished) ? TTTT_GAMEOVER : TTTT_STOPPED;
+
+	*where = mv;
+	return TTTT_OK;
+}
+
+void	tttt_getposition(LPTTTT g, char *buf) {
+	if ((g)&&(buf))
+		pos_format(&g->m_brd, buf);
+}
+
+TTTT_RESULT	tttt_setposition(LPTTTT g, const char *str) {
+	GBOARD		brd;
+	COMBOSET	cs;
+
+	if ((!g)||(!str))
+		return TTTT_BADARG;
+	if (!pos_parse(str, &brd, &cs))
+		return TTTT_ILLEGAL;
+	g->m_brd = brd;
+	g->m_cs  = cs;
+	return TTTT_OK;
+}
+
+GB_PIECE	tttt_whoseturn(LPTTTT g) {
+	return (g) ? whoseturn(&g->m_brd) : GB_NOONE;
+}
+
+GB_PIECE	tttt_winner(LPTTTT g) {
+	return (g) ? gb_winner(&g->m_brd) : GB_NOONE;
+}
+
+GB_PIECE	tttt_pieceat(LPTTTT g, int where) {
+	return (g) ? pieceat(&g->m_brd, where) : GB_NOONE;
+}
+
+int	tttt_nfilled(LPTTTT g) {
+	return (g) ? g->m_brd.m_nfilled : 0;
+}
+
+int	tttt_score(LPTTTT g, GB_PIECE who) {
+	return (g) ? cs_score(&g->m_cs, who, NULL) : 0;
+}
+
+int	tttt_movegain(LPTTTT g, GB_PIECE who, int where) {
+	return (g) ? cs_movegain(&g->m_cs, who, where, NULL) : 0;
+}
+
+LPTTTT_POOL	tttt_pool_new(int ngames) {
+	LPTTTT_POOL	pool;
+	int		i;
+
+	if (ngames <= 0)
+		return NULL;
+
+	pool = (LPTTTT_POOL)malloc(sizeof(TTTT_POOL));
+	if (!pool)
+		return NULL;
+
+	pool->m_blocksize = (sizeof(TTTT) + TTTT_CACHELINE-1)
+				& ~(size_t)(TTTT_CACHELINE-1);
+	pool->m_alloc = (char *)malloc(pool->m_blocksize * ngames
+				+ TTTT_CACHELINE-1);
+	if (!pool->m_alloc) {
+		free(pool);
+		return NULL;
+	}
+	pool->m_base = (char *)(((uintptr_t)pool->m_alloc + TTTT_CACHELINE-1)
+				& ~(uintptr_t)(TTTT_CACHELINE-1));
+	pool->m_nblocks = ngames;
+	pool->m_nfree   = ngames;
+
+	// Build the free list, so that the first block is the first one given
+	// out
+	pool->m_free = NULL;
+	for(i=ngames-1; i>=0; i--) {
+		LPTTTT	g = (LPTTTT)(pool->m_base + i * pool->m_blocksize);
+
+		g->m_pool = pool;
+		g->m_nextfree = pool->m_free;
+		g->m_inuse = false;
+		pool->m_free = g;
+	}
+
+	return pool;
+}
+
+void	tttt_pool_free(LPTTTT_POOL pool) {
+	if (!pool)
+		return;
+	free(pool->m_alloc);
+	free(pool);
+}
+
+LPTTTT	tttt_pool_acquire(LPTTTT_POOL pool, int difficulty, unsigned seed) {
+	LPTTTT	g;
+
+	if ((!pool)||(!pool->m_free))
+		return NULL;
+
+	g = pool->m_free;
+	pool->m_free = g->m_nextfree;
+	pool->m_nfree--;
+	g->m_nextfree = NULL;
+	g->m_inuse = true;
+	g->m_cache = NULL;
+
+	set_difficulty(&g->m_strategy, difficulty);
+	set_seed(&g->m_strategy, seed);
+	tttt_reset(g);
+	return g;
+}
+
+void	tttt_pool_release(LPTTTT_POOL pool, LPTTTT g) {
+	// A game already released (perhaps once through tttt_free(), and again
+	// here) is already on the free list, and mustn't go on it twice
+	if ((!pool)||(!g)||(g->m_pool != pool)||(!g->m_inuse))
+		return;
+	g->m_inuse = false;
+	g->m_nextfree = pool->m_free;
+	pool->m_free = g;
+	pool->m_nfree++;
+}
+
+int	tttt_pool_available(LPTTTT_POOL pool) {
+	return (pool) ? pool->m_nfree : 0;
+}
+
+const char	*tttt_strerror(TTTT_RESULT r) {
+	switch(r) {
+	case TTTT_OK:		return "OK";
+	case TTTT_WIN:		return "Win";
+	case TTTT_TIE:		return "Tie";
+	case TTTT_ILLEGAL:	return "Illegal move";
+	case TTTT_GAMEOVER:	return "Game over";
+	case TTTT_BADARG:	return "Bad argument";
+	case TTTT_STOPPED:	return "Stopped";
+	}
+	return "Unknown result";
+}
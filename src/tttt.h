@@ -0,0 +1,214 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	tttt.h
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	The public interface to libtttt, the 4x4x4 Tic-Tac-Toe engine
+//		packaged as a library.  Each game is referenced through an
+//	opaque handle, holding its own board, its own COMBOSET, and its own
+//	STRATEGY (including its own random number state).  Nothing is shared
+//	between handles, so separate games may be played on separate threads
+//	at the same time without any locking.  (A single handle, however, may
+//	only be used by one thread at a time.)
+//
+//	None of these routines print anything.  Errors are returned as
+//	TTTT_RESULT codes instead.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#ifndef	TTTT_H
+#define	TTTT_H
+
+#include "gboard.h"
+#include "position.h"
+#include "movecache.h"
+
+// The game handle.  Its contents are private to tttt.c.
+typedef	struct	TTTT_S	TTTT, *LPTTTT;
+
+// A pool of game handles, also private to tttt.c
+typedef	struct	TTTT_POOL_S	TTTT_POOL, *LPTTTT_POOL;
+
+typedef	enum	TTTT_RESULT_E {
+	TTTT_OK = 0,	// The move was made, and the game goes on
+	TTTT_WIN,	// The move was made, and won the game
+	TTTT_TIE,	// The move was made, and filled the board with no winner
+	TTTT_ILLEGAL,	// That square is taken, or off the board
+	TTTT_GAMEOVER,	// The game is already over, no more moves may be made
+	TTTT_BADARG,	// A NULL handle or pointer was given to us
+	TTTT_STOPPED	// We were told to stop before any move was found
+} TTTT_RESULT;
+
+// A function checked every so often while the engine thinks, returning true
+// once it should stop thinking.
+typedef	bool	(*TTTT_STOPFN)(void *arg);
+
+/*
+ * tttt_new
+ *
+ * Allocate and initialize a new game, with the computer playing at the given
+ * difficulty level, and its random choices driven by seed.  Returns NULL if
+ * no memory is available.
+ */
+extern	LPTTTT	tttt_new(int difficulty, unsigned seed);
+
+/*
+ * tttt_free
+ *
+ * Release a game handle, and any memory associated with it.  Handles that
+ * came from a pool are returned to their pool.
+ */
+extern	void	tttt_free(LPTTTT g);
+
+/*
+ * tttt_clone
+ *
+ * Allocate a copy of a game, position, difficulty, and all.  The copy gets
+ * the original's random number state, and the original's is then stepped, so
+ * the two won't make the same random choices going forward.  The copy never
+ * belongs to a pool.  Returns NULL if no memory is available.
+ */
+extern	LPTTTT	tttt_clone(LPTTTT g);
+
+/*
+ * tttt_reset
+ *
+ * Start a new game on an existing handle.  The difficulty level, and the
+ * random number state, are kept.
+ */
+extern	void	tttt_reset(LPTTTT g);
+
+/*
+ * tttt_difficulty
+ *
+ * Adjust the difficulty level the computer plays at.  This may be done at
+ * any time, even in the middle of a game.
+ */
+extern	void	tttt_difficulty(LPTTTT g, int difficulty);
+
+/*
+ * tttt_setcache
+ *
+ * Have the game look its moves up in, and add the moves it chooses to, a
+ * cache it may share with any number of other games (see movecache.h).  The
+ * moves made are the same either way.  NULL stops using any cache.  Clones
+ * share their original's cache.  The small build has no cache, and ignores
+ * this.
+ */
+extern	void	tttt_setcache(LPTTTT g, LPMOVECACHE mc);
+
+/*
+ * tttt_play
+ *
+ * Place a piece, for whoever's turn it is, at where.
+ */
+extern	TTTT_RESULT	tttt_play(LPTTTT g, int where);
+
+/*
+ * tttt_askmove
+ *
+ * Ask the engine where it would move, were it the player whose turn it is.
+ * The answer is returned in *where.  The move is not made--call tttt_play()
+ * with the result for that.
+ */
+extern	TTTT_RESULT	tttt_askmove(LPTTTT g, int *where);
+
+/*
+ * tttt_askmove_until
+ *
+ * The same as tttt_askmove(), save that stop(arg) is checked between rules,
+ * and within the longer ones.  If it returns true, the engine quits thinking
+ * and answers with its best move so far.  The first rule is always applied,
+ * so TTTT_STOPPED is only returned when stopped before a legal move could be
+ * found at all.
+ */
+extern	TTTT_RESULT	tttt_askmove_until(LPTTTT g, int *where,
+				TTTT_STOPFN stop, void *arg);
+
+/*
+ * tttt_getposition, tttt_setposition
+ *
+ * Read or set the entire board at once, using the position strings of
+ * position.h.  tttt_getposition() needs room for POS_STRLEN+1 characters.
+ * tttt_setposition() returns TTTT_ILLEGAL, leaving the game as it was, if
+ * the string isn't a valid position.
+ */
+extern	void		tttt_getposition(LPTTTT g, char *buf);
+extern	TTTT_RESULT	tttt_setposition(LPTTTT g, const char *str);
+
+/*
+ * Queries about the state of the game
+ */
+extern	GB_PIECE	tttt_whoseturn(LPTTTT g);
+extern	GB_PIECE	tttt_winner(LPTTTT g);
+extern	GB_PIECE	tttt_pieceat(LPTTTT g, int where);
+extern	int		tttt_nfilled(LPTTTT g);
+
+/*
+ * Evaluation
+ *
+ * tttt_score() says how good the position looks for who, by the lines each
+ * player might still win with, and tttt_movegain() how much that would go up
+ * were who to move where.  Both are cheap enough to call at every node of a
+ * search.  (See cs_score() and cs_movegain() in comboset.h.)
+ */
+extern	int		tttt_score(LPTTTT g, GB_PIECE who);
+extern	int		tttt_movegain(LPTTTT g, GB_PIECE who, int where);
+
+/*
+ * Game pools
+ *
+ * A pool holds room for a fixed number of games in one slab of memory,
+ * cache line aligned, one game per block.  Acquiring a game from a pool, and
+ * releasing it (tttt_pool_release() or tttt_free()) back, are both O(1).
+ * tttt_pool_acquire() returns NULL once every game in the pool is in use.
+ * Releasing a game that isn't in use, such as one already released, does
+ * nothing.
+ *
+ * Unlike the games within it, a pool is not protected against simultaneous
+ * use by multiple threads.  Acquire and release from one thread only, or
+ * provide your own lock.
+ */
+extern	LPTTTT_POOL	tttt_pool_new(int ngames);
+extern	void		tttt_pool_free(LPTTTT_POOL pool);
+extern	LPTTTT		tttt_pool_acquire(LPTTTT_POOL pool, int difficulty,
+					unsigned seed);
+extern	void		tttt_pool_release(LPTTTT_POOL pool, LPTTTT g);
+extern	int		tttt_pool_available(LPTTTT_POOL pool);
+
+/*
+ * tttt_strerror
+ *
+ * Return a (constant) string describing a result code.
+ */
+extern	const char	*tttt_strerror(TTTT_RESULT r);
+
+#endif
@@ -0,0 +1,511 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	tune.c
+//
+// Project:	tttt, a simple 4x4x4 Tic-Tac-Toe Program
+//
+// Purpose:	tttt-tune: tunes the strategy by playing it against itself.  The
+//		order of the rules, which of them are used at all, and the
+//	line weights used by the GAIN rule are all treated as parameters, and
+//	adjusted by SPSA (simultaneous perturbation stochastic approximation).
+//
+//	Every rule save ANY, which always comes first, gets a priority.  Rules
+//	with a priority above zero are used, highest priority first.  The
+//	weights are tuned as their base two logarithms.  Each iteration, every
+//	parameter is nudged at random either up or down, giving two players:
+//	one nudged the one way, and one the other.  These two play a match,
+//	each pair of games played from the same seed with the colors switched,
+//	and every parameter then moves toward whichever player did better.
+//	With -l, a player's result is charged for the CPU time it took, so
+//	that the tuner prefers strength per millisecond over strength alone.
+//
+//	With -k, progress is saved to a checkpoint file after every iteration,
+//	and picked back up from it if it's there when we start.  Since every
+//	game's seed and every nudge comes from the tuner's seed and the
+//	iteration number, a run that's been stopped and restarted ends up where
+//	it would have otherwise.  (This isn't so with -l, since CPU times vary.)
+//
+//	At the end, the tuned player is played against the difficulty level it
+//	started from, to see what's been gained.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2017, Gisselquist Technology, LLC
+//
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of  the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+//
+// License:	GPL, v3, as defined and found on www.gnu.org,
+//		http://www.gnu.org/licenses/gpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+#define	_POSIX_C_SOURCE	200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include "gboard.h"
+#include "comboset.h"
+#include "strategy.h"
+
+// The most parameters we'll tune: one per rule, plus the weights
+#define	TN_MAXPARAMS	(MAX_RULES + NUM_ON_SIDE)
+#define	TN_MAXLINE	256
+
+// How the players in a match are set up: either by difficulty, or (when
+// m_difficulty < 0) by an explicit list of rules and weights
+typedef	struct	PLAYER_S {
+	int		m_difficulty, m_nrules;
+	const RULE	*m_rules[MAX_RULES];
+	int		m_weights[NUM_ON_SIDE+1];
+} PLAYER, *LPPLAYER;
+
+typedef	struct	TUNER_S {
+	// The parameters: the rules being tuned (all but ANY), their names,
+	// and how far to nudge each one
+	int		m_nrules, m_nparams;
+	const RULE	*m_any, *m_rule[MAX_RULES];
+	char		m_name[TN_MAXPARAMS][32];
+	double		m_theta[TN_MAXPARAMS], m_scale[TN_MAXPARAMS];
+
+	// The match being played: games are played by pairs, from seeds
+	// m_seed, m_seed+1, ..., the first of each pair with m_player[0] as
+	// black, the second as white
+	PLAYER		m_player[2];
+	unsigned	m_seed;
+	unsigned long	m_ngames;
+	// The next game to be played, and the results so far, protected by
+	// m_lock: points won, CPU seconds used, and moves made by each player
+	unsigned long	m_next;
+	double		m_points[2], m_cpu[2];
+	unsigned long	m_moves[2];
+	pthread_mutex_t	m_lock;
+} TUNER, *LPTUNER;
+
+static double
+cputime(void) {
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * mkplayer
+ *
+ * Turn a set of parameters into a player: ANY first, then every rule with a
+ * priority above zero, highest first, and then the weights.
+ */
+static void
+mkplayer(LPTUNER t, const double *theta, LPPLAYER p) {
+	int	i, j, order[MAX_RULES], n = 0;
+
+	for(i=0; i<t->m_nrules; i++) {
+		if (theta[i] <= 0)
+			continue;
+		// Insertion sort, keeping the usual order among ties
+		for(j=n; (j>0)&&(theta[order[j-1]] < theta[i]); j--)
+			order[j] = order[j-1];
+		order[j] = i;
+		n++;
+	}
+
+	p->m_difficulty = -1;
+	p->m_nrules = 0;
+	p->m_rules[p->m_nrules++] = t->m_any;
+	for(i=0; (i<n)&&(p->m_nrules < MAX_RULES); i++)
+		p->m_rules[p->m_nrules++] = t->m_rule[order[i]];
+
+	p->m_weights[0] = 0;
+	for(i=1; i<=NUM_ON_SIDE; i++)
+		p->m_weights[i] = (int)lround(pow(2.0, theta[t->m_nrules+i-1]));
+}
+
+static void
+setplayer(LPSTRATEGY s, LPPLAYER p, unsigned seed) {
+	if (p->m_difficulty >= 0)
+		set_difficulty(s, p->m_difficulty);
+	else {
+		set_rules(s, p->m_rules, p->m_nrules);
+		set_weights(s, p->m_weights);
+	}
+	set_seed(s, seed);
+}
+
+/*
+ * playgame
+ *
+ * Play one game of the match, returning the points won by m_player[0], and
+ * adding the time spent and moves made by each player to cpu[] and moves[].
+ */
+static double
+playgame(LPTUNER t, unsigned long gameno, double *cpu, unsigned long *moves) {
+	STRATEGY	s[2];
+	GBOARD		brd;
+	COMBOSET	cs;
+	GB_PIECE	who;
+	unsigned	seed = t->m_seed + (unsigned)(gameno/2);
+	// Which of our players plays black
+	int		b = (gameno & 1), p, mv;
+	double		start;
+
+	setplayer(&s[0], &t->m_player[b], seed);
+	setplayer(&s[1], &t->m_player[b^1], ~seed);
+	gb_reset(&brd);
+	cs_init(&cs);
+
+	while(GB_NOONE != (who = whoseturn(&brd))) {
+		// s[0] plays black, and is our player b
+		p = (who == GB_BLACK) ? b : b^1;
+		start = cputime();
+		mv = makemove(&s[(who == GB_BLACK) ? 0 : 1], &brd, &cs, who);
+		cpu[p] += cputime() - start;
+		moves[p]++;
+
+		if ((mv < 0)||(!gb_place(&brd, who, mv))) {
+			brd.m_winner = GB_TIE;
+			break;
+		}
+
+		if (cs_place(&cs, who, mv))
+			brd.m_winner = who;
+		else if (brd.m_nfilled >= NUM_SQUARES)
+			brd.m_winner = GB_TIE;
+	}
+
+	if (brd.m_winner == GB_TIE)
+		return 0.5;
+	return (brd.m_winner == ((b == 0) ? GB_BLACK : GB_WHITE)) ? 1.0 : 0.0;
+}
+
+static void *
+match_thread(void *arg) {
+	LPTUNER		t = (LPTUNER)arg;
+	unsigned long	k, moves[2] = { 0, 0 };
+	double		points = 0, cpu[2] = { 0, 0 };
+
+	for(;;) {
+		pthread_mutex_lock(&t->m_lock);
+		k = t->m_next++;
+		pthread_mutex_unlock(&t->m_lock);
+
+		if (k >= t->m_ngames)
+			break;
+		points += playgame(t, k, cpu, moves);
+	}
+
+	pthread_mutex_lock(&t->m_lock);
+	t->m_points[0] += points;
+	for(k=0; k<2; k++) {
+		t->m_cpu[k]   += cpu[k];
+		t->m_moves[k] += moves[k];
+	}
+	pthread_mutex_unlock(&t->m_lock);
+
+	return NULL;
+}
+
+/*
+ * match
+ *
+ * Play the two players of the tuner against each other, ngames times over.
+ */
+static void
+match(LPTUNER t, unsigned seed, unsigned long ngames, pthread_t *threads,
+		int nthreads) {
+	int	i;
+
+	t->m_seed   = seed;
+	t->m_ngames = ngames;
+	t->m_next   = 0;
+	for(i=0; i<2; i++) {
+		t->m_points[i] = t->m_cpu[i] = 0;
+		t->m_moves[i]  = 0;
+	}
+
+	for(i=0; i<nthreads; i++)
+		pthread_create(&threads[i], NULL, match_thread, t);
+	for(i=0; i<nthreads; i++)
+		pthread_join(threads[i], NULL);
+
+	t->m_points[1] = ngames - t->m_points[0];
+}
+
+/*
+ * msecs
+ *
+ * The average CPU time player p spent per move in the last match.
+ */
+static double
+msecs(LPTUNER t, int p) {
+	return (t->m_moves[p]) ? 1e3 * t->m_cpu[p] / t->m_moves[p] : 0;
+}
+
+/*
+ * findparam
+ *
+ * Look a parameter up by name, returning -1 if it isn't found.
+ */
+static int
+findparam(LPTUNER t, const char *name) {
+	int	i;
+
+	for(i=0; i<t->m_nparams; i++)
+		if (strcmp(t->m_name[i], name)==0)
+			return i;
+	return -1;
+}
+
+/*
+ * checkpoint
+ *
+ * Save our progress, writing to a temporary file first so that the last
+ * checkpoint survives should we be stopped part way through writing.
+ */
+static void
+checkpoint(LPTUNER t, const char *fname, int iteration, unsigned seed) {
+	char	tmpname[TN_MAXLINE];
+	FILE	*fp;
+	int	i;
+
+	snprintf(tmpname, sizeof(tmpname), "%s.tmp", fname);
+	if (NULL == (fp = fopen(tmpname, "w"))) {
+		perror("O/S Err: Cannot write checkpoint");
+		exit(EXIT_FAILURE);
+	}
+
+	fprintf(fp, "# tttt-tune checkpoint\n");
+	fprintf(fp, "iteration %d\n", iteration);
+	fprintf(fp, "seed %u\n", seed);
+	for(i=0; i<t->m_nparams; i++)
+		fprintf(fp, "%s %.17g\n", t->m_name[i], t->m_theta[i]);
+
+	if ((fclose(fp) != 0)||(rename(tmpname, fname) != 0)) {
+		perror("O/S Err: Cannot write checkpoint");
+		exit(EXIT_FAILURE);
+	}
+}
+
+/*
+ * restore
+ *
+ * Pick up from a checkpoint, if there is one, returning the iteration to
+ * start from.  Parameters are found by name, so a checkpoint still works
+ * after a rule has been added.
+ */
+static int
+restore(LPTUNER t, const char *fname, unsigned *seed) {
+	char	line[TN_MAXLINE], name[TN_MAXLINE];
+	double	value;
+	int	iteration = 0, i;
+	FILE	*fp;
+
+	if (NULL == (fp = fopen(fname, "r")))
+		return 0;
+
+	while(fgets(line, sizeof(line), fp)) {
+		if (line[0] == '#')
+			continue;
+		if (sscanf(line, "%255s %lf", name, &value) != 2)
+			continue;
+		if (strcmp(name, "iteration")==0)
+			iteration = (int)value;
+		else if (strcmp(name, "seed")==0)
+			*seed = (unsigned)value;
+		else if ((i = findparam(t, name)) >= 0)
+			t->m_theta[i] = value;
+		else
+			fprintf(stderr, "WARNING: Unknown parameter, %s, in %s\n",
+				name, fname);
+	}
+	fclose(fp);
+
+	return iteration;
+}
+
+static void
+usage(void) {
+	fprintf(stderr,
+"USAGE: tttt-tune [-n <iterations>] [-g <games>] [-d <level>] [-s <seed>]\n"
+"\t\t[-j <nthreads>] [-k <checkpoint>] [-a <step>] [-c <nudge>]\n"
+"\t\t[-l <lambda>] [-v <games>]\n"
+"\n"
+"\t-n <iterations>\tThe number of iterations to run, defaults to 100\n"
+"\t-g <games>\tThe games to play per iteration, defaults to 2000\n"
+"\t-d <level>\tThe difficulty level to start from, and to measure\n"
+"\t\tthe result against, defaults to 1000\n"
+"\t-s <seed>\tThe seed of the first game.  Defaults to the time\n"
+"\t-j <nthreads>\tThe number of threads to play with, defaults to the\n"
+"\t\tnumber of CPUs\n"
+"\t-k <file>\tSave progress to, and restore it from, <file>\n"
+"\t-a <step>\tHow far to move the parameters, defaults to 10\n"
+"\t-c <nudge>\tHow far to nudge the parameters, defaults to 1\n"
+"\t-l <lambda>\tPoints to charge per CPU millisecond per move,\n"
+"\t\tdefaults to 0\n"
+"\t-v <games>\tThe games to play against the starting level at the\n"
+"\t\tend, defaults to the games per iteration\n");
+}
+
+int	main(int argc, char **argv) {
+	TUNER		t;
+	int		niterations = 100, difficulty = 1000, nthreads = 0,
+			opt, first, k, i, n;
+	unsigned long	ngames = 2000, nvalidate = 0;
+	unsigned	seed = (unsigned)time(NULL);
+	double		a = 10, c = 1, lambda = 0, A;
+	const char	*ckfile = NULL;
+	const RULE	*rp;
+	pthread_t	*threads;
+	STRATEGY	stock;
+
+	while((opt = getopt(argc, argv, "a:c:d:g:hj:k:l:n:s:v:")) != -1) {
+		switch(opt) {
+		case 'a': a = atof(optarg); break;
+		case 'c': c = atof(optarg); break;
+		case 'd': difficulty = atoi(optarg); break;
+		case 'g': ngames = strtoul(optarg, NULL, 0); break;
+		case 'j': nthreads = atoi(optarg); break;
+		case 'k': ckfile = optarg; break;
+		case 'l': lambda = atof(optarg); break;
+		case 'n': niterations = atoi(optarg); break;
+		case 's': seed = strtoul(optarg, NULL, 0); break;
+		case 'v': nvalidate = strtoul(optarg, NULL, 0); break;
+		default:
+			usage();
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (nthreads <= 0)
+		nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (nthreads <= 0)
+		nthreads = 1;
+	// Games are played in pairs
+	ngames = (ngames + 1) & -2ul;
+	if (nvalidate == 0)
+		nvalidate = ngames;
+	nvalidate = (nvalidate + 1) & -2ul;
+
+	threads = (pthread_t *)malloc(nthreads * sizeof(pthread_t));
+	if (!threads) {
+		fprintf(stderr, "ERR: Out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+	pthread_mutex_init(&t.m_lock, NULL);
+
+	// Our starting point: the rules used at the difficulty we start from,
+	// in their usual order, and the usual weights
+	set_difficulty(&stock, difficulty);
+	t.m_any = get_rule(0);
+	t.m_nrules = 0;
+	for(k=1; (rp = get_rule(k)) != NULL; k++) {
+		if (t.m_nrules >= MAX_RULES)
+			break;
+		t.m_rule[t.m_nrules] = rp;
+		snprintf(t.m_name[t.m_nrules], sizeof(t.m_name[0]), "%s",
+			rp->m_name);
+		t.m_theta[t.m_nrules] = -1;
+		t.m_scale[t.m_nrules] = 1;
+		for(i=1; i<stock.m_num_rules; i++)
+			if (stock.m_rules[i] == rp)
+				t.m_theta[t.m_nrules] = stock.m_num_rules - i;
+		t.m_nrules++;
+	}
+	t.m_nparams = t.m_nrules;
+	for(i=1; i<=NUM_ON_SIDE; i++) {
+		snprintf(t.m_name[t.m_nparams], sizeof(t.m_name[0]),
+			"WEIGHT-%d", i);
+		t.m_theta[t.m_nparams] = log2(cs_weight[i]);
+		t.m_scale[t.m_nparams] = 0.5;
+		t.m_nparams++;
+	}
+
+	first = (ckfile) ? restore(&t, ckfile, &seed) : 0;
+	if (first > 0)
+		printf("Restarting from iteration %d of %s\n", first, ckfile);
+
+	// The usual SPSA gain schedules.  A, which keeps the first few steps
+	// from being too large, is fixed rather than set from the number of
+	// iterations, so that a run may be continued for longer than first
+	// planned without changing the steps it's already taken.
+	A = 10;
+	for(k=first; k<niterations; k++) {
+		double		ak = a / pow(k + 1 + A, 0.602),
+				ck = c / pow(k + 1, 0.101),
+				plus[TN_MAXPARAMS], minus[TN_MAXPARAMS],
+				delta[TN_MAXPARAMS], y[2];
+		unsigned	r = seed ^ ((unsigned)k * 2654435761u);
+
+		for(i=0; i<t.m_nparams; i++) {
+			delta[i] = (vs_random(&r) & 1) ? 1 : -1;
+			plus[i]  = t.m_theta[i] + ck * t.m_scale[i] * delta[i];
+			minus[i] = t.m_theta[i] - ck * t.m_scale[i] * delta[i];
+		}
+		mkplayer(&t, plus,  &t.m_player[0]);
+		mkplayer(&t, minus, &t.m_player[1]);
+
+		match(&t, seed + (unsigned)(k * (ngames/2)), ngames,
+			threads, nthreads);
+		for(i=0; i<2; i++)
+			y[i] = t.m_points[i] / ngames - lambda * msecs(&t, i);
+
+		for(i=0; i<t.m_nparams; i++)
+			t.m_theta[i] += ak * t.m_scale[i] * (y[0] - y[1])
+					/ (2 * ck * delta[i]);
+
+		printf("Iteration %4d: %5.1f%% to %5.1f%%, %.4f to %.4f ms/move\n",
+			k+1, 100.0 * t.m_points[0] / ngames,
+			100.0 * t.m_points[1] / ngames,
+			msecs(&t, 0), msecs(&t, 1));
+		fflush(stdout);
+
+		if (ckfile)
+			checkpoint(&t, ckfile, k+1, seed);
+	}
+
+	// Where we've ended up
+	mkplayer(&t, t.m_theta, &t.m_player[0]);
+	printf("Rules:  ");
+	for(i=0; i<t.m_player[0].m_nrules; i++)
+		printf(" %s", t.m_player[0].m_rules[i]->m_name);
+	printf("\nWeights:");
+	for(i=0; i<=NUM_ON_SIDE; i++)
+		printf(" %d", t.m_player[0].m_weights[i]);
+	printf("\nParameters:\n");
+	for(i=0; i<t.m_nparams; i++)
+		printf("\t%-12s %8.3f\n", t.m_name[i], t.m_theta[i]);
+
+	// And how that compares to where we started
+	t.m_player[1].m_difficulty = difficulty;
+	match(&t, seed + (unsigned)(niterations * (ngames/2)), nvalidate,
+		threads, nthreads);
+	n = (int)nvalidate;
+	printf("Against level %d: %5.1f%% to %5.1f%% over %d games, "
+		"%.4f to %.4f ms/move\n", difficulty,
+		100.0 * t.m_points[0] / n, 100.0 * t.m_points[1] / n, n,
+		msecs(&t, 0), msecs(&t, 1));
+
+	free(threads);
+	return EXIT_SUCCESS;
+}
@@ -43,9 +43,7 @@
 //
 //
 #include <stdlib.h>
-#include <stdio.h>
 #include <string.h>
-#include <assert.h>
 #include "bool.h"
 #include "gboard.h"
 #include "vset.h"
@@ -73,7 +71,10 @@ void	vs_addscore(LPVSET vs, int spot, int delta) {
 		return;
 	if (vs->m_data[spot] == 0)
 		vs->m_active++;
-	vs->m_data[spot] += delta;
+	if (delta > VS_MAXSCORE - vs->m_data[spot])
+		vs->m_data[spot] = VS_MAXSCORE;
+	else
+		vs->m_data[spot] += delta;
 }
 
 void	vs_incscore(LPVSET vs, int spot) {
@@ -105,10 +106,32 @@ void	vs_disable(LPVSET vs, int spot) {
 	vs->m_data[spot] = 0;
 }
 
-int	vs_pickmember(LPVSET vs) {
+/*
+ * vs_random
+ *
+ * Our own (tiny) pseudo-random number generator.  Unlike rand(), all of its
+ * state lives in the seed the caller hands us, so two games (or two threads)
+ * never disturb each others sequence.  This is the same linear congruential
+ * generator many C libraries use for rand_r(), returning 15-bits at a time.
+ */
+unsigned	vs_random(unsigned *seed) {
+	*seed = *seed * 1103515245u + 12345u;
+	return (*seed >> 16) & 0x7fff;
+}
+
+/*
+ * vs_pickmember
+ *
+ * Pick, at random, one of the highest scoring members of the set.  The
+ * random number generator state is given by seed.  Returns -1 if the set
+ * is empty.
+ */
+int	vs_pickmember(LPVSET vs, unsigned *seed) {
 	int	highscore, cnt, chosen, i;
 
-assert(vs->m_active > 0);
+	if (vs->m_active <= 0)
+		return -1;
+
 	// Find the high score, or equivalently the most valuable move
 	highscore = vs->m_data[0];
 	for(i=0; i<NUM_SQUARES; i++)
@@ -120,8 +143,9 @@ assert(vs->m_active > 0);
 			vs_disable(vs, i);
 
 	// Pick from among the moves remaining
-assert(vs->m_active > 0);
-	chosen = rand() % vs->m_active;
+	if (vs->m_active <= 0)
+		return -1;
+	chosen = vs_random(seed) % vs->m_active;
 	cnt = 0;
 
 	for(i=0; i<NUM_SQUARES; i++)
@@ -134,9 +158,12 @@ assert(vs->m_active > 0);
 }
 
 void	vs_add(LPVSET vs,LPVSET other) {
-	for(int i=0; i<NUM_SQUARES; i++)
-		vs->m_data[i] += other->m_data[i];
-	vs->m_active = vs_numactive(vs);
+	for(int i=0; i<NUM_SQUARES; i++) {
+		if (other->m_data[i] > VS_MAXSCORE - vs->m_data[i])
+			vs->m_data[i] = VS_MAXSCORE;
+		else
+			vs->m_data[i] += other->m_data[i];
+	} vs->m_active = vs_numactive(vs);
 }
 
 void	vs_sub(LPVSET vs, LPVSET other) {
@@ -177,6 +204,76 @@ void	vs_combine(LPVSET vs, LPVSET other) {
 		vs_set(vs, &test);
 }
 
+/*
+ * vs_best
+ *
+ * Find the highest scoring members of the set--the only ones vs_combine() will
+ * keep, and the only ones vs_pickmember() will choose from.  They're placed
+ * into best, and their number returned.
+ */
+int	vs_best(LPVSET vs, LPSQSET best) {
+	int	highscore = 1, cnt = 0, i;
+
+	ss_clear(best);
+	for(i=0; i<NUM_SQUARES; i++) {
+		if (vs->m_data[i] < highscore)
+			continue;
+		if (vs->m_data[i] > highscore) {
+			// A new high score: forget everything before it
+			highscore = vs->m_data[i];
+			ss_clear(best);
+			cnt = 0;
+		}
+		best->m_bits[i>>5] |= 1u << (i & 31);
+		cnt++;
+	} return cnt;
+}
+
+/*
+ * vs_narrow
+ *
+ * vs_combine(), for a caller who already has vs's nbest highest scoring
+ * members in best (from vs_best()).  Only other's scores for those squares
+ * matter.  On return, best holds the highest scoring members of the result,
+ * and their number is returned.
+ */
+int	vs_narrow(LPVSET vs, LPVSET other, LPSQSET best, int nbest) {
+	VSET		test;
+	SQSET		top;
+	unsigned	bits;
+	int		highscore = 1, cnt = 0, w, i;
+
+	if ((other->m_active <= 0)||(other->m_active >= NUM_SQUARES))
+		return nbest;
+
+	vs_clear(&test);
+	ss_clear(&top);
+	for(w=0; w<SS_WORDS; w++) {
+		for(i=w*32, bits = best->m_bits[w]; bits; i++, bits >>= 1) {
+			if ((!(bits & 1))||(other->m_data[i] == 0))
+				continue;
+			test.m_data[i] = other->m_data[i];
+			test.m_active++;
+
+			if (test.m_data[i] < highscore)
+				continue;
+			if (test.m_data[i] > highscore) {
+				highscore = test.m_data[i];
+				ss_clear(&top);
+				cnt = 0;
+			}
+			top.m_bits[w] |= 1u << (i & 31);
+			cnt++;
+		}
+	}
+
+	if (test.m_active <= 0)
+		return nbest;
+	vs_set(vs, &test);
+	*best = top;
+	return cnt;
+}
+
 int	vs_numactive(LPVSET vs) {
 	int	cnt = 0, i;
 
@@ -186,29 +283,29 @@ int	vs_numactive(LPVSET vs) {
 	return cnt;
 }
 
-void	vs_debug(LPVSET vs) {
-	int	x, y, z, loc;
-
-	printf("VSET: NUMBER ACTIVE = %d\n", vs->m_active);
-
-	for(y=0; y<NUM_ON_SIDE; y++) {
-		for(z=0; z<NUM_ON_SIDE; z++) {
-			for(x=0; x<NUM_ON_SIDE; x++) {
-				int	data;
-				loc = coordtoint(x, y, z);
-				data = vs->m_data[loc];
+/*
+ * ss_clear, ss_add, ss_ismember, ss_and
+ *
+ * The square sets: empty one, add a square to one, check whether a square is
+ * in one, and intersect one with another (leaving the result in the first).
+ */
+void	ss_clear(LPSQSET ss) {
+	memset(ss, 0, sizeof(SQSET));
+}
 
-				if (data <= 0)
-					printf("-");
-				else if (data <= 9)
-					printf("%d", data);
-				else
-					printf("*");
-			}
+void	ss_add(LPSQSET ss, int spot) {
+	if ((spot < 0)||(spot >= NUM_SQUARES))
+		return;
+	ss->m_bits[spot>>5] |= 1u << (spot & 31);
+}
 
-			printf("  ");
-		}
-		printf("\n");
-	} printf("\n");
+bool	ss_ismember(LPSQSET ss, int spot) {
+	if ((spot < 0)||(spot >= NUM_SQUARES))
+		return false;
+	return ((ss->m_bits[spot>>5] >> (spot & 31))&1) ? true : false;
 }
 
+void	ss_and(LPSQSET ss, LPSQSET other) {
+	for(int i=0; i<SS_WORDS; i++)
+		ss->m_bits[i] &= other->m_bits[i];
+}
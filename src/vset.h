@@ -42,11 +42,31 @@
 #ifndef	VSET_H
 #define	VSET_H
 
+#include <limits.h>
+
+// Scores are kept in a byte in the small build.  Rather than wrap, they stop
+// at VS_MAXSCORE.  On the classic board no rule can get there: the worst,
+// killn(), can score a square no higher than 7*25 = 175.
+#ifdef	TTTT_SMALL
+typedef	unsigned char	VS_SCORE;
+#define	VS_MAXSCORE	255
+#else
+typedef	int		VS_SCORE;
+#define	VS_MAXSCORE	INT_MAX
+#endif
+
 typedef	struct	VSET_S {
-	int	m_active;
-	int	m_data[NUM_SQUARES];
+	int		m_active;
+	VS_SCORE	m_data[NUM_SQUARES];
 } VSET, *LPVSET;
 
+// A plain set of squares, one bit per square, for when all that matters is
+// whether or not a square is a member--not its score.
+#define	SS_WORDS	((NUM_SQUARES+31)/32)
+typedef	struct	SQSET_S {
+	unsigned	m_bits[SS_WORDS];
+} SQSET, *LPSQSET;
+
 extern	void	vs_clear(LPVSET);
 extern	void	vs_set(LPVSET dst, LPVSET src);
 extern	bool	vs_isempty(LPVSET);
@@ -56,13 +76,22 @@ extern	bool	vs_isable(LPVSET, int);
 extern	void	vs_addscore(LPVSET, int, int);
 extern	void	vs_subscore(LPVSET, int, int);
 extern	void	vs_disable(LPVSET, int);
-extern	int	vs_pickmember(LPVSET);
+extern	unsigned vs_random(unsigned *seed);
+extern	int	vs_pickmember(LPVSET, unsigned *seed);
 extern	void	vs_add(LPVSET,LPVSET);
 extern	void	vs_sub(LPVSET,LPVSET);
 extern	void	vs_combine(LPVSET,LPVSET);
 extern	int	vs_numactive(LPVSET);
 
-// Dump something interesting to the screen
+extern	int	vs_best(LPVSET, LPSQSET best);
+extern	int	vs_narrow(LPVSET, LPVSET other, LPSQSET best, int nbest);
+
+extern	void	ss_clear(LPSQSET);
+extern	void	ss_add(LPSQSET, int);
+extern	bool	ss_ismember(LPSQSET, int);
+extern	void	ss_and(LPSQSET, LPSQSET);
+
+// Dump something interesting to the screen (found in display.c)
 extern	void	vs_debug(LPVSET);
 
 #endif